@@ -10,7 +10,11 @@
         "   mat4 model;",
         "   mat4 normalModel;",
         "   vec4 color;",
-        "   vec4 padding[7];",
+        "   uvec2 cpuOffset;",
+        "   uint jointOffset;",
+        "   uint jointPadding;",
+        "   vec4 uvTransform;",
+        "   vec4 padding[5];",
         "};",
         "layout(binding=2) uniform _system { ValueSystem values; } system;",
         "layout(binding=3) uniform PROJ {",
@@ -28,18 +32,54 @@
     },
     {
       "code": [
-        "$next_in vec2 inuv;"
+        "#define UV 1",
+        "$next_in vec2 inuv;",
+        "layout(location=0) out vec2 UVOUT;"
       ],
       "dependsOn": [ "UV" ]
     },
+    {
+      "code": [
+        "#define INSTANCED 1",
+        "layout(binding=4) readonly buffer _instanceValues { ValueSystem values[]; } instanceValues;",
+        "layout(binding=5) readonly buffer _instances { uint index[]; } instances;"
+      ],
+      "dependsOn": [ "INSTANCED" ]
+    },
+    {
+      "code": [
+        "#define SKINNED 1",
+        "$next_in vec4 injoints;",
+        "$next_in vec4 inweights;",
+        "layout(binding=6) readonly buffer _joints { mat4 matrices[]; } joints;"
+      ],
+      "dependsOn": [ "SKINNED" ]
+    },
     {
       "code": [
         "out gl_PerVertex {",
         "   vec4 gl_Position;",
         "};",
         "void main() {",
-        "   vec4 POSITIONOUT = system.values.model * vec4(inpos, 1);",
+        "#ifdef INSTANCED",
+        "   const ValueSystem values = instanceValues.values[instances.index[gl_InstanceIndex]];",
+        "#else",
+        "   const ValueSystem values = system.values;",
+        "#endif",
+        "#ifdef SKINNED",
+        "   const uvec4 jointIndex = uvec4(injoints) + values.jointOffset;",
+        "   const mat4 skin = inweights.x * joints.matrices[jointIndex.x] +",
+        "      inweights.y * joints.matrices[jointIndex.y] +",
+        "      inweights.z * joints.matrices[jointIndex.z] +",
+        "      inweights.w * joints.matrices[jointIndex.w];",
+        "   vec4 POSITIONOUT = skin * vec4(inpos, 1);",
+        "#else",
+        "   vec4 POSITIONOUT = values.model * vec4(inpos, 1);",
+        "#endif",
         "   gl_Position = proj.proj * POSITIONOUT;",
+        "#ifdef UV",
+        "   UVOUT = inuv * values.uvTransform.xy + values.uvTransform.zw;",
+        "#endif",
         "}"
       ]
     }
@@ -1,9 +1,22 @@
 #include "../public/Util.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <string>
 
+#ifdef COMPILED_IN_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#undef min
+#undef max
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace tge::util {
 
 bool exitRequest = false;
@@ -12,12 +25,17 @@ std::vector<char> wholeFile(const fs::path& path) {
   std::ifstream inputstream(path,
                             std::ios::ate | std::ios::in | std::ios::binary);
   if (!inputstream) {
-    std::string search = path.generic_string();
+    const std::string original = path.generic_string();
+    std::string search = original;
     std::transform(search.begin(), search.end(), search.begin(),
                    [](unsigned char c) {
                      if (c == '\\') return '/';
                      return (char)std::tolower(c);
                    });
+    if (search == original) {
+      PLOG_VERBOSE << "Error couldn't find file: " << path << "!";
+      return std::vector<char>();
+    }
     inputstream =
         std::ifstream(search, std::ios::ate | std::ios::in | std::ios::binary);
     if (!inputstream) {
@@ -33,6 +51,170 @@ std::vector<char> wholeFile(const fs::path& path) {
   return fileData;
 }
 
+MappedFile::MappedFile(const fs::path& path) {
+#ifdef COMPILED_IN_WINDOWS
+  const HANDLE file =
+      CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    PLOG_VERBOSE << "Error couldn't map file: " << path << "!";
+    return;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return;
+  }
+  const HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return;
+  }
+  const auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return;
+  }
+  fileHandle = file;
+  mappingHandle = mapping;
+  mappedData = (const char*)view;
+  mappedSize = (size_t)size.QuadPart;
+#else
+  const int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    PLOG_VERBOSE << "Error couldn't map file: " << path << "!";
+    return;
+  }
+  struct stat status;
+  if (fstat(file, &status) != 0 || status.st_size == 0) {
+    close(file);
+    return;
+  }
+  const auto view =
+      mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file);
+  if (view == MAP_FAILED) return;
+  madvise(view, (size_t)status.st_size, MADV_SEQUENTIAL);
+  mappedData = (const char*)view;
+  mappedSize = (size_t)status.st_size;
+#endif
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this == &other) return *this;
+  release();
+  std::swap(mappedData, other.mappedData);
+  std::swap(mappedSize, other.mappedSize);
+#ifdef COMPILED_IN_WINDOWS
+  std::swap(fileHandle, other.fileHandle);
+  std::swap(mappingHandle, other.mappingHandle);
+#endif
+  return *this;
+}
+
+void MappedFile::release() {
+  if (mappedData == nullptr) return;
+#ifdef COMPILED_IN_WINDOWS
+  UnmapViewOfFile(mappedData);
+  CloseHandle(mappingHandle);
+  CloseHandle(fileHandle);
+  fileHandle = nullptr;
+  mappingHandle = nullptr;
+#else
+  munmap((void*)mappedData, mappedSize);
+#endif
+  mappedData = nullptr;
+  mappedSize = 0;
+}
+
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl64(const uint64_t x, const int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t read64(const uint8_t* ptr) {
+  uint64_t value;
+  std::memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+inline uint32_t read32(const uint8_t* ptr) {
+  uint32_t value;
+  std::memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+inline uint64_t round64(uint64_t acc, const uint64_t input) {
+  acc += input * PRIME64_2;
+  acc = rotl64(acc, 31);
+  return acc * PRIME64_1;
+}
+
+inline uint64_t mergeRound64(uint64_t acc, const uint64_t value) {
+  acc ^= round64(0, value);
+  return acc * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t hash64(const void* data, const size_t size, const uint64_t seed) {
+  const uint8_t* ptr = (const uint8_t*)data;
+  const uint8_t* const end = ptr + size;
+  uint64_t hash;
+
+  if (size >= 32) {
+    const uint8_t* const limit = end - 32;
+    uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+    uint64_t v2 = seed + PRIME64_2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - PRIME64_1;
+    do {
+      v1 = round64(v1, read64(ptr));
+      v2 = round64(v2, read64(ptr + 8));
+      v3 = round64(v3, read64(ptr + 16));
+      v4 = round64(v4, read64(ptr + 24));
+      ptr += 32;
+    } while (ptr <= limit);
+    hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+    hash = mergeRound64(hash, v1);
+    hash = mergeRound64(hash, v2);
+    hash = mergeRound64(hash, v3);
+    hash = mergeRound64(hash, v4);
+  } else {
+    hash = seed + PRIME64_5;
+  }
+
+  hash += (uint64_t)size;
+
+  for (; ptr + 8 <= end; ptr += 8) {
+    hash ^= round64(0, read64(ptr));
+    hash = rotl64(hash, 27) * PRIME64_1 + PRIME64_4;
+  }
+  if (ptr + 4 <= end) {
+    hash ^= (uint64_t)read32(ptr) * PRIME64_1;
+    hash = rotl64(hash, 23) * PRIME64_2 + PRIME64_3;
+    ptr += 4;
+  }
+  for (; ptr < end; ptr++) {
+    hash ^= (*ptr) * PRIME64_5;
+    hash = rotl64(hash, 11) * PRIME64_1;
+  }
+
+  hash ^= hash >> 33;
+  hash *= PRIME64_2;
+  hash ^= hash >> 29;
+  hash *= PRIME64_3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
 void requestExit() { exitRequest = true; }
 
 }  // namespace tge::util
\ No newline at end of file
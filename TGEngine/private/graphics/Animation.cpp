@@ -0,0 +1,247 @@
+#include "../../public/graphics/Animation.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TGE_ANIMATION_SSE 1
+#endif
+
+namespace tge::graphics {
+
+#ifdef TGE_ANIMATION_SSE
+using Lane = __m128;
+
+inline Lane load(const glm::vec4& value) { return _mm_loadu_ps(&value.x); }
+
+inline Lane splat(const float value) { return _mm_set1_ps(value); }
+
+inline Lane add(const Lane a, const Lane b) { return _mm_add_ps(a, b); }
+
+inline Lane scale(const Lane a, const float b) {
+  return _mm_mul_ps(a, _mm_set1_ps(b));
+}
+
+inline Lane mix(const Lane a, const Lane b, const float t) {
+  return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t)));
+}
+
+inline float dot(const Lane a, const Lane b) {
+  const auto product = _mm_mul_ps(a, b);
+  const auto high = _mm_add_ps(product, _mm_movehl_ps(product, product));
+  return _mm_cvtss_f32(
+      _mm_add_ss(high, _mm_shuffle_ps(high, high, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+
+inline glm::vec4 store(const Lane value) {
+  glm::vec4 out;
+  _mm_storeu_ps(&out.x, value);
+  return out;
+}
+#else
+using Lane = glm::vec4;
+
+inline Lane load(const glm::vec4& value) { return value; }
+
+inline Lane splat(const float value) { return glm::vec4(value); }
+
+inline Lane add(const Lane a, const Lane b) { return a + b; }
+
+inline Lane scale(const Lane a, const float b) { return a * b; }
+
+inline Lane mix(const Lane a, const Lane b, const float t) {
+  return a + (b - a) * t;
+}
+
+inline float dot(const Lane a, const Lane b) { return glm::dot(a, b); }
+
+inline glm::vec4 store(const Lane value) { return value; }
+#endif
+
+inline Lane sample(const AnimationClip& clip,
+                   const AnimationClip::Channel& channel, const float time) {
+  const auto times = clip.times.data() + channel.firstKey;
+  const auto next = (size_t)(
+      std::upper_bound(times, times + channel.keyCount, time) - times);
+  if (next == 0) return load(clip.values[channel.firstKey]);
+  if (next == channel.keyCount)
+    return load(clip.values[channel.firstKey + channel.keyCount - 1]);
+  const auto previous = next - 1;
+  const auto from = load(clip.values[channel.firstKey + previous]);
+  if (channel.step) return from;
+  auto to = load(clip.values[channel.firstKey + next]);
+  if (channel.path == AnimationPath::ROTATION && dot(from, to) < 0.0f)
+    to = scale(to, -1.0f);
+  const auto range = times[next] - times[previous];
+  const auto t = range > 0.0f ? (time - times[previous]) / range : 0.0f;
+  return mix(from, to, t);
+}
+
+glm::vec4 sampleChannel(const AnimationClip& clip,
+                        const AnimationClip::Channel& channel,
+                        const float time) {
+  if (channel.keyCount == 0) return glm::vec4(0.0f);
+  return store(sample(clip, channel, time));
+}
+
+inline glm::vec4 resolve(const Lane accumulated, const float weight,
+                         const glm::vec4& rest) {
+  if (weight <= 0.0f) return rest;
+  if (weight >= 1.0f) return store(scale(accumulated, 1.0f / weight));
+  return store(add(accumulated, scale(load(rest), 1.0f - weight)));
+}
+
+std::vector<TAnimationHolder> AnimationSystem::play(
+    const std::span<const AnimationInfo> infos) {
+  auto allocation = players.allocate(infos.size());
+  auto [clips, targets, states] = allocation.iterator;
+  for (size_t i = 0; i < infos.size(); i++) {
+    const auto& info = infos[i];
+    clips[i] = info.clip;
+    targets[i] = info.targets;
+    states[i] = {info.time, info.speed, info.weight, info.loop};
+  }
+  dirty = true;
+  return allocation.generateOutputArray<TAnimationHolder>(infos.size());
+}
+
+void AnimationSystem::stop(const std::span<const TAnimationHolder> animations) {
+  if (!players.erase(animations)) {
+    PLOG_WARNING << "Tried to stop an animation that is not playing!";
+  }
+  (void)players.compact();
+  std::lock_guard guard(players.mutex);
+  dirty = true;
+}
+
+void AnimationSystem::rebuild(const AnimationNodes& nodes) {
+  dirty = false;
+  const auto& clips = std::get<0>(players.internalValues);
+  const auto& targets = std::get<1>(players.internalValues);
+
+  struct Entry {
+    TNodeHolder node;
+    Contribution contribution;
+  };
+  std::vector<Entry> entries;
+  for (size_t player = 0; player < clips.size(); player++) {
+    const auto& clip = clips[player];
+    if (!clip) continue;
+    const auto& playerTargets = targets[player];
+    for (uint32_t c = 0; c < clip->channels.size(); c++) {
+      const auto target = clip->channels[c].target;
+      if (target >= playerTargets.size() || !playerTargets[target]) continue;
+      entries.push_back({playerTargets[target], {player, c}});
+    }
+  }
+  std::ranges::stable_sort(entries, {}, [](const Entry& entry) {
+    return entry.node.internalHandle;
+  });
+
+  animatedNodes.clear();
+  contributions.clear();
+  contributions.reserve(entries.size());
+  std::unordered_map<TNodeHolder, NodeTransform> newRestPoses;
+  std::lock_guard guard(nodes.mutex);
+  const auto& transforms = nodes.transforms;
+  for (const auto& entry : entries) {
+    if (animatedNodes.empty() || !(animatedNodes.back().node == entry.node)) {
+      const auto found = nodes.translationTable.find(entry.node.internalHandle);
+      if (found == std::end(nodes.translationTable)) continue;
+      const auto oldRest = restPoses.find(entry.node);
+      const auto rest = oldRest == std::end(restPoses) ? transforms[found->second]
+                                                       : oldRest->second;
+      newRestPoses[entry.node] = rest;
+      animatedNodes.push_back({entry.node, rest, contributions.size(), 0});
+    }
+    contributions.push_back(entry.contribution);
+    animatedNodes.back().contributionCount++;
+  }
+  restPoses = std::move(newRestPoses);
+}
+
+void AnimationSystem::update(const double delta, const AnimationNodes& nodes,
+                             util::WorkerPool& pool) {
+  std::lock_guard guard(players.mutex);
+  const auto& clips = std::get<0>(players.internalValues);
+  auto& states = std::get<2>(players.internalValues);
+  for (size_t i = 0; i < states.size(); i++) {
+    auto& state = states[i];
+    const auto duration = clips[i] ? clips[i]->duration : 0.0f;
+    state.time += (float)delta * state.speed;
+    if (duration <= 0.0f) {
+      state.time = 0.0f;
+    } else if (state.loop) {
+      state.time = std::fmod(state.time, duration);
+      if (state.time < 0.0f) state.time += duration;
+    } else {
+      state.time = std::clamp(state.time, 0.0f, duration);
+    }
+  }
+  if (dirty) rebuild(nodes);
+  if (animatedNodes.empty()) return;
+
+  std::lock_guard nodeGuard(nodes.mutex);
+  auto& transforms = nodes.transforms;
+  auto& statuses = nodes.statuses;
+  pool.parallelFor(
+      animatedNodes.size(), 64, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          const auto& animated = animatedNodes[i];
+          const auto found =
+              nodes.translationTable.find(animated.node.internalHandle);
+          if (found == std::end(nodes.translationTable)) continue;
+
+          const auto& rest = animated.rest;
+          const glm::vec4 restRotation(rest.rotation.x, rest.rotation.y,
+                                       rest.rotation.z, rest.rotation.w);
+          std::array<Lane, 3> accumulated = {splat(0.0f), splat(0.0f),
+                                             splat(0.0f)};
+          std::array<float, 3> weights = {0.0f, 0.0f, 0.0f};
+          const auto first = contributions.begin() + animated.firstContribution;
+          for (auto itr = first; itr != first + animated.contributionCount;
+               itr++) {
+            const auto& state = states[itr->player];
+            if (state.weight <= 0.0f) continue;
+            const auto& clip = *clips[itr->player];
+            const auto& channel = clip.channels[itr->channel];
+            const auto path = (size_t)channel.path;
+            auto value = sample(clip, channel, state.time);
+            if (channel.path == AnimationPath::ROTATION &&
+                dot(weights[path] > 0.0f ? accumulated[path]
+                                         : load(restRotation),
+                    value) < 0.0f)
+              value = scale(value, -1.0f);
+            accumulated[path] =
+                add(accumulated[path], scale(value, state.weight));
+            weights[path] += state.weight;
+          }
+
+          auto& transform = transforms[found->second];
+          const auto translation =
+              resolve(accumulated[(size_t)AnimationPath::TRANSLATION],
+                      weights[(size_t)AnimationPath::TRANSLATION],
+                      glm::vec4(rest.translation, 0.0f));
+          const auto scaling =
+              resolve(accumulated[(size_t)AnimationPath::SCALE],
+                      weights[(size_t)AnimationPath::SCALE],
+                      glm::vec4(rest.scale, 0.0f));
+          auto rotation =
+              resolve(accumulated[(size_t)AnimationPath::ROTATION],
+                      weights[(size_t)AnimationPath::ROTATION], restRotation);
+          const auto length = glm::length(rotation);
+          rotation = length > 1e-6f ? rotation / length
+                                    : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+          transform.translation = glm::vec3(translation);
+          transform.scale = glm::vec3(scaling);
+          transform.rotation =
+              glm::quat(rotation.w, rotation.x, rotation.y, rotation.z);
+          statuses[found->second] = 1;
+        }
+      });
+}
+
+}  // namespace tge::graphics
@@ -0,0 +1,131 @@
+#include "../../public/graphics/FrameCapture.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "../../public/TGEngine.hpp"
+#include "../../public/headerlibs/stb_image_write.h"
+
+namespace tge::graphics {
+
+namespace fs = std::filesystem;
+
+// Runs on a worker, raw frames of other formats keep their texels as read
+inline bool encodeFrame(const std::vector<uint8_t>& texels, const uint32_t width,
+                        const uint32_t height, const size_t format,
+                        const CaptureEncoding encoding, const fs::path& path) {
+  std::vector<uint8_t> rgba((size_t)width * height * 4);
+  const bool converted = texels.size() >= rgba.size() &&
+                         toRGBA8(texels.data(), (size_t)width * height, format,
+                                 rgba.data());
+  if (encoding == CaptureEncoding::PNG) {
+    if (!converted) {
+      PLOG_WARNING << "Format " << format << " can not be written as PNG!";
+      return false;
+    }
+    return stbi_write_png(path.string().c_str(), (int)width, (int)height, 4,
+                          rgba.data(), (int)width * 4) != 0;
+  }
+  std::ofstream output(path, std::ios::binary);
+  const auto& data = converted ? rgba : texels;
+  output.write((const char*)data.data(), data.size());
+  return output.good();
+}
+
+main::Error FrameCaptureModule::init() {
+  api = main::getAPILayer();
+  start = std::chrono::steady_clock::now();
+  pool = settings.encodeThreads == 0
+             ? std::make_unique<util::WorkerPool>()
+             : std::make_unique<util::WorkerPool>(settings.encodeThreads);
+  std::error_code code;
+  fs::create_directories(settings.directory, code);
+  if (code) {
+    PLOG_ERROR << "Could not create capture directory " << settings.directory
+               << ": " << code.message();
+  }
+  return main::Error::NONE;
+}
+
+void FrameCaptureModule::collect(const bool flush) {
+  while (!readbacks.empty()) {
+    const auto [readback, frame] = readbacks.front();
+    if (!flush && !api->isReadbackReady(readback)) break;
+    readbacks.pop_front();
+    if (encodes.size() >= settings.maxEncodes && !flush) {
+      api->releaseReadback(readback);
+      stats.dropped++;
+      continue;
+    }
+    const auto info = api->getReadbackInfo(readback);
+    const auto data = api->getReadbackData(readback);
+    // Frames requested after the last one was rendered are never copied
+    if (data.empty()) {
+      api->releaseReadback(readback);
+      stats.dropped++;
+      continue;
+    }
+    std::vector<uint8_t> texels(data.begin(), data.end());
+    api->releaseReadback(readback);
+    stats.captured++;
+    captureCounter.add(now());
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "frame_%06zu_%ux%u.%s", frame,
+                  info.width, info.height,
+                  settings.encoding == CaptureEncoding::PNG ? "png" : "raw");
+    encodes.push_back(pool->submit(
+        [texels = std::move(texels), width = info.width, height = info.height,
+         format = info.internalFormatOverride, encoding = settings.encoding,
+         path = settings.directory / name] {
+          return encodeFrame(texels, width, height, format, encoding, path);
+        }));
+  }
+
+  while (!encodes.empty()) {
+    auto& encode = encodes.front();
+    if (!flush &&
+        encode.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      break;
+    if (encode.get()) {
+      stats.encoded++;
+      encodeCounter.add(now());
+    } else {
+      stats.failed++;
+    }
+    encodes.pop_front();
+  }
+  stats.captureRate = captureCounter.rate();
+  stats.encodeRate = encodeCounter.rate();
+}
+
+void FrameCaptureModule::tick(double deltatime) {
+  collect(false);
+  const auto interval = std::max(settings.interval, 1u);
+  if (ticks++ % interval != 0) return;
+  if (settings.maxFrames != 0 && frames >= settings.maxFrames) return;
+  if (readbacks.size() >= settings.maxReadbacks) {
+    stats.dropped++;
+    return;
+  }
+  const auto readback = !settings.target ? api->readOutputAsync()
+                                         : api->readImageAsync(settings.target);
+  if (!readback) {
+    stats.dropped++;
+    return;
+  }
+  readbacks.push_back({readback, frames++});
+}
+
+void FrameCaptureModule::destroy() {
+  if (api == nullptr) return;
+  collect(true);
+  PLOG_INFO << "Captured " << stats.captured << " frames, encoded "
+            << stats.encoded << " at " << stats.encodeRate << " FPS, dropped "
+            << stats.dropped << ", failed " << stats.failed;
+  pool.reset();
+}
+
+}  // namespace tge::graphics
@@ -0,0 +1,386 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../../public/Util.hpp"
+#include "../../public/headerlibs/tiny_gltf.h"
+
+namespace tge::graphics::gltf {
+
+	// The parts of a glTF document the engine uses, buffers and images are
+	// views into the mapped files instead of copies
+	struct GLTFView {
+		tinygltf::Model model;
+		std::vector<std::span<const char>> buffers;
+		std::vector<std::span<const char>> images;
+		std::vector<util::MappedFile> mappedFiles;
+		std::vector<std::vector<unsigned char>> ownedData;
+	};
+
+	constexpr uint32_t GLB_MAGIC = 0x46546C67;
+	constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+	constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+	inline bool isGLB(const std::span<const char> data) {
+		uint32_t magic = 0;
+		if (data.size() < 12) return false;
+		std::memcpy(&magic, data.data(), sizeof(magic));
+		return magic == GLB_MAGIC;
+	}
+
+	inline int typeFromString(const std::string& type) {
+		if (type == "SCALAR") return TINYGLTF_TYPE_SCALAR;
+		if (type == "VEC2") return TINYGLTF_TYPE_VEC2;
+		if (type == "VEC3") return TINYGLTF_TYPE_VEC3;
+		if (type == "VEC4") return TINYGLTF_TYPE_VEC4;
+		if (type == "MAT2") return TINYGLTF_TYPE_MAT2;
+		if (type == "MAT3") return TINYGLTF_TYPE_MAT3;
+		if (type == "MAT4") return TINYGLTF_TYPE_MAT4;
+		return -1;
+	}
+
+	template<class T>
+	inline void readArray(const nlohmann::json& object, const char* key,
+		std::vector<T>& out) {
+		const auto found = object.find(key);
+		if (found == object.end() || !found->is_array()) return;
+		out.reserve(found->size());
+		for (const auto& value : *found) out.push_back(value.get<T>());
+	}
+
+	// Texture of a textureInfo object like baseColorTexture, -1 if missing
+	inline int textureIndex(const nlohmann::json& object, const char* key) {
+		const auto found = object.find(key);
+		if (found == object.end() || !found->is_object()) return -1;
+		return found->value("index", -1);
+	}
+
+	inline const nlohmann::json& arrayOf(const nlohmann::json& root,
+		const char* key) {
+		static const nlohmann::json empty = nlohmann::json::array();
+		const auto found = root.find(key);
+		if (found == root.end() || !found->is_array()) return empty;
+		return *found;
+	}
+
+	// Resolves a uri into bytes, data uris are decoded into owned storage
+	// and files are mapped
+	inline std::span<const char> resolveURI(const std::string& uri,
+		const std::string& baseDir, GLTFView& view, std::string& error) {
+		if (tinygltf::IsDataURI(uri)) {
+			std::string mimeType;
+			auto& decoded = view.ownedData.emplace_back();
+			if (!tinygltf::DecodeDataURI(&decoded, mimeType, uri, 0, false)) {
+				error = "Couldn't decode data uri!";
+				return {};
+			}
+			return std::span((const char*)decoded.data(), decoded.size());
+		}
+		const auto decodedURI = tinygltf::dlib::urldecode(uri);
+		const auto path = baseDir.empty() ? fs::path(decodedURI)
+			: fs::path(baseDir) / decodedURI;
+		util::MappedFile file(path);
+		if (!file) {
+			error = "Couldn't map file: " + path.string() + "!";
+			return {};
+		}
+		const auto bytes = file.view();
+		view.mappedFiles.push_back(std::move(file));
+		return bytes;
+	}
+
+	inline bool parseJSON(const nlohmann::json& root,
+		const std::span<const char> binChunk, const std::string& baseDir,
+		GLTFView& view, std::string& error) {
+		auto& model = view.model;
+
+		for (const auto& object : arrayOf(root, "buffers")) {
+			auto& buffer = model.buffers.emplace_back();
+			buffer.name = object.value("name", "");
+			buffer.uri = object.value("uri", "");
+			const size_t byteLength = object.value("byteLength", (size_t)0);
+			std::span<const char> bytes;
+			if (buffer.uri.empty()) {
+				bytes = binChunk;
+			}
+			else {
+				bytes = resolveURI(buffer.uri, baseDir, view, error);
+				if (!error.empty()) return false;
+			}
+			if (bytes.size() < byteLength) {
+				error = "Buffer " + std::to_string(view.buffers.size()) +
+					" is smaller than its byteLength!";
+				return false;
+			}
+			view.buffers.push_back(bytes.first(byteLength));
+		}
+
+		for (const auto& object : arrayOf(root, "bufferViews")) {
+			auto& bufferView = model.bufferViews.emplace_back();
+			bufferView.name = object.value("name", "");
+			bufferView.buffer = object.value("buffer", -1);
+			bufferView.byteOffset = object.value("byteOffset", (size_t)0);
+			bufferView.byteLength = object.value("byteLength", (size_t)0);
+			bufferView.byteStride = object.value("byteStride", (size_t)0);
+			bufferView.target = object.value("target", 0);
+			if (bufferView.buffer < 0 ||
+				(size_t)bufferView.buffer >= view.buffers.size() ||
+				bufferView.byteOffset + bufferView.byteLength >
+				view.buffers[bufferView.buffer].size()) {
+				error = "BufferView out of range!";
+				return false;
+			}
+		}
+
+		for (const auto& object : arrayOf(root, "accessors")) {
+			auto& accessor = model.accessors.emplace_back();
+			accessor.name = object.value("name", "");
+			accessor.bufferView = object.value("bufferView", -1);
+			accessor.byteOffset = object.value("byteOffset", (size_t)0);
+			accessor.normalized = object.value("normalized", false);
+			accessor.componentType = object.value("componentType", -1);
+			accessor.count = object.value("count", (size_t)0);
+			accessor.type = typeFromString(object.value("type", ""));
+			readArray(object, "min", accessor.minValues);
+			readArray(object, "max", accessor.maxValues);
+		}
+
+		for (const auto& object : arrayOf(root, "meshes")) {
+			auto& mesh = model.meshes.emplace_back();
+			mesh.name = object.value("name", "");
+			for (const auto& primObject : arrayOf(object, "primitives")) {
+				auto& prim = mesh.primitives.emplace_back();
+				prim.indices = primObject.value("indices", -1);
+				prim.material = primObject.value("material", -1);
+				prim.mode = primObject.value("mode", TINYGLTF_MODE_TRIANGLES);
+				const auto attributes = primObject.find("attributes");
+				if (attributes == primObject.end()) continue;
+				for (const auto& [name, accessor] : attributes->items()) {
+					prim.attributes[name] = accessor.get<int>();
+				}
+			}
+		}
+
+		for (const auto& object : arrayOf(root, "nodes")) {
+			auto& node = model.nodes.emplace_back();
+			node.name = object.value("name", "");
+			node.mesh = object.value("mesh", -1);
+			node.skin = object.value("skin", -1);
+			node.camera = object.value("camera", -1);
+			readArray(object, "children", node.children);
+			readArray(object, "translation", node.translation);
+			readArray(object, "rotation", node.rotation);
+			readArray(object, "scale", node.scale);
+			readArray(object, "matrix", node.matrix);
+		}
+
+		for (const auto& object : arrayOf(root, "samplers")) {
+			auto& sampler = model.samplers.emplace_back();
+			sampler.name = object.value("name", "");
+			sampler.minFilter = object.value("minFilter", -1);
+			sampler.magFilter = object.value("magFilter", -1);
+			sampler.wrapS = object.value("wrapS", TINYGLTF_TEXTURE_WRAP_REPEAT);
+			sampler.wrapT = object.value("wrapT", TINYGLTF_TEXTURE_WRAP_REPEAT);
+		}
+
+		for (const auto& object : arrayOf(root, "textures")) {
+			auto& texture = model.textures.emplace_back();
+			texture.name = object.value("name", "");
+			texture.sampler = object.value("sampler", -1);
+			texture.source = object.value("source", -1);
+		}
+
+		for (const auto& object : arrayOf(root, "materials")) {
+			auto& material = model.materials.emplace_back();
+			material.name = object.value("name", "");
+			// Only the color textures are read, they decide the gamma of the mips
+			const auto pbr = object.find("pbrMetallicRoughness");
+			if (pbr != object.end() && pbr->is_object()) {
+				material.pbrMetallicRoughness.baseColorTexture.index =
+					textureIndex(*pbr, "baseColorTexture");
+			}
+			material.emissiveTexture.index = textureIndex(object, "emissiveTexture");
+		}
+
+		for (const auto& object : arrayOf(root, "skins")) {
+			auto& skin = model.skins.emplace_back();
+			skin.name = object.value("name", "");
+			skin.inverseBindMatrices = object.value("inverseBindMatrices", -1);
+			skin.skeleton = object.value("skeleton", -1);
+			readArray(object, "joints", skin.joints);
+		}
+
+		for (const auto& object : arrayOf(root, "animations")) {
+			auto& animation = model.animations.emplace_back();
+			animation.name = object.value("name", "");
+			for (const auto& samplerObject : arrayOf(object, "samplers")) {
+				auto& sampler = animation.samplers.emplace_back();
+				sampler.input = samplerObject.value("input", -1);
+				sampler.output = samplerObject.value("output", -1);
+				sampler.interpolation = samplerObject.value("interpolation", "LINEAR");
+			}
+			for (const auto& channelObject : arrayOf(object, "channels")) {
+				auto& channel = animation.channels.emplace_back();
+				channel.sampler = channelObject.value("sampler", -1);
+				const auto target = channelObject.find("target");
+				if (target == channelObject.end()) continue;
+				channel.target_node = target->value("node", -1);
+				channel.target_path = target->value("path", "");
+			}
+		}
+
+		for (const auto& object : arrayOf(root, "images")) {
+			auto& image = model.images.emplace_back();
+			image.name = object.value("name", "");
+			image.uri = object.value("uri", "");
+			image.mimeType = object.value("mimeType", "");
+			image.bufferView = object.value("bufferView", -1);
+			if (image.bufferView >= 0) {
+				if ((size_t)image.bufferView >= model.bufferViews.size()) {
+					error = "Image bufferView out of range!";
+					return false;
+				}
+				const auto& bufferView = model.bufferViews[image.bufferView];
+				view.images.push_back(view.buffers[bufferView.buffer].subspan(
+					bufferView.byteOffset, bufferView.byteLength));
+				continue;
+			}
+			view.images.push_back(resolveURI(image.uri, baseDir, view, error));
+			if (!error.empty()) return false;
+		}
+		return true;
+	}
+
+	// Reads an accessor as floats, normalized integers are mapped to [0, 1]
+	// or [-1, 1] and other integers are converted as is
+	inline bool readFloats(const GLTFView& view, const int accessorIndex,
+		std::vector<float>& out) {
+		out.clear();
+		const auto& model = view.model;
+		if (accessorIndex < 0 || (size_t)accessorIndex >= model.accessors.size())
+			return false;
+		const auto& accessor = model.accessors[accessorIndex];
+		const auto components =
+			tinygltf::GetNumComponentsInType((uint32_t)accessor.type);
+		const auto componentSize =
+			tinygltf::GetComponentSizeInBytes((uint32_t)accessor.componentType);
+		if (components <= 0 || componentSize <= 0) return false;
+		out.resize(accessor.count * components);
+		if (accessor.bufferView < 0) return true;  // sparse only, all zero
+
+		const auto& bufferView = model.bufferViews[accessor.bufferView];
+		const auto elementSize = (size_t)components * componentSize;
+		const auto stride =
+			bufferView.byteStride == 0 ? elementSize : bufferView.byteStride;
+		const auto bytes =
+			view.buffers[bufferView.buffer].subspan(bufferView.byteOffset,
+				bufferView.byteLength);
+		if (accessor.count != 0 && accessor.byteOffset +
+			(accessor.count - 1) * stride + elementSize > bytes.size())
+			return false;
+
+		const auto normalized = accessor.normalized;
+		const auto convert = [&]<class T>(const T* value) {
+			if constexpr (std::is_same_v<T, float>) {
+				return *value;
+			}
+			else {
+				if (!normalized) return (float)*value;
+				return std::max((float)*value / (float)std::numeric_limits<T>::max(),
+					-1.0f);
+			}
+		};
+		for (size_t i = 0; i < accessor.count; i++) {
+			const auto element = bytes.data() + accessor.byteOffset + i * stride;
+			for (int c = 0; c < components; c++) {
+				const auto at = element + (size_t)c * componentSize;
+				auto& target = out[i * components + c];
+				switch (accessor.componentType) {
+				case TINYGLTF_COMPONENT_TYPE_FLOAT: {
+					float value;
+					std::memcpy(&value, at, sizeof(value));
+					target = convert(&value);
+				} break;
+				case TINYGLTF_COMPONENT_TYPE_BYTE:
+					target = convert((const int8_t*)at);
+					break;
+				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+					target = convert((const uint8_t*)at);
+					break;
+				case TINYGLTF_COMPONENT_TYPE_SHORT: {
+					int16_t value;
+					std::memcpy(&value, at, sizeof(value));
+					target = convert(&value);
+				} break;
+				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+					uint16_t value;
+					std::memcpy(&value, at, sizeof(value));
+					target = convert(&value);
+				} break;
+				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
+					uint32_t value;
+					std::memcpy(&value, at, sizeof(value));
+					target = convert(&value);
+				} break;
+				default:
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Parses a gltf or glb document without copying the binary payload, the
+	// input has to outlive the view
+	inline bool parse(const std::span<const char> data, const bool binary,
+		const std::string& baseDir, GLTFView& view, std::string& error) {
+		std::span<const char> jsonChunk = data;
+		std::span<const char> binChunk;
+		if (binary) {
+			if (!isGLB(data)) {
+				error = "Invalid glb header!";
+				return false;
+			}
+			uint32_t header[3];
+			std::memcpy(header, data.data(), sizeof(header));
+			const auto length = std::min<size_t>(header[2], data.size());
+			size_t offset = sizeof(header);
+			jsonChunk = {};
+			while (offset + 8 <= length) {
+				uint32_t chunk[2];
+				std::memcpy(chunk, data.data() + offset, sizeof(chunk));
+				offset += sizeof(chunk);
+				if (offset + chunk[0] > length) {
+					error = "Glb chunk out of range!";
+					return false;
+				}
+				const auto chunkData = data.subspan(offset, chunk[0]);
+				if (chunk[1] == GLB_CHUNK_JSON && jsonChunk.empty()) {
+					jsonChunk = chunkData;
+				}
+				else if (chunk[1] == GLB_CHUNK_BIN && binChunk.empty()) {
+					binChunk = chunkData;
+				}
+				offset += (chunk[0] + 3) & ~3u;
+			}
+			if (jsonChunk.empty()) {
+				error = "Glb is missing the json chunk!";
+				return false;
+			}
+		}
+		const auto root = nlohmann::json::parse(
+			jsonChunk.data(), jsonChunk.data() + jsonChunk.size(), nullptr, false);
+		if (root.is_discarded() || !root.is_object()) {
+			error = "Couldn't parse gltf json!";
+			return false;
+		}
+		return parseJSON(root, binChunk, baseDir, view, error);
+	}
+
+}  // namespace tge::graphics::gltf
@@ -8,10 +8,14 @@
 
 #include "../../public/Util.hpp"
 #include "../../public/graphics/GameShaderModule.hpp"
+#include "../../public/graphics/MipGeneration.hpp"
+#include "../../public/graphics/TextureConversion.hpp"
+#include "../../public/graphics/TextureDiskCache.hpp"
 #include "../../public/graphics/vulkan/VulkanShaderPipe.hpp"
 #include "../../public/headerlibs/ddspp.h"
-#include "../../public/headerlibs/tiny_gltf.h"
 #include "BGAL.h"
+#include "GLTFView.hpp"
+#include "TextureDecode.hpp"
 
 namespace tge::graphics {
 
@@ -78,49 +82,308 @@ namespace tge::graphics {
 		return samplerHolder;
 	}
 
-	inline std::vector<TTextureHolder> loadTexturesFM(const Model& model,
-		APILayer* apiLayer) {
-		std::vector<TextureInfo> textureInfos;
-		textureInfos.reserve(model.images.size());
-		for (const auto& img : model.images) {
-			if (!img.image.empty()) [[likely]] {
-				const TextureInfo info{ (uint8_t*)img.image.data(),
-									   (uint32_t)img.image.size(), (uint32_t)img.width,
-									   (uint32_t)img.height, (uint32_t)img.component };
-				textureInfos.push_back(info);
-				}
-			else {
-				throw std::runtime_error("Not implemented!");
-			}
+	template<class Holder>
+	inline std::vector<Holder> pushCached(ContentCache<Holder>& cache,
+		const std::vector<uint64_t>& hashes, auto&& push) {
+		std::vector<Holder> holders(hashes.size());
+		std::vector<size_t> toPush;
+		toPush.reserve(hashes.size());
+		std::unordered_map<uint64_t, size_t> pending;
+		for (size_t i = 0; i < hashes.size(); i++) {
+			holders[i] = cache.acquire(hashes[i]);
+			if (!(!holders[i]) || pending.contains(hashes[i])) continue;
+			pending[hashes[i]] = toPush.size();
+			toPush.push_back(i);
 		}
-		if (!textureInfos.empty())
-			return apiLayer->pushTexture(textureInfos.size(), textureInfos.data());
-		return {};
+		if (toPush.empty()) return holders;
+
+		const std::vector<Holder> pushed = push(toPush);
+		const auto pushedCount = std::min(pushed.size(), toPush.size());
+		for (size_t i = 0; i < pushedCount; i++) {
+			if (!pushed[i]) continue;
+			cache.insert(hashes[toPush[i]], pushed[i]);
+		}
+		for (size_t i = 0; i < hashes.size(); i++) {
+			if (!(!holders[i])) continue;
+			const auto pushedIndex = pending[hashes[i]];
+			if (pushedIndex >= pushedCount || !pushed[pushedIndex]) continue;
+			holders[i] = pushed[pushedIndex];
+			if (toPush[pushedIndex] != i) (void)cache.acquire(hashes[i]);
+		}
+		return holders;
 	}
 
-	inline std::vector<TDataHolder> loadDataBuffers(const Model& model,
+	// Seed of the content hash, an image with and without gamma correct mips
+	// are different textures
+	inline uint64_t textureSeed(const LoadType type, const bool gammaCorrect) {
+		return (uint64_t)type | ((uint64_t)!gammaCorrect << 8);
+	}
+
+	inline TextureFormats queryTextureFormats(APILayer* apiLayer,
+		const bool gammaCorrect = true) {
+		const auto& features = apiLayer->getGraphicsModule()->features;
+		// 16 bit textures always get their mips blitted
+		const auto supported = [&](const vk::Format format, const bool blit = true) {
+			return apiLayer->isTextureFormatSupported((size_t)format, blit) ? format
+				: vk::Format::eUndefined;
+		};
+		const bool blit8 = !features.cpuMipMaps;
+		constexpr auto undefined = vk::Format::eUndefined;
+		auto compression = features.textureCompression;
+		if (compression != BlockFormat::NONE &&
+			!apiLayer->isTextureFormatSupported(blockVulkanFormat(compression), false)) {
+			PLOG_WARNING << "Block compression not supported, textures stay uncompressed!";
+			compression = BlockFormat::NONE;
+		}
+		TextureFormats formats{ { undefined, supported(vk::Format::eR8Unorm, blit8),
+			supported(vk::Format::eR8G8Unorm, blit8), undefined,
+			vk::Format::eR8G8B8A8Unorm },
+			{ undefined, supported(vk::Format::eR16Unorm),
+			supported(vk::Format::eR16G16Unorm), undefined,
+			supported(vk::Format::eR16G16B16A16Unorm) },
+			compression, (bool)features.cpuMipMaps,
+			{ features.mipMapLevels, features.mipFilter, gammaCorrect },
+			features.textureCacheDirectory };
+		formats.settingsHash = textureSettingsHash(formats);
+		return formats;
+	}
+
+	// Textures that failed to load keep an empty holder
+	inline std::vector<TTextureHolder> pushDecoded(APILayer* apiLayer,
+		const std::vector<TextureInfo>& infos) {
+		std::vector<TextureInfo> valid;
+		valid.reserve(infos.size());
+		for (const auto& info : infos) {
+			if (info.data != nullptr) valid.push_back(info);
+		}
+		std::vector<TTextureHolder> holders(infos.size());
+		if (valid.empty()) return holders;
+		const auto pushed = apiLayer->pushTexture(valid.size(), valid.data());
+		for (size_t i = 0, next = 0; i < infos.size() && next < pushed.size(); i++) {
+			if (infos[i].data != nullptr) holders[i] = pushed[next++];
+		}
+		return holders;
+	}
+
+	inline std::vector<TTextureHolder> loadTexturesFM(const gltf::GLTFView& view,
+		APILayer* apiLayer, util::WorkerPool& pool) {
+		const auto& model = view.model;
+		// Base color and emissive images are colors, everything else like
+		// normal or occlusion maps is data and its mips are filtered linearly
+		std::vector<bool> color(view.images.size(), false);
+		const auto markColor = [&](const int texture) {
+			if (texture < 0 || (size_t)texture >= model.textures.size()) return;
+			const auto source = model.textures[texture].source;
+			if (source >= 0 && (size_t)source < color.size()) color[source] = true;
+		};
+		for (const auto& material : model.materials) {
+			markColor(material.pbrMetallicRoughness.baseColorTexture.index);
+			markColor(material.emissiveTexture.index);
+		}
+		std::vector<uint64_t> hashes;
+		hashes.reserve(view.images.size());
+		for (size_t i = 0; i < view.images.size(); i++) {
+			const auto& image = view.images[i];
+			hashes.push_back(util::hash64(image.data(), image.size(),
+				textureSeed(LoadType::STBI, color[i])));
+		}
+		if (hashes.empty()) return {};
+		return pushCached(apiLayer->backend()->textureCache, hashes,
+			[&](const std::vector<size_t>& toPush) {
+				DecodedTextures decoded(toPush.size());
+				const std::array formats = { queryTextureFormats(apiLayer, false),
+					queryTextureFormats(apiLayer, true) };
+				pool.parallelFor(toPush.size(), 1, [&](size_t begin, size_t end) {
+					for (size_t i = begin; i < end; i++) {
+						const auto index = toPush[i];
+						decodeCached(view.images[index], hashes[index],
+							model.images[index].name, formats[color[index]],
+							decoded.infos[i], decoded.mapped[i]);
+					}
+					});
+				return pushDecoded(apiLayer, decoded.infos);
+			});
+	}
+
+	inline std::vector<TDataHolder> loadDataBuffers(const gltf::GLTFView& view,
 		APILayer* apiLayer) {
 		std::vector<BufferInfo> infoBuffer;
-		infoBuffer.reserve(model.buffers.size());
-		for (const auto& buffer : model.buffers) {
-			infoBuffer.push_back({ (uint8_t*)buffer.data.data(), buffer.data.size(),
+		std::vector<uint64_t> hashes;
+		infoBuffer.reserve(view.buffers.size());
+		hashes.reserve(view.buffers.size());
+		for (const auto& buffer : view.buffers) {
+			infoBuffer.push_back({ (void*)buffer.data(), buffer.size(),
 								  DataType::VertexIndexData });
+			hashes.push_back(util::hash64(buffer.data(), buffer.size(),
+				(uint64_t)DataType::VertexIndexData));
+		}
+		if (infoBuffer.empty()) return {};
+		return pushCached(apiLayer->backend()->dataCache, hashes,
+			[&](const std::vector<size_t>& toPush) {
+				std::vector<BufferInfo> infos;
+				infos.reserve(toPush.size());
+				for (const auto index : toPush) infos.push_back(infoBuffer[index]);
+				return apiLayer->pushPackedData(infos.size(), infos.data(), "Model");
+			});
+	}
+
+	struct InstanceRange {
+		size_t firstInstance = 0;
+		size_t instanceCount = 0;
+	};
+
+	inline std::vector<InstanceRange> loadInstances(const Model& model,
+		std::vector<uint32_t>& instanceIndices) {
+		std::vector<std::vector<uint32_t>> meshNodes(model.meshes.size());
+		for (size_t i = 0; i < model.nodes.size(); i++) {
+			const auto mesh = model.nodes[i].mesh;
+			if (mesh < 0 || (size_t)mesh >= meshNodes.size()) continue;
+			meshNodes[mesh].push_back((uint32_t)(i + 1));
+		}
+		std::vector<InstanceRange> ranges(meshNodes.size());
+		instanceIndices.reserve(model.nodes.size());
+		for (size_t i = 0; i < meshNodes.size(); i++) {
+			// Meshes no node references are not part of the scene and get no instance
+			const auto& nodes = meshNodes[i];
+			ranges[i] = { instanceIndices.size(), nodes.size() };
+			instanceIndices.insert(instanceIndices.end(), nodes.begin(), nodes.end());
 		}
-		return apiLayer->pushData(infoBuffer.size(), infoBuffer.data());
+		return ranges;
+	}
+
+	// Permutation of the skinned pipeline a primitive is drawn with
+	inline size_t skinnedVariant(const tinygltf::Primitive& prim) {
+		return (prim.attributes.contains("NORMAL") ? 1 : 0) |
+			(prim.attributes.contains("TEXCOORD_0") ? 2 : 0);
+	}
+
+	// Joints and weights of skinned primitives converted to vec4 floats
+	struct SkinnedPrimitives {
+		TDataHolder vertexData;
+		TDataHolder jointData;
+		std::array<TPipelineHolder, 4> materials;
+		std::array<shader::TBindingHolder, 4> bindings;
+		std::array<bool, 4> usedVariants{};
+		std::vector<std::vector<std::array<size_t, 2>>> offsets;
+	};
+
+	inline SkinnedPrimitives loadSkinnedPrimitives(const gltf::GLTFView& view,
+		APILayer* apiLayer) {
+		const auto& model = view.model;
+		SkinnedPrimitives skinned;
+		skinned.offsets.resize(model.meshes.size());
+		std::vector<bool> skinnedMeshes(model.meshes.size(), false);
+		for (const auto& node : model.nodes) {
+			if (node.skin >= 0 && node.mesh >= 0 &&
+				(size_t)node.mesh < skinnedMeshes.size())
+				skinnedMeshes[node.mesh] = true;
+		}
+
+		std::vector<float> vertices;
+		std::vector<float> joints;
+		std::vector<float> weights;
+		for (size_t i = 0; i < model.meshes.size(); i++) {
+			const auto& mesh = model.meshes[i];
+			auto& offsets = skinned.offsets[i];
+			offsets.resize(mesh.primitives.size(), { INVALID_SIZE_T, INVALID_SIZE_T });
+			if (!skinnedMeshes[i]) continue;
+			for (size_t p = 0; p < mesh.primitives.size(); p++) {
+				const auto& attributes = mesh.primitives[p].attributes;
+				const auto jointItr = attributes.find("JOINTS_0");
+				const auto weightItr = attributes.find("WEIGHTS_0");
+				if (jointItr == attributes.end() || weightItr == attributes.end() ||
+					!attributes.contains("POSITION"))
+					continue;
+				if (!gltf::readFloats(view, jointItr->second, joints) ||
+					!gltf::readFloats(view, weightItr->second, weights) ||
+					joints.size() != weights.size() || joints.size() % 4 != 0) {
+					PLOG_WARNING << "Skipping skin of " << mesh.name << "!";
+					continue;
+				}
+				offsets[p][0] = vertices.size() * sizeof(float);
+				vertices.insert(vertices.end(), joints.begin(), joints.end());
+				offsets[p][1] = vertices.size() * sizeof(float);
+				vertices.insert(vertices.end(), weights.begin(), weights.end());
+				skinned.usedVariants[skinnedVariant(mesh.primitives[p])] = true;
+			}
+		}
+		if (vertices.empty()) return skinned;
+		const BufferInfo info{ vertices.data(), vertices.size() * sizeof(float),
+			DataType::VertexData };
+		skinned.vertexData = apiLayer->pushData(1, &info, "SkinVertices")[0];
+		return skinned;
+	}
+
+	inline std::vector<std::shared_ptr<const AnimationClip>> loadAnimations(
+		const gltf::GLTFView& view) {
+		const auto& model = view.model;
+		std::vector<std::shared_ptr<const AnimationClip>> clips;
+		clips.reserve(model.animations.size());
+		std::vector<float> input;
+		std::vector<float> output;
+		for (const auto& animation : model.animations) {
+			auto clip = std::make_shared<AnimationClip>();
+			clip->name = animation.name;
+			for (const auto& channel : animation.channels) {
+				if (channel.target_node < 0 ||
+					(size_t)channel.target_node >= model.nodes.size() ||
+					channel.sampler < 0 ||
+					(size_t)channel.sampler >= animation.samplers.size())
+					continue;
+				AnimationPath path;
+				if (channel.target_path == "translation") {
+					path = AnimationPath::TRANSLATION;
+				}
+				else if (channel.target_path == "rotation") {
+					path = AnimationPath::ROTATION;
+				}
+				else if (channel.target_path == "scale") {
+					path = AnimationPath::SCALE;
+				}
+				else {
+					continue;  // morph target weights are not supported
+				}
+				const auto& sampler = animation.samplers[channel.sampler];
+				if (!gltf::readFloats(view, sampler.input, input) ||
+					!gltf::readFloats(view, sampler.output, output) || input.empty())
+					continue;
+				// cubic splines keep their keys and are played back linear
+				const bool cubic = sampler.interpolation == "CUBICSPLINE";
+				const size_t components = path == AnimationPath::ROTATION ? 4 : 3;
+				const size_t stride = components * (cubic ? 3 : 1);
+				if (output.size() < input.size() * stride) continue;
+
+				clip->channels.push_back({ (uint32_t)channel.target_node, path,
+					sampler.interpolation == "STEP", (uint32_t)clip->times.size(),
+					(uint32_t)input.size() });
+				for (size_t k = 0; k < input.size(); k++) {
+					const auto value = output.data() + k * stride + (cubic ? components : 0);
+					clip->addKey(input[k], glm::vec4(value[0], value[1], value[2],
+						components == 4 ? value[3] : 0.0f));
+				}
+				clip->duration = std::max(clip->duration, input.back());
+			}
+			clips.push_back(std::move(clip));
+		}
+		return clips;
 	}
 
 	inline void pushRender(const Model& model, APILayer* apiLayer,
 		const std::vector<TDataHolder>& dataId,
 		const std::vector<TPipelineHolder>& materialId,
-		const std::vector<TNodeHolder> nodeID,
-		GameGraphicsModule* ggm) {
+		const std::vector<InstanceRange>& instances,
+		const shader::TBindingHolder bID, const TDataHolder instanceData,
+		const SkinnedPrimitives& skinned) {
 		std::vector<RenderInfo> renderInfos;
 		renderInfos.reserve(1000);
-		const auto& bindings = ggm->getBinding({ nodeID.begin() + 1, nodeID.end() });
 		for (size_t i = 0; i < model.meshes.size(); i++) {
 			const auto& mesh = model.meshes[i];
-			const auto bID = bindings[i];
-			for (const auto& prim : mesh.primitives) {
+			const auto& instance = instances[i];
+			if (instance.instanceCount == 0) continue;
+			for (size_t p = 0; p < mesh.primitives.size(); p++) {
+				const auto& prim = mesh.primitives[p];
+				const auto& skinOffsets = skinned.offsets[i][p];
+				const bool isSkinned = skinOffsets[0] != INVALID_SIZE_T;
 				std::vector<std::tuple<int, TDataHolder, int>> strides;
 				strides.reserve(prim.attributes.size());
 
@@ -145,23 +408,46 @@ namespace tge::graphics {
 					bufferIndicies.push_back(std::get<1>(stride));
 					bufferOffsets.push_back(std::get<2>(stride));
 				}
+				auto material = materialId[prim.material == -1 ? 0 : prim.material];
+				auto binding = bID;
+				if (isSkinned) {
+					// the skinned permutations read positions, normals and uvs when
+					// present, followed by joints and weights
+					bufferIndicies.clear();
+					bufferOffsets.clear();
+					for (const auto name : { "POSITION", "NORMAL", "TEXCOORD_0" }) {
+						const auto itr = prim.attributes.find(name);
+						if (itr == prim.attributes.end()) continue;
+						const auto& accesor = model.accessors[itr->second];
+						const auto& view = model.bufferViews[accesor.bufferView];
+						bufferIndicies.push_back(dataId[view.buffer]);
+						bufferOffsets.push_back(view.byteOffset + accesor.byteOffset);
+					}
+					bufferIndicies.insert(bufferIndicies.end(), 2, skinned.vertexData);
+					bufferOffsets.insert(bufferOffsets.end(), skinOffsets.begin(),
+						skinOffsets.end());
+					const auto variant = skinnedVariant(prim);
+					material = skinned.materials[variant];
+					binding = skinned.bindings[variant];
+				}
 
 				if (prim.indices >= 0) [[likely]] {
 					const auto& indexAccesor = model.accessors[prim.indices];
 					const auto& indexView = model.bufferViews[indexAccesor.bufferView];
 					const auto indexOffset = indexView.byteOffset + indexAccesor.byteOffset;
 					const IndexSize indextype =
-						indexView.byteStride == 4 ? IndexSize::UINT32 : IndexSize::UINT16;
+						indexAccesor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT
+						? IndexSize::UINT32 : IndexSize::UINT16;
 					const RenderInfo renderInfo = {
 						bufferIndicies,
 						dataId[indexView.buffer],
-						materialId[prim.material == -1 ? 0 : prim.material],
+						material,
 						indexAccesor.count,
-						1,
+						instance.instanceCount,
 						indexOffset,
 						indextype,
 						bufferOffsets,
-						bID, 0, {},
+						binding, instance.firstInstance, {},
 						mesh.name };
 					renderInfos.push_back(renderInfo);
 					}
@@ -171,25 +457,35 @@ namespace tge::graphics {
 					const RenderInfo renderInfo = {
 						bufferIndicies,
 						dataId[0],
-						materialId[prim.material == -1 ? 0 : prim.material],
+						material,
 						0,
-						1,
+						instance.instanceCount,
 						vertAccesor.count,
 						IndexSize::NONE,
 						bufferOffsets,
-						bID, 0, {},
+						binding, instance.firstInstance, {},
 						mesh.name };
 					renderInfos.push_back(renderInfo);
 				}
 			}
 		}
 
+		// One cache reference per glTF buffer, identical buffers share a holder
+		std::vector<TDataHolder> owned(dataId.begin(), dataId.end());
+		owned.push_back(instanceData);
+		if (!(!skinned.vertexData)) owned.push_back(skinned.vertexData);
+		// Bound to the skinned draws, freed once the render and its frames are gone
+		if (!(!skinned.jointData)) owned.push_back(skinned.jointData);
+		if (renderInfos.empty()) {
+			apiLayer->removeData(owned, true);
+			return;
+		}
+		renderInfos.front().ownedData = std::move(owned);
 		apiLayer->pushRender(renderInfos.size(), renderInfos.data());
 	}
 
-	inline std::vector<TNodeHolder> loadNodes(
-		const Model& model, APILayer* apiLayer, GameGraphicsModule* ggm,
-		const std::vector<shader::ShaderPipe>& created) {
+	inline std::vector<TNodeHolder> loadNodes(const Model& model,
+		GameGraphicsModule* ggm) {
 		std::vector<NodeInfo> nodeInfos = {};
 		const auto amount = model.nodes.size();
 		nodeInfos.resize(amount + 1);
@@ -218,14 +514,6 @@ namespace tge::graphics {
 				for (const auto id : node.children) {
 					nodeInfos[id + 1].parent = infoID;
 				}
-				if (node.mesh >= 0 && created.size() > node.mesh) [[likely]] {
-					info.bindingID =
-						apiLayer->getShaderAPI()->createBindings(created[node.mesh])[0];
-					}
-				else {
-					info.bindingID =
-						apiLayer->getShaderAPI()->createBindings(ggm->defaultPipe)[0];
-				}
 			}
 			for (auto& nInfo : nodeInfos) {
 				if (nInfo.parent == INVALID_SIZE_T) {
@@ -233,11 +521,6 @@ namespace tge::graphics {
 				}
 			}
 			}
-		else {
-			const auto startID =
-				apiLayer->getShaderAPI()->createBindings(ggm->defaultPipe)[0];
-			nodeInfos[0].bindingID = startID;
-		}
 		return ggm->addNode(nodeInfos.data(), nodeInfos.size());
 	}
 
@@ -260,40 +543,151 @@ namespace tge::graphics {
 	std::vector<TNodeHolder> GameGraphicsModule::loadModel(
 		const std::vector<char>& data, const bool binary,
 		const std::string& baseDir, void* shaderPipe) {
-		TinyGLTF loader;
-		std::string error;
-		std::string warning;
-		Model model;
-
-		const bool rst =
-			binary ? loader.LoadBinaryFromMemory(&model, &error, &warning,
-				(const uint8_t*)data.data(),
-				data.size(), baseDir)
-			: loader.LoadASCIIFromString(&model, &error, &warning, data.data(),
-				data.size(), baseDir);
-		if (!rst) {
-			PLOG_ERROR << "Loading failed\n" << error << std::endl << warning;
+		return loadModel(std::span(data), binary, baseDir, shaderPipe);
+	}
+
+	std::vector<TNodeHolder> GameGraphicsModule::loadModel(const fs::path& path,
+		void* shaderPipe) {
+		const util::MappedFile file(path);
+		if (!file) {
+			PLOG_ERROR << "Couldn't open model " << path << "!";
 			return {};
 		}
+		return loadModel(file.view(), gltf::isGLB(file.view()),
+			path.parent_path().string(), shaderPipe);
+	}
 
-		if (!warning.empty()) {
-			PLOG_WARNING << warning;
+	std::vector<TNodeHolder> GameGraphicsModule::loadModel(
+		const std::span<const char> data, const bool binary,
+		const std::string& baseDir, void* shaderPipe) {
+		gltf::GLTFView view;
+		std::string error;
+		if (!gltf::parse(data, binary, baseDir, view, error)) {
+			PLOG_ERROR << "Loading failed\n" << error;
+			return {};
 		}
+		const auto& model = view.model;
 
 		const auto samplerId = loadSampler(model, apiLayer);
 
-		const auto textureId = loadTexturesFM(model, apiLayer);
+		const auto textureId = loadTexturesFM(view, apiLayer, workerPool);
 
-		const auto dataId = loadDataBuffers(model, apiLayer);
+		const auto dataId = loadDataBuffers(view, apiLayer);
 
-		std::vector<shader::ShaderPipe> createdShader;
 		std::vector<TPipelineHolder> materials(
-			model.materials.size());  // TODO fix this
-		std::fill(begin(materials), end(materials), defaultMaterial);
+			std::max(model.materials.size(), (size_t)1));  // TODO fix this
+		std::fill(begin(materials), end(materials), instancedMaterial);
 
-		const auto nId = loadNodes(model, apiLayer, this, createdShader);
+		const auto nId = loadNodes(model, this);
 
-		pushRender(model, apiLayer, dataId, materials, nId, this);
+		auto clips = loadAnimations(view);
+		if (!clips.empty()) {
+			std::lock_guard guard(protectAnimation);
+			modelAnimations[nId[0]] = std::move(clips);
+		}
+
+		std::vector<uint32_t> instanceIndices;
+		const auto instances = loadInstances(model, instanceIndices);
+		if (instanceIndices.empty()) {
+			// Nothing of the model is drawn, its buffers are not needed
+			if (!dataId.empty()) apiLayer->removeData(dataId, true);
+			return nId;
+		}
+
+		const BufferInfo instanceInfo{ instanceIndices.data(),
+			instanceIndices.size() * sizeof(uint32_t), DataType::Storage };
+		const auto instanceData = apiLayer->pushData(1, &instanceInfo, "Instances")[0];
+		const auto nodeData = nodeHolder.get<0>(nId[0]);
+
+		auto skinned = loadSkinnedPrimitives(view, apiLayer);
+		size_t jointSize = 0;
+		if (!(!skinned.vertexData)) {
+			SkinSet skinSet;
+			// Index of every skin of the model in skinSet.skins, invalid ones are
+			// left out and their nodes keep the default joints
+			std::vector<size_t> skinIndices(model.skins.size(), INVALID_SIZE_T);
+			for (size_t s = 0; s < model.skins.size(); s++) {
+				const auto& skinIn = model.skins[s];
+				const auto validNode = [&](const int node) {
+					return node >= 0 && (size_t)node < model.nodes.size();
+				};
+				if (!std::ranges::all_of(skinIn.joints, validNode) ||
+					(skinIn.skeleton != -1 && !validNode(skinIn.skeleton))) {
+					PLOG_ERROR << "Skin " << s << " of the model references a node "
+						<< "that does not exist, skipping it!";
+					continue;
+				}
+				skinIndices[s] = skinSet.skins.size();
+				Skin skin;
+				skin.firstJoint = skinSet.jointMatrices.size();
+				skin.joints.reserve(skinIn.joints.size());
+				for (const auto joint : skinIn.joints) skin.joints.push_back(nId[joint + 1]);
+				skin.inverseBindMatrices.resize(skinIn.joints.size(), glm::mat4(1.0f));
+				std::vector<float> matrices;
+				if (gltf::readFloats(view, skinIn.inverseBindMatrices, matrices)) {
+					const auto count = std::min(matrices.size() / 16, skin.joints.size());
+					std::memcpy(skin.inverseBindMatrices.data(), matrices.data(),
+						count * sizeof(glm::mat4));
+				}
+				skinSet.jointMatrices.resize(skinSet.jointMatrices.size() +
+					skin.joints.size(), glm::mat4(1.0f));
+				skinSet.skins.push_back(std::move(skin));
+			}
+			for (size_t i = 0; i < model.nodes.size(); i++) {
+				const auto skin = model.nodes[i].skin;
+				if (skin < 0 || (size_t)skin >= skinIndices.size() ||
+					skinIndices[skin] == INVALID_SIZE_T)
+					continue;
+				nodeHolder.change<5>(nId[i + 1]).data.jointOffset =
+					(uint32_t)skinSet.skins[skinIndices[skin]].firstJoint;
+				nodeHolder.change<4>(nId[i + 1]) = 1;
+			}
+			const BufferInfo jointInfo{ skinSet.jointMatrices.data(),
+				std::max<size_t>(skinSet.jointMatrices.size(), 1) * sizeof(glm::mat4),
+				DataType::Storage };
+			skinSet.jointData = apiLayer->pushData(1, &jointInfo, "Joints")[0];
+			jointSize = jointInfo.size;
+			skinSet.changed = true;
+			skinned.jointData = skinSet.jointData;
+			skinned.materials = skinnedMaterials;
+			std::lock_guard guard(protectAnimation);
+			skinSets.push_back(std::move(skinSet));
+		}
+
+		const auto bindInstances = [&](const tge::shader::ShaderPipe pipe) {
+			const auto bindingSet = apiLayer->getShaderAPI()->createBindings(pipe)[0];
+			std::vector<shader::BindingInfo> bindings(!skinned.jointData ? 4 : 5);
+			for (auto& binding : bindings) binding.bindingSet = bindingSet;
+			bindings[0].type = shader::BindingType::UniformBuffer;
+			bindings[0].binding = 2;
+			bindings[0].data.buffer = { nodeData, sizeof(ValueSystem), 0 };
+			bindings[1].type = shader::BindingType::UniformBuffer;
+			bindings[1].binding = 3;
+			bindings[1].data.buffer = { projection, sizeof(glm::mat4), 0 };
+			bindings[2].type = shader::BindingType::Storage;
+			bindings[2].binding = 4;
+			bindings[2].data.buffer = { nodeData, nId.size() * sizeof(ValueSystem), 0 };
+			bindings[3].type = shader::BindingType::Storage;
+			bindings[3].binding = 5;
+			bindings[3].data.buffer = { instanceData, instanceInfo.size, 0 };
+			if (!(!skinned.jointData)) {
+				bindings[4].type = shader::BindingType::Storage;
+				bindings[4].binding = 6;
+				bindings[4].data.buffer = { skinned.jointData, jointSize, 0 };
+			}
+			apiLayer->getShaderAPI()->bindData(bindings.data(), bindings.size());
+			return bindingSet;
+		};
+		const auto instanceBinding = bindInstances(instancedPipe);
+		if (!(!skinned.vertexData)) {
+			for (size_t i = 0; i < skinnedPipes.size(); i++) {
+				if (skinned.usedVariants[i])
+					skinned.bindings[i] = bindInstances(skinnedPipes[i]);
+			}
+		}
+
+		pushRender(model, apiLayer, dataId, materials, instances, instanceBinding,
+			instanceData, skinned);
 
 		return nId;
 	}
@@ -307,7 +701,16 @@ namespace tge::graphics {
 	constexpr uint8_t AMOUNT_OF_DATA = 2;
 
 	main::Error GameGraphicsModule::init() {
-		assetResolver.push_back(&util::wholeFile);
+		assetResolver.add(&util::wholeFile, "File");
+		if (!features.textureCacheDirectory.empty()) {
+			std::error_code code;
+			std::filesystem::create_directories(features.textureCacheDirectory, code);
+			if (code) {
+				PLOG_WARNING << "Couldn't create texture cache "
+					<< features.textureCacheDirectory << ", textures are decoded on every load!";
+				features.textureCacheDirectory.clear();
+			}
+		}
 		glm::mat4 projView = this->projectionMatrix * this->viewMatrix;
 		std::vector<BufferInfo> bufferInfos = {
 			BufferInfo{&projView, sizeof(glm::mat4), DataType::Uniform} };
@@ -321,8 +724,24 @@ namespace tge::graphics {
 			{ { shader::ShaderType::VERTEX, vertexShader }, { shader::ShaderType::FRAGMENT, fragmentShader } });
 		glbWidget = apiLayer->getShaderAPI()->compile(
 			{ { shader::ShaderType::VERTEX, vertexShader, {"NORMAL", "UV"}}, {shader::ShaderType::FRAGMENT, fragmentShader} });
-		const Material defMat(defaultPipe);
-		defaultMaterial = apiLayer->pushMaterials(1, &defMat)[0];
+		instancedPipe = apiLayer->getShaderAPI()->compile(
+			{ { shader::ShaderType::VERTEX, vertexShader, {"INSTANCED"}}, {shader::ShaderType::FRAGMENT, fragmentShader} });
+		for (size_t i = 0; i < skinnedPipes.size(); i++) {
+			std::vector<std::string> defines;
+			if (i & 1) defines.push_back("NORMAL");
+			if (i & 2) defines.push_back("UV");
+			defines.push_back("INSTANCED");
+			defines.push_back("SKINNED");
+			skinnedPipes[i] = apiLayer->getShaderAPI()->compile(
+				{ { shader::ShaderType::VERTEX, vertexShader, defines}, {shader::ShaderType::FRAGMENT, fragmentShader} });
+		}
+		const std::array defMats = { Material(defaultPipe), Material(instancedPipe),
+			Material(skinnedPipes[0]), Material(skinnedPipes[1]),
+			Material(skinnedPipes[2]), Material(skinnedPipes[3]) };
+		const auto materials = apiLayer->pushMaterials(defMats.size(), defMats.data());
+		defaultMaterial = materials[0];
+		instancedMaterial = materials[1];
+		std::copy(materials.begin() + 2, materials.end(), skinnedMaterials.begin());
 
 		TextureInfo info;
 		info.width = BGAL::width;
@@ -343,12 +762,22 @@ namespace tge::graphics {
 		bufferChange.reserve(128);
 		bufferChange.push_back({ projection, &projectionView, sizeof(glm::mat4), 0 });
 		textureMap[""] = defaultTextureID;
+		streamer.settings.retireTicks = apiLayer->getFramesInFlight();
+		memoryPressureCallback = apiLayer->backend()->addMemoryPressureCallback(
+			[this](const int64_t bytes) {
+				if (bytes > 0) streamer.evict((size_t)bytes);
+				else streamer.relieve((size_t)-bytes);
+			});
 		return main::Error::NONE;
 	}
 
 	void GameGraphicsModule::tick(double time) {
+		animations.update(time, { nodeHolder.mutex, nodeHolder.translationTable,
+			std::get<1>(nodeHolder.internalValues), std::get<4>(nodeHolder.internalValues) },
+			workerPool);
 		const auto size = nodeHolder.size();
 		std::lock_guard guard(nodeHolder.mutex);
+		updatedNodes.assign(size, 0);
 		projectionView = this->projectionMatrix * this->viewMatrix;
 		bufferChange.resize(1);
 		const auto& parents = std::get<2>(nodeHolder.internalValues);
@@ -378,468 +807,629 @@ namespace tge::graphics {
 				bufferChange.emplace_back(dataHolder[i], &modelMatrices[i],
 					sizeof(ValueSystem), system.offset);
 				statuses[i] = 0;
+				updatedNodes[i] = 1;
 			}
 		}
+		updateSkins();
 		apiLayer->changeData(bufferChange.size(), bufferChange.data());
+		updateStreaming();
 	}
 
-	void GameGraphicsModule::destroy() {}
-
-	std::vector<TextureInfo> loadSTBI(
-		const std::vector<TextureLoadInternal>& data) {
-		std::vector<TextureInfo> textureInfos;
-		textureInfos.reserve(data.size());
-		for (const auto& values : data) {
-			const auto& dataIn = values.textureInfo;
-			if (dataIn.empty()) {
-				PLOG_FATAL << "Found empty texture!";
-				exit(-1);
-				continue;
-			}
-			TextureInfo info;
-			info.data = stbi_load_from_memory((stbi_uc*)dataIn.data(), dataIn.size(),
-				(int*)&info.width, (int*)&info.height,
-				(int*)&info.channel, 0);
-			info.size = info.width * info.height * info.channel;
-			info.debugInfo = values.debugName;
-			if (info.channel == 3) {
-				PLOG_FATAL << "Texture with 3 channels not supported!";
-				exit(-1);
-				continue;
+	void GameGraphicsModule::updateSkins() {
+		std::lock_guard guard(protectAnimation);
+		if (skinSets.empty()) return;
+		const auto& modelMatrices = std::get<5>(nodeHolder.internalValues);
+		workerPool.parallelFor(skinSets.size(), 4, [&](size_t begin, size_t end) {
+			for (size_t s = begin; s < end; s++) {
+				auto& skinSet = skinSets[s];
+				for (const auto& skin : skinSet.skins) {
+					for (size_t j = 0; j < skin.joints.size(); j++) {
+						const auto found =
+							nodeHolder.translationTable.find(skin.joints[j].internalHandle);
+						if (found == std::end(nodeHolder.translationTable)) {
+							skinSet.alive = false;
+							break;
+						}
+						if (!updatedNodes[found->second]) continue;
+						skinSet.jointMatrices[skin.firstJoint + j] =
+							modelMatrices[found->second].model * skin.inverseBindMatrices[j];
+						skinSet.changed = true;
+					}
+				}
 			}
-			textureInfos.push_back(info);
+			});
+
+		for (auto& skinSet : skinSets) {
+			if (!skinSet.alive || !skinSet.changed) continue;
+			skinSet.changed = false;
+			bufferChange.emplace_back(skinSet.jointData, skinSet.jointMatrices.data(),
+				skinSet.jointMatrices.size() * sizeof(glm::mat4), 0);
 		}
-		return textureInfos;
+		// The joint buffer is owned by the skinned render, it is released with it
+		std::erase_if(skinSets, [](const SkinSet& skinSet) { return !skinSet.alive; });
+	}
+
+	TAnimationHolder GameGraphicsModule::playAnimation(
+		const std::span<const TNodeHolder> model, const size_t clip,
+		const float weight, const bool loop) {
+		if (model.empty()) return TAnimationHolder();
+		const auto clips = getAnimations(model[0]);
+		if (clip >= clips.size()) {
+			PLOG_ERROR << "Animation " << clip << " not found!";
+			return TAnimationHolder();
+		}
+		AnimationInfo info;
+		info.clip = clips[clip];
+		info.targets.assign(model.begin() + 1, model.end());
+		info.weight = weight;
+		info.loop = loop;
+		return animations.play(std::span(&info, 1))[0];
 	}
 
-	inline size_t fromDXGI(ddspp::DXGIFormat format) {
+	void GameGraphicsModule::destroy() {
+		if (memoryPressureCallback != INVALID_SIZE_T)
+			apiLayer->backend()->removeMemoryPressureCallback(memoryPressureCallback);
+		for (auto& upload : streamUploads) upload.texture.wait();
+		streamUploads.clear();
+	}
+
+	// Typeless formats are read as their unorm or float variant, formats
+	// without a Vulkan equivalent are undefined
+	inline vk::Format fromDXGI(ddspp::DXGIFormat format) {
+		using vk::Format;
 		switch (format) {
-		case ddspp::UNKNOWN:
-			return (size_t)vk::Format::eUndefined;
 		case ddspp::R32G32B32A32_TYPELESS:
-			break;
 		case ddspp::R32G32B32A32_FLOAT:
-			break;
+			return Format::eR32G32B32A32Sfloat;
 		case ddspp::R32G32B32A32_UINT:
-			break;
+			return Format::eR32G32B32A32Uint;
 		case ddspp::R32G32B32A32_SINT:
-			break;
+			return Format::eR32G32B32A32Sint;
 		case ddspp::R32G32B32_TYPELESS:
-			break;
 		case ddspp::R32G32B32_FLOAT:
-			break;
+			return Format::eR32G32B32Sfloat;
 		case ddspp::R32G32B32_UINT:
-			break;
+			return Format::eR32G32B32Uint;
 		case ddspp::R32G32B32_SINT:
-			break;
+			return Format::eR32G32B32Sint;
 		case ddspp::R16G16B16A16_TYPELESS:
-			break;
 		case ddspp::R16G16B16A16_FLOAT:
-			break;
+			return Format::eR16G16B16A16Sfloat;
 		case ddspp::R16G16B16A16_UNORM:
-			break;
+			return Format::eR16G16B16A16Unorm;
 		case ddspp::R16G16B16A16_UINT:
-			break;
+			return Format::eR16G16B16A16Uint;
 		case ddspp::R16G16B16A16_SNORM:
-			break;
+			return Format::eR16G16B16A16Snorm;
 		case ddspp::R16G16B16A16_SINT:
-			break;
+			return Format::eR16G16B16A16Sint;
 		case ddspp::R32G32_TYPELESS:
-			break;
 		case ddspp::R32G32_FLOAT:
-			break;
+			return Format::eR32G32Sfloat;
 		case ddspp::R32G32_UINT:
-			break;
+			return Format::eR32G32Uint;
 		case ddspp::R32G32_SINT:
-			break;
-		case ddspp::R32G8X24_TYPELESS:
-			break;
-		case ddspp::D32_FLOAT_S8X24_UINT:
-			break;
-		case ddspp::R32_FLOAT_X8X24_TYPELESS:
-			break;
-		case ddspp::X32_TYPELESS_G8X24_UINT:
-			break;
+			return Format::eR32G32Sint;
 		case ddspp::R10G10B10A2_TYPELESS:
-			break;
 		case ddspp::R10G10B10A2_UNORM:
-			break;
+			return Format::eA2B10G10R10UnormPack32;
 		case ddspp::R10G10B10A2_UINT:
-			break;
+			return Format::eA2B10G10R10UintPack32;
 		case ddspp::R11G11B10_FLOAT:
-			break;
+			return Format::eB10G11R11UfloatPack32;
 		case ddspp::R8G8B8A8_TYPELESS:
-			break;
 		case ddspp::R8G8B8A8_UNORM:
-			break;
+			return Format::eR8G8B8A8Unorm;
 		case ddspp::R8G8B8A8_UNORM_SRGB:
-			break;
+			return Format::eR8G8B8A8Srgb;
 		case ddspp::R8G8B8A8_UINT:
-			break;
+			return Format::eR8G8B8A8Uint;
 		case ddspp::R8G8B8A8_SNORM:
-			break;
+			return Format::eR8G8B8A8Snorm;
 		case ddspp::R8G8B8A8_SINT:
-			break;
+			return Format::eR8G8B8A8Sint;
 		case ddspp::R16G16_TYPELESS:
-			break;
 		case ddspp::R16G16_FLOAT:
-			break;
+			return Format::eR16G16Sfloat;
 		case ddspp::R16G16_UNORM:
-			break;
+			return Format::eR16G16Unorm;
 		case ddspp::R16G16_UINT:
-			break;
+			return Format::eR16G16Uint;
 		case ddspp::R16G16_SNORM:
-			break;
+			return Format::eR16G16Snorm;
 		case ddspp::R16G16_SINT:
-			break;
+			return Format::eR16G16Sint;
 		case ddspp::R32_TYPELESS:
-			break;
-		case ddspp::D32_FLOAT:
-			break;
 		case ddspp::R32_FLOAT:
-			break;
+			return Format::eR32Sfloat;
 		case ddspp::R32_UINT:
-			break;
+			return Format::eR32Uint;
 		case ddspp::R32_SINT:
-			break;
-		case ddspp::R24G8_TYPELESS:
-			break;
-		case ddspp::D24_UNORM_S8_UINT:
-			break;
-		case ddspp::R24_UNORM_X8_TYPELESS:
-			break;
-		case ddspp::X24_TYPELESS_G8_UINT:
-			break;
+			return Format::eR32Sint;
 		case ddspp::R8G8_TYPELESS:
-			break;
 		case ddspp::R8G8_UNORM:
-			break;
+			return Format::eR8G8Unorm;
 		case ddspp::R8G8_UINT:
-			break;
+			return Format::eR8G8Uint;
 		case ddspp::R8G8_SNORM:
-			break;
+			return Format::eR8G8Snorm;
 		case ddspp::R8G8_SINT:
-			break;
+			return Format::eR8G8Sint;
 		case ddspp::R16_TYPELESS:
-			break;
 		case ddspp::R16_FLOAT:
-			break;
-		case ddspp::D16_UNORM:
-			break;
+			return Format::eR16Sfloat;
 		case ddspp::R16_UNORM:
-			break;
+			return Format::eR16Unorm;
 		case ddspp::R16_UINT:
-			break;
+			return Format::eR16Uint;
 		case ddspp::R16_SNORM:
-			break;
+			return Format::eR16Snorm;
 		case ddspp::R16_SINT:
-			break;
+			return Format::eR16Sint;
 		case ddspp::R8_TYPELESS:
-			break;
 		case ddspp::R8_UNORM:
-			break;
+			return Format::eR8Unorm;
 		case ddspp::R8_UINT:
-			break;
+			return Format::eR8Uint;
 		case ddspp::R8_SNORM:
-			break;
+			return Format::eR8Snorm;
 		case ddspp::R8_SINT:
-			break;
-		case ddspp::A8_UNORM:
-			break;
-		case ddspp::R1_UNORM:
-			break;
+			return Format::eR8Sint;
 		case ddspp::R9G9B9E5_SHAREDEXP:
-			break;
-		case ddspp::R8G8_B8G8_UNORM:
-			break;
-		case ddspp::G8R8_G8B8_UNORM:
-			break;
+			return Format::eE5B9G9R9UfloatPack32;
 		case ddspp::BC1_TYPELESS:
 		case ddspp::BC1_UNORM:
-			return (size_t)vk::Format::eBc1RgbaUnormBlock;
+			return Format::eBc1RgbaUnormBlock;
 		case ddspp::BC1_UNORM_SRGB:
-			return (size_t)vk::Format::eBc1RgbUnormBlock;
+			return Format::eBc1RgbaSrgbBlock;
 		case ddspp::BC2_TYPELESS:
-			break;
 		case ddspp::BC2_UNORM:
-			break;
+			return Format::eBc2UnormBlock;
 		case ddspp::BC2_UNORM_SRGB:
-			break;
+			return Format::eBc2SrgbBlock;
 		case ddspp::BC3_TYPELESS:
 		case ddspp::BC3_UNORM:
-			return (size_t)vk::Format::eBc3UnormBlock;
+			return Format::eBc3UnormBlock;
 		case ddspp::BC3_UNORM_SRGB:
-			return (size_t)vk::Format::eBc3SrgbBlock;
+			return Format::eBc3SrgbBlock;
 		case ddspp::BC4_TYPELESS:
-			break;
 		case ddspp::BC4_UNORM:
-			break;
+			return Format::eBc4UnormBlock;
 		case ddspp::BC4_SNORM:
-			break;
+			return Format::eBc4SnormBlock;
 		case ddspp::BC5_TYPELESS:
-			break;
 		case ddspp::BC5_UNORM:
-			break;
+			return Format::eBc5UnormBlock;
 		case ddspp::BC5_SNORM:
-			break;
+			return Format::eBc5SnormBlock;
 		case ddspp::B5G6R5_UNORM:
-			break;
+			return Format::eR5G6B5UnormPack16;
 		case ddspp::B5G5R5A1_UNORM:
-			break;
+			return Format::eA1R5G5B5UnormPack16;
+		case ddspp::B8G8R8A8_TYPELESS:
 		case ddspp::B8G8R8A8_UNORM:
-			break;
+		case ddspp::B8G8R8X8_TYPELESS:
 		case ddspp::B8G8R8X8_UNORM:
-			break;
-		case ddspp::R10G10B10_XR_BIAS_A2_UNORM:
-			break;
-		case ddspp::B8G8R8A8_TYPELESS:
-			break;
+			return Format::eB8G8R8A8Unorm;
 		case ddspp::B8G8R8A8_UNORM_SRGB:
-			break;
-		case ddspp::B8G8R8X8_TYPELESS:
-			break;
 		case ddspp::B8G8R8X8_UNORM_SRGB:
-			break;
+			return Format::eB8G8R8A8Srgb;
 		case ddspp::BC6H_TYPELESS:
-			break;
 		case ddspp::BC6H_UF16:
-			break;
+			return Format::eBc6HUfloatBlock;
 		case ddspp::BC6H_SF16:
-			break;
+			return Format::eBc6HSfloatBlock;
 		case ddspp::BC7_TYPELESS:
-			break;
 		case ddspp::BC7_UNORM:
-			break;
+			return Format::eBc7UnormBlock;
 		case ddspp::BC7_UNORM_SRGB:
-			break;
-		case ddspp::AYUV:
-			break;
-		case ddspp::Y410:
-			break;
-		case ddspp::Y416:
-			break;
-		case ddspp::NV12:
-			break;
-		case ddspp::P010:
-			break;
-		case ddspp::P016:
-			break;
-		case ddspp::OPAQUE_420:
-			break;
-		case ddspp::YUY2:
-			break;
-		case ddspp::Y210:
-			break;
-		case ddspp::Y216:
-			break;
-		case ddspp::NV11:
-			break;
-		case ddspp::AI44:
-			break;
-		case ddspp::IA44:
-			break;
-		case ddspp::P8:
-			break;
-		case ddspp::A8P8:
-			break;
-		case ddspp::B4G4R4A4_UNORM:
-			break;
-		case ddspp::P208:
-			break;
-		case ddspp::V208:
-			break;
-		case ddspp::V408:
-			break;
-		case ddspp::ASTC_4X4_TYPELESS:
-			break;
-		case ddspp::ASTC_4X4_UNORM:
-			break;
-		case ddspp::ASTC_4X4_UNORM_SRGB:
-			break;
-		case ddspp::ASTC_5X4_TYPELESS:
-			break;
-		case ddspp::ASTC_5X4_UNORM:
-			break;
-		case ddspp::ASTC_5X4_UNORM_SRGB:
-			break;
-		case ddspp::ASTC_5X5_TYPELESS:
-			break;
-		case ddspp::ASTC_5X5_UNORM:
-			break;
-		case ddspp::ASTC_5X5_UNORM_SRGB:
-			break;
-		case ddspp::ASTC_6X5_TYPELESS:
-			break;
-		case ddspp::ASTC_6X5_UNORM:
-			break;
-		case ddspp::ASTC_6X5_UNORM_SRGB:
-			break;
-		case ddspp::ASTC_6X6_TYPELESS:
-			break;
-		case ddspp::ASTC_6X6_UNORM:
-			break;
-		case ddspp::ASTC_6X6_UNORM_SRGB:
-			break;
-		case ddspp::ASTC_8X5_TYPELESS:
-			break;
-		case ddspp::ASTC_8X5_UNORM:
-			break;
-		case ddspp::ASTC_8X5_UNORM_SRGB:
-			break;
-		case ddspp::ASTC_8X6_TYPELESS:
-			break;
-		case ddspp::ASTC_8X6_UNORM:
-			break;
-		case ddspp::ASTC_8X6_UNORM_SRGB:
-			break;
-		case ddspp::ASTC_8X8_TYPELESS:
-			break;
-		case ddspp::ASTC_8X8_UNORM:
-			break;
-		case ddspp::ASTC_8X8_UNORM_SRGB:
-			break;
-		case ddspp::ASTC_10X5_TYPELESS:
-			break;
-		case ddspp::ASTC_10X5_UNORM:
-			break;
-		case ddspp::ASTC_10X5_UNORM_SRGB:
-			break;
-		case ddspp::ASTC_10X6_TYPELESS:
-			break;
-		case ddspp::ASTC_10X6_UNORM:
-			break;
-		case ddspp::ASTC_10X6_UNORM_SRGB:
-			break;
-		case ddspp::ASTC_10X8_TYPELESS:
-			break;
-		case ddspp::ASTC_10X8_UNORM:
-			break;
-		case ddspp::ASTC_10X8_UNORM_SRGB:
-			break;
-		case ddspp::ASTC_10X10_TYPELESS:
-			break;
-		case ddspp::ASTC_10X10_UNORM:
-			break;
-		case ddspp::ASTC_10X10_UNORM_SRGB:
-			break;
-		case ddspp::ASTC_12X10_TYPELESS:
-			break;
-		case ddspp::ASTC_12X10_UNORM:
-			break;
-		case ddspp::ASTC_12X10_UNORM_SRGB:
-			break;
-		case ddspp::ASTC_12X12_TYPELESS:
-			break;
-		case ddspp::ASTC_12X12_UNORM:
-			break;
-		case ddspp::ASTC_12X12_UNORM_SRGB:
-			break;
-		case ddspp::FORCE_UINT:
-			break;
+			return Format::eBc7SrgbBlock;
 		default:
-			break;
+			return Format::eUndefined;
 		}
-		throw std::runtime_error("Translation table not found for DXGI!");
 	}
 
-	std::vector<TextureInfo> loadDDS(const std::vector<TextureLoadInternal>& data) {
-		std::vector<TextureInfo> textureInfos;
-		textureInfos.reserve(data.size());
-		for (const auto& values : data) {
+	std::vector<TextureInfo> loadDDS(APILayer* apiLayer,
+		const std::vector<TextureLoadInternal>& data,
+		const std::vector<size_t>& indices) {
+		std::vector<TextureInfo> textureInfos(indices.size());
+		for (size_t i = 0; i < indices.size(); i++) {
+			const auto& values = data[indices[i]];
 			const auto& ddsVec = values.textureInfo;
 			if (ddsVec.empty()) {
-				PLOG_ERROR << "Found empty texture";
+				PLOG_ERROR << "Found empty texture " << values.debugName << "!";
 				continue;
 			}
 			uint8_t* ddsData = (uint8_t*)ddsVec.data();
 			ddspp::Descriptor desc;
 			const auto result = ddspp::decode_header(ddsData, desc);
-			if (result == ddspp::Result::Error) {
-				PLOG_ERROR << "DDS texture not valid!";
+			if (result == ddspp::Result::Error || desc.headerSize > ddsVec.size()) {
+				PLOG_ERROR << "DDS texture " << values.debugName << " not valid!";
 				continue;
 			}
-			TextureInfo info;
+			if (desc.type == ddspp::Texture3D || desc.type == ddspp::Texture1D) {
+				PLOG_ERROR << "DDS texture " << values.debugName
+					<< " is not a 2D texture, array or cubemap!";
+				continue;
+			}
+			const auto format = fromDXGI(desc.format);
+			if (format == vk::Format::eUndefined ||
+				!apiLayer->isTextureFormatSupported((size_t)format, false)) {
+				PLOG_ERROR << "DDS format " << (uint32_t)desc.format << " of "
+					<< values.debugName << " not supported!";
+				continue;
+			}
+			TextureInfo& info = textureInfos[i];
 			info.data = ddsData + desc.headerSize;
 			info.width = desc.width;
 			info.height = desc.height;
 			info.size = ddsVec.size() - desc.headerSize;
-			info.internalFormatOverride = fromDXGI(desc.format);
+			info.internalFormatOverride = (size_t)format;
 			info.mipMapOverrider = desc.numMips;
 			info.blitMode = BlitMode::NONE;
+			info.cubemap = desc.type == ddspp::Cubemap;
+			info.opaque = desc.format == ddspp::B8G8R8X8_TYPELESS ||
+				desc.format == ddspp::B8G8R8X8_UNORM ||
+				desc.format == ddspp::B8G8R8X8_UNORM_SRGB;
+			info.layers = std::max(desc.arraySize, 1u) * (info.cubemap ? 6 : 1);
 			info.debugInfo = values.debugName;
-			textureInfos.push_back(info);
 		}
 		return textureInfos;
 	}
 
-	std::vector<TTextureHolder> GameGraphicsModule::loadTextures(
+	inline std::shared_ptr<const StreamSource> makeStreamSource(
+		const TextureInfo& info, const uint32_t blockWidth,
+		const uint32_t blockHeight, const size_t blockBytes) {
+		const auto levels = info.mipMapOverrider == INVALID_UINT32 ? 1u
+			: std::max(info.mipMapOverrider, 1u);
+		auto source = makeStreamSource(std::span(info.data, info.size),
+			info.width, info.height, levels, blockWidth, blockHeight, blockBytes);
+		if (!source) {
+			PLOG_ERROR << "Texture " << info.debugInfo << " is too short for "
+				<< levels << " levels!";
+			return nullptr;
+		}
+		source->format = info.internalFormatOverride;
+		source->channel = info.channel;
+		source->grayscale = info.grayscale;
+		source->opaque = info.opaque;
+		source->blitMips = info.blitMode == BlitMode::LINEAR;
+		source->debugInfo = info.debugInfo;
+		return source;
+	}
+
+	// All levels of a streamed texture from first down
+	inline TextureInfo streamedTextureInfo(const StreamSource& source,
+		const uint32_t first) {
+		TextureInfo info;
+		info.data = (uint8_t*)source.data.data() + source.offsets[first];
+		info.size = (uint32_t)source.residentSize(first);
+		info.width = std::max(source.width >> first, 1u);
+		info.height = std::max(source.height >> first, 1u);
+		info.channel = source.channel;
+		info.internalFormatOverride = source.format;
+		info.grayscale = source.grayscale;
+		info.opaque = source.opaque;
+		info.debugInfo = source.debugInfo;
+		if (!source.blitMips) {
+			info.mipMapOverrider = source.levels() - first;
+			info.blitMode = BlitMode::NONE;
+		}
+		return info;
+	}
+
+	inline std::vector<std::shared_ptr<const StreamSource>> loadStreamSources(
+		APILayer* apiLayer, util::WorkerPool& pool,
 		const std::vector<TextureLoadInternal>& data, const LoadType type) {
-		if (data.empty()) return {};
-		std::vector<TextureInfo> textureInfos;
+		std::vector<std::shared_ptr<const StreamSource>> sources(data.size());
+		if (type == LoadType::DDSPP) {
+			std::vector<size_t> indices(data.size());
+			for (size_t i = 0; i < indices.size(); i++) indices[i] = i;
+			const auto infos = loadDDS(apiLayer, data, indices);
+			for (size_t i = 0; i < infos.size(); i++) {
+				if (infos[i].data == nullptr) continue;
+				if (infos[i].layers != 1) {
+					PLOG_ERROR << "DDS texture " << data[i].debugName
+						<< " is an array or cubemap and can't be streamed!";
+					continue;
+				}
+				ddspp::Descriptor desc;
+				(void)ddspp::decode_header((uint8_t*)data[i].textureInfo.data(), desc);
+				sources[i] = makeStreamSource(infos[i], desc.blockWidth,
+					desc.blockHeight, desc.bitsPerPixelOrBlock / 8);
+			}
+			return sources;
+		}
+		auto formats = queryTextureFormats(apiLayer);
+		formats.cpuMips = true;
+		formats.mips.levels = UINT32_MAX;
+		const bool compressed = formats.compression != BlockFormat::NONE;
+		pool.parallelFor(data.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				TextureInfo info;
+				if (!decodeSTBI(data[i].textureInfo, data[i].debugName, formats, info))
+					continue;
+				util::OnExit freeData([&] { free(info.data); });
+				sources[i] = compressed
+					? makeStreamSource(info, 4, 4, blockSize(formats.compression))
+					: makeStreamSource(info, 1, 1, texelBytes(info, formats));
+			}
+			});
+		return sources;
+	}
 
-		util::OnExit onExit([tinfos = &textureInfos, type = type] {
-			if (type != LoadType::STBI) return;
-			for (const auto& tex : *tinfos)
-				if (tex.data != nullptr) free(tex.data);
+	std::vector<TStreamHolder> GameGraphicsModule::loadStreamed(
+		const std::vector<std::string>& names, const LoadType type) {
+		const auto files = assetResolver.resolve(names);
+		std::vector<TextureLoadInternal> data;
+		std::vector<size_t> dataIndices;
+		data.reserve(files.size());
+		dataIndices.reserve(files.size());
+		for (size_t i = 0; i < files.size(); i++) {
+			if (!files[i]) {
+				PLOG_ERROR << "Couldn't find asset: " << names[i] << "!";
+				continue;
+			}
+			data.emplace_back(*files[i], names[i]);
+			dataIndices.push_back(i);
+		}
+		std::vector<TStreamHolder> streams(names.size());
+		if (data.empty()) return streams;
+		const auto sources = loadStreamSources(apiLayer, workerPool, data, type);
+
+		std::vector<TextureInfo> tails;
+		std::vector<size_t> tailIndices;
+		tails.reserve(sources.size());
+		tailIndices.reserve(sources.size());
+		for (size_t i = 0; i < sources.size(); i++) {
+			if (!sources[i]) continue;
+			tails.push_back(streamedTextureInfo(*sources[i],
+				streamer.tailLevel(*sources[i])));
+			tailIndices.push_back(i);
+		}
+		if (tails.empty()) return streams;
+		const auto textures = apiLayer->pushTexture(tails.size(), tails.data());
+		for (size_t i = 0; i < textures.size(); i++) {
+			const auto index = tailIndices[i];
+			streams[dataIndices[index]] = streamer.add(sources[index], textures[i]);
+		}
+		return streams;
+	}
+
+	std::vector<AtlasTexture> GameGraphicsModule::loadAtlas(
+		const std::vector<std::string>& names, const AtlasSettings& settings) {
+		std::vector<AtlasTexture> atlas(names.size(), { defaultTextureID });
+		const auto files = assetResolver.resolve(names);
+		std::vector<size_t> dataIndices;
+		dataIndices.reserve(files.size());
+		for (size_t i = 0; i < files.size(); i++) {
+			if (!files[i]) {
+				PLOG_ERROR << "Couldn't find asset: " << names[i] << "!";
+				continue;
+			}
+			dataIndices.push_back(i);
+		}
+		if (dataIndices.empty()) return atlas;
+
+		auto formats = queryTextureFormats(apiLayer);
+		formats.compression = BlockFormat::NONE;
+		formats.cpuMips = false;
+		std::vector<TextureInfo> infos(dataIndices.size());
+		util::OnExit onExit([&] {
+			for (const auto& info : infos) free(info.data);
+			});
+		workerPool.parallelFor(dataIndices.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				const auto index = dataIndices[i];
+				decodeSTBI(*files[index], names[index], formats, infos[i]);
+			}
 			});
 
-		if (type == LoadType::STBI) {
-			textureInfos = loadSTBI(data);
+		// Every format gets its own pages, the pages and the textures that
+		// were not packed are pushed together
+		std::unordered_map<size_t, std::vector<size_t>> groups;
+		for (size_t i = 0; i < infos.size(); i++) {
+			if (infos[i].data != nullptr)
+				groups[infos[i].internalFormatOverride].push_back(i);
 		}
-		else if (type == LoadType::DDSPP) {
-			textureInfos = loadDDS(data);
+		std::vector<std::vector<uint8_t>> pageData;
+		std::vector<TextureInfo> toPush;
+		std::vector<size_t> pushIndex(names.size(), INVALID_SIZE_T);
+		for (const auto& [format, members] : groups) {
+			std::vector<std::array<uint32_t, 2>> sizes;
+			sizes.reserve(members.size());
+			for (const auto member : members)
+				sizes.push_back({ infos[member].width, infos[member].height });
+			const auto layout = packAtlas(sizes, settings);
+			const auto& first = infos[members[0]];
+			const size_t texelSize = first.size / ((size_t)first.width * first.height);
+			const auto firstPage = toPush.size();
+			const auto firstPageData = pageData.size();
+			for (const auto& [width, height] : layout.pages) {
+				auto& page = pageData.emplace_back((size_t)width * height * texelSize);
+				TextureInfo info;
+				info.data = page.data();
+				info.size = (uint32_t)page.size();
+				info.width = width;
+				info.height = height;
+				info.channel = first.channel;
+				info.internalFormatOverride = format;
+				info.grayscale = first.grayscale;
+				info.mipMapOverrider = atlasMipLevels(settings.padding);
+				info.debugInfo = "Atlas";
+				toPush.push_back(info);
+			}
+			for (size_t k = 0; k < members.size(); k++) {
+				const auto& info = infos[members[k]];
+				const auto& rect = layout.rects[k];
+				const auto index = dataIndices[members[k]];
+				if (rect.page == INVALID_UINT32) {
+					pushIndex[index] = toPush.size();
+					toPush.push_back(info);
+					continue;
+				}
+				const auto [pageWidth, pageHeight] = layout.pages[rect.page];
+				copyToPage(info.data, info.width, info.height, texelSize, rect,
+					settings.padding, pageData[firstPageData + rect.page].data(),
+					pageWidth, pageHeight);
+				pushIndex[index] = firstPage + rect.page;
+				atlas[index].uvTransform = glm::vec4(
+					(float)info.width / pageWidth, (float)info.height / pageHeight,
+					(float)rect.x / pageWidth, (float)rect.y / pageHeight);
+			}
 		}
-		else {
-			throw std::runtime_error("Wrong load type!");
+		if (toPush.empty()) return atlas;
+		const auto textures = apiLayer->pushTexture(toPush.size(), toPush.data());
+		for (size_t i = 0; i < atlas.size(); i++) {
+			if (pushIndex[i] < textures.size()) atlas[i].texture = textures[pushIndex[i]];
 		}
+		return atlas;
+	}
 
-		return apiLayer->pushTexture(textureInfos.size(), textureInfos.data());
+	void GameGraphicsModule::bindStreamed(const TStreamHolder stream,
+		const shader::BindingInfo& binding) {
+		auto bound = binding;
+		const auto texture = streamer.bind(stream, binding);
+		bound.data.texture.texture = !texture ? defaultTextureID : texture;
+		apiLayer->getShaderAPI()->bindData(&bound, 1);
+	}
+
+	float GameGraphicsModule::projectedSize(const TNodeHolder node,
+		const float radius) {
+		const auto model = nodeHolder.get<5>(node).model;
+		const auto scale = std::max({ glm::length(glm::vec3(model[0])),
+			glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+		const auto extent = apiLayer->getRenderExtent();
+		const auto worldRadius = radius * scale;
+		const auto distance = -(viewMatrix * model[3]).z;
+		if (distance <= worldRadius) return std::max(extent.x, extent.y);
+		return worldRadius * std::abs(projectionMatrix[1][1]) / distance * extent.y;
+	}
+
+	// Uploads run on the worker pool through pushTexture, so only finished
+	// ones are swapped in and the frame never waits on them
+	void GameGraphicsModule::updateStreaming() {
+		std::vector<shader::BindingInfo> bindings;
+		std::erase_if(streamUploads, [&](StreamUpload& upload) {
+			if (upload.texture.wait_for(std::chrono::seconds(0)) !=
+				std::future_status::ready)
+				return false;
+			TTextureHolder texture;
+			try {
+				texture = upload.texture.get();
+			}
+			catch (const std::exception& exception) {
+				PLOG_ERROR << "Streaming upload failed: " << exception.what();
+			}
+			const auto swapped = streamer.complete(upload.stream, upload.firstLevel,
+				texture);
+			bindings.insert(bindings.end(), swapped.begin(), swapped.end());
+			return true;
+			});
+		if (!bindings.empty()) {
+			// The swapped descriptor sets are used by the frames in flight
+			auto guard = apiLayer->lockFrames();
+			apiLayer->getShaderAPI()->bindData(bindings.data(), bindings.size());
+		}
+		const auto retired = streamer.takeRetired();
+		if (!retired.empty()) apiLayer->removeTextures(retired);
+
+		for (auto& change : streamer.plan()) {
+			auto texture = workerPool.submit([this, change] {
+				const auto info = streamedTextureInfo(*change.source, change.firstLevel);
+				return apiLayer->pushTexture(1, &info)[0];
+				});
+			streamUploads.push_back({ change.stream, change.firstLevel,
+				std::move(texture) });
+		}
 	}
 
 	std::vector<TTextureHolder> GameGraphicsModule::loadTextures(
-		const std::vector<std::string>& names, const LoadType type) {
+		const std::vector<TextureLoadInternal>& data, const LoadType type,
+		const bool color) {
+		if (data.empty()) return {};
+		std::vector<uint64_t> hashes(data.size());
+		workerPool.parallelFor(data.size(), 8, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				const auto& texture = data[i].textureInfo;
+				hashes[i] = util::hash64(texture.data(), texture.size(),
+					textureSeed(type, color));
+			}
+			});
+
+		auto textures = pushCached(apiLayer->backend()->textureCache, hashes,
+			[&](const std::vector<size_t>& toPush) {
+				if (type == LoadType::STBI) {
+					const auto decoded = loadSTBI(workerPool, data, hashes, toPush,
+						queryTextureFormats(apiLayer, color));
+					return pushDecoded(apiLayer, decoded.infos);
+				}
+				else if (type == LoadType::DDSPP) {
+					return pushDecoded(apiLayer, loadDDS(apiLayer, data, toPush));
+				}
+				throw std::runtime_error("Wrong load type!");
+			});
+		for (auto& texture : textures) {
+			if (!texture) texture = defaultTextureID;
+		}
+		return textures;
+	}
+
+	std::vector<TTextureHolder> GameGraphicsModule::loadTextures(
+		const std::vector<std::string>& names, const LoadType type,
+		const bool color) {
 		const auto amount = names.size();
 		std::vector<TTextureHolder> localtextureIDs(amount);
-		std::vector<TextureLoadInternal> data;
-		data.reserve(amount);
-		for (size_t i = 0; i < amount; i++) {
-			const auto& name = names[i];
-			{
-				std::lock_guard guard(protectTexture);
-				auto found = textureMap.find(name);
+		std::vector<std::string> toResolve;
+		toResolve.reserve(amount);
+		{
+			std::lock_guard guard(protectTexture);
+			for (size_t i = 0; i < amount; i++) {
+				auto found = textureMap.find(names[i]);
 				if (found != std::end(textureMap)) {
 					localtextureIDs[i] = found->second;
 					continue;
 				}
+				toResolve.push_back(names[i]);
 			}
-			std::vector<char> file;
-			for (auto& function : assetResolver) {
-				file = function(name);
-				if (!file.empty()) break;
-			}
-			if (file.empty()) {
-				localtextureIDs[i] = defaultTextureID;
-				textureMap[names[i]] = defaultTextureID;
-				PLOG_ERROR << "Couldn't find asset: " << name << "!";
+		}
+		std::ranges::sort(toResolve);
+		const auto [first, last] = std::ranges::unique(toResolve);
+		toResolve.erase(first, last);
+
+		const auto files = assetResolver.resolve(toResolve);
+		std::vector<TextureLoadInternal> data;
+		std::vector<std::string> loadedNames;
+		data.reserve(files.size());
+		loadedNames.reserve(files.size());
+		std::unordered_map<std::string, TTextureHolder> resolved;
+		for (size_t i = 0; i < files.size(); i++) {
+			if (!files[i]) {
+				PLOG_ERROR << "Couldn't find asset: " << toResolve[i] << "!";
+				resolved[toResolve[i]] = defaultTextureID;
 				continue;
 			}
-			data.emplace_back(file, name);
-			localtextureIDs[i] = TTextureHolder();
+			data.emplace_back(*files[i], toResolve[i]);
+			loadedNames.push_back(toResolve[i]);
 		}
 		if (!data.empty()) {
-			const auto startTexture = loadTextures(data, type);
-			size_t nameID = 0;
-			for (size_t i = 0; i < names.size(); i++) {
-				if (!textureMap.contains(names[i])) {
-					textureMap[names[i]] = startTexture[nameID];
-					localtextureIDs[i] = startTexture[nameID];
-					nameID++;
-				}
+			const auto loaded = loadTextures(data, type, color);
+			for (size_t i = 0; i < loaded.size(); i++) {
+				resolved[loadedNames[i]] = loaded[i];
 			}
 		}
+
+		std::lock_guard guard(protectTexture);
+		for (const auto& [name, texture] : resolved) {
+			textureMap.try_emplace(name, texture);
+		}
+		for (size_t i = 0; i < amount; i++) {
+			if (!localtextureIDs[i]) localtextureIDs[i] = textureMap[names[i]];
+		}
 		return localtextureIDs;
 	}
 
+
 	std::vector<TNodeHolder> GameGraphicsModule::addNode(
 		const NodeInfo* nodeInfos, const size_t count, const std::string& nodes) {
 		std::vector<shader::BindingInfo> bindings;
@@ -867,7 +1457,7 @@ namespace tge::graphics {
 		}
 
 		BufferInfo bufferInfo{ &*cache, count * sizeof(ValueSystem),
-							  DataType::Uniform };
+							  DataType::All };
 		const auto allData = apiLayer->pushData(1, &bufferInfo, nodes).back();
 		std::vector<TNodeHolder> nodeHolder(count);
 		for (size_t i = 0; i < count; i++) {
@@ -892,6 +1482,33 @@ namespace tge::graphics {
 		}
 
 		apiLayer->getShaderAPI()->bindData(bindings.data(), bindings.size());
+
+		std::unordered_map<shader::ShaderPipe, std::vector<size_t>> sharedNodes;
+		for (size_t i = 0; i < count; i++) {
+			const NodeInfo& nodeInfo = nodeInfos[i];
+			if (!nodeInfo.bindingID && nodeInfo.bindingPipe != nullptr)
+				sharedNodes[nodeInfo.bindingPipe].push_back(i);
+		}
+		const auto shaderAPI = apiLayer->getShaderAPI();
+		for (const auto& [pipe, nodes] : sharedNodes) {
+			const auto bindingSet = shaderAPI->createBindings(pipe)[0];
+			std::array<shader::BindingInfo, 2> shared;
+			for (auto& sharedBinding : shared) {
+				sharedBinding.bindingSet = bindingSet;
+				sharedBinding.type = shader::BindingType::UniformBuffer;
+			}
+			shared[0].binding = 2;
+			shared[0].data.buffer = { allData, sizeof(ValueSystem), 0 };
+			shared[1].binding = 3;
+			shared[1].data.buffer = { projection, sizeof(glm::mat4), 0 };
+			shaderAPI->bindData(shared.data(), shared.size());
+			const auto views = shaderAPI->shareBindings(bindingSet, nodes.size());
+			for (size_t j = 0; j < nodes.size(); j++) {
+				shaderAPI->setDynamicOffset(views[j], 2,
+					(uint32_t)(nodes[j] * sizeof(ValueSystem)));
+				binding[nodes[j]] = views[j];
+			}
+		}
 		return nodeHolder;
 	}
 
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../../public/Util.hpp"
+#include "../../public/WorkerPool.hpp"
+#include "../../public/graphics/BlockCompression.hpp"
+#include "../../public/graphics/GameGraphicsModule.hpp"
+#include "../../public/graphics/MipGeneration.hpp"
+#include "../../public/graphics/TextureConversion.hpp"
+#include "../../public/graphics/TextureDiskCache.hpp"
+// The engine gets stb_image through tiny_gltf, including it twice would
+// emit the implementation twice
+#ifndef STBI_INCLUDE_STB_IMAGE_H
+#include "../../public/headerlibs/stb_image.h"
+#endif
+
+namespace tge::graphics {
+
+	// Upload formats indexed by the channel count, unsupported ones are left
+	// undefined and those textures are expanded to rgba
+	struct TextureFormats {
+		std::array<vk::Format, 5> unorm8;
+		std::array<vk::Format, 5> unorm16;
+		BlockFormat compression = BlockFormat::NONE;
+		bool cpuMips = false;
+		MipSettings mips;
+		std::filesystem::path cacheDirectory;
+		uint64_t settingsHash = 0;
+	};
+
+	// Everything decodeSTBI depends on besides the source, part of the key of
+	// the disk cache
+	inline uint64_t textureSettingsHash(const TextureFormats& formats) {
+		std::array<uint64_t, 14> values{};
+		for (size_t i = 0; i < formats.unorm8.size(); i++) {
+			values[i] = (uint64_t)formats.unorm8[i];
+			values[i + 5] = (uint64_t)formats.unorm16[i];
+		}
+		values[10] = (uint64_t)formats.compression;
+		values[11] = formats.cpuMips;
+		values[12] = formats.mips.levels;
+		values[13] = ((uint64_t)formats.mips.filter << 1) | formats.mips.gammaCorrect;
+		return util::hash64(values.data(), sizeof(values), TEXTURE_CACHE_VERSION);
+	}
+
+	// Textures are decoded in parallel already, so the blocks of one texture
+	// are encoded on the calling thread
+	inline bool compressSTBI(const stbi_uc* buffer, const int length,
+		const std::string& name, const TextureFormats& formats, TextureInfo& info) {
+		int width = 0, height = 0, channel = 0;
+		const auto rgba = stbi_load_from_memory(buffer, length, &width, &height,
+			&channel, 4);
+		if (rgba == nullptr) {
+			PLOG_ERROR << "Couldn't decode texture " << name << ": "
+				<< stbi_failure_reason() << "!";
+			return false;
+		}
+		util::OnExit freeRGBA([&] { stbi_image_free(rgba); });
+		const auto texture = compressTexture(rgba, width, height,
+			formats.compression, formats.mips);
+		const auto data = (uint8_t*)malloc(texture.data.size());
+		if (data == nullptr) {
+			PLOG_ERROR << "Out of memory compressing texture " << name << "!";
+			return false;
+		}
+		std::memcpy(data, texture.data.data(), texture.data.size());
+		info.data = data;
+		info.width = width;
+		info.height = height;
+		info.channel = 4;
+		info.size = (uint32_t)texture.data.size();
+		info.internalFormatOverride = blockVulkanFormat(texture.format);
+		info.mipMapOverrider = texture.mipLevels;
+		info.blitMode = BlitMode::NONE;
+		return true;
+	}
+
+	// Decodes into the smallest supported format, 16 bit images are only kept
+	// at 16 bit if rgba16 is supported. The data has to be freed with free
+	inline bool decodeSTBI(const std::span<const char> encoded,
+		const std::string& name, const TextureFormats& formats, TextureInfo& info) {
+		info.debugInfo = name;
+		if (encoded.empty()) {
+			PLOG_ERROR << "Found empty texture " << name << "!";
+			return false;
+		}
+		const auto buffer = (const stbi_uc*)encoded.data();
+		const auto length = (int)encoded.size();
+		if (formats.compression != BlockFormat::NONE) {
+			return compressSTBI(buffer, length, name, formats, info);
+		}
+		const bool wide = stbi_is_16_bit_from_memory(buffer, length) &&
+			formats.unorm16[4] != vk::Format::eUndefined;
+		int width = 0, height = 0, channel = 0;
+		void* texels = wide
+			? (void*)stbi_load_16_from_memory(buffer, length, &width, &height, &channel, 0)
+			: (void*)stbi_load_from_memory(buffer, length, &width, &height, &channel, 0);
+		if (texels == nullptr) {
+			PLOG_ERROR << "Couldn't decode texture " << name << ": "
+				<< stbi_failure_reason() << "!";
+			return false;
+		}
+		const auto& table = wide ? formats.unorm16 : formats.unorm8;
+		const size_t texelSize = wide ? sizeof(uint16_t) : sizeof(uint8_t);
+		const size_t pixels = (size_t)width * height;
+		auto format = table[channel];
+		if (format == vk::Format::eUndefined) {
+			const auto expanded = malloc(pixels * 4 * texelSize);
+			if (expanded == nullptr) {
+				stbi_image_free(texels);
+				PLOG_ERROR << "Out of memory expanding texture " << name << "!";
+				return false;
+			}
+			if (wide) {
+				expandToRGBA((const uint16_t*)texels, pixels, channel,
+					(uint16_t*)expanded);
+			}
+			else {
+				expandToRGBA((const uint8_t*)texels, pixels, channel,
+					(uint8_t*)expanded);
+			}
+			stbi_image_free(texels);
+			texels = expanded;
+			channel = 4;
+			format = table[4];
+		}
+		auto size = pixels * channel * texelSize;
+		if (formats.cpuMips && !wide) {
+			const auto chain = generateMipChain((const uint8_t*)texels, width, height,
+				channel, formats.mips);
+			const auto withMips = malloc(chain.data.size());
+			if (withMips != nullptr) {
+				std::memcpy(withMips, chain.data.data(), chain.data.size());
+				free(texels);
+				texels = withMips;
+				size = chain.data.size();
+				info.mipMapOverrider = (uint32_t)chain.offsets.size();
+				info.blitMode = BlitMode::NONE;
+			}
+		}
+		info.data = (uint8_t*)texels;
+		info.width = width;
+		info.height = height;
+		info.channel = channel;
+		info.size = (uint32_t)size;
+		info.internalFormatOverride = (size_t)format;
+		info.grayscale = channel < 3;
+		return true;
+	}
+
+	// Bytes per texel of an uncompressed decoded texture, 16 bit images use
+	// two bytes per channel
+	inline size_t texelBytes(const TextureInfo& info, const TextureFormats& formats) {
+		const bool wide = std::ranges::find(formats.unorm16,
+			(vk::Format)info.internalFormatOverride) != formats.unorm16.end();
+		return (size_t)info.channel * (wide ? sizeof(uint16_t) : sizeof(uint8_t));
+	}
+
+	// Decoded STBI textures, the texels of disk cache hits stay mapped and all
+	// others are freed once the textures were pushed
+	struct DecodedTextures {
+		std::vector<TextureInfo> infos;
+		std::vector<util::MappedFile> mapped;
+
+		explicit DecodedTextures(const size_t count) : infos(count), mapped(count) {}
+		DecodedTextures(const DecodedTextures&) = delete;
+		DecodedTextures(DecodedTextures&&) = default;
+
+		~DecodedTextures() {
+			for (size_t i = 0; i < infos.size(); i++) {
+				if (!mapped[i]) free(infos[i].data);
+			}
+		}
+	};
+
+	// Maps the texels from the disk cache if the content and settings were
+	// decoded before, otherwise decodes and stores them for the next start
+	inline bool decodeCached(const std::span<const char> encoded, const uint64_t hash,
+		const std::string& name, const TextureFormats& formats, TextureInfo& info,
+		util::MappedFile& mapped) {
+		if (formats.cacheDirectory.empty())
+			return decodeSTBI(encoded, name, formats, info);
+		const auto path = cachedTexturePath(formats.cacheDirectory, hash,
+			formats.settingsHash);
+		CachedTextureHeader header;
+		util::MappedFile file(path);
+		const auto texels = readCachedTexture(file.view(), hash,
+			formats.settingsHash, header);
+		if (!texels.empty()) {
+			info.data = (uint8_t*)texels.data();
+			info.size = (uint32_t)header.size;
+			info.width = header.width;
+			info.height = header.height;
+			info.channel = header.channel;
+			info.internalFormatOverride = (size_t)header.format;
+			info.mipMapOverrider = header.mipLevels;
+			info.blitMode = (BlitMode)header.blitMode;
+			info.grayscale = header.grayscale != 0;
+			info.debugInfo = name;
+			mapped = std::move(file);
+			return true;
+		}
+
+		if (!decodeSTBI(encoded, name, formats, info)) return false;
+		header = CachedTextureHeader();
+		header.sourceHash = hash;
+		header.settingsHash = formats.settingsHash;
+		header.format = info.internalFormatOverride;
+		header.size = info.size;
+		header.width = info.width;
+		header.height = info.height;
+		header.channel = info.channel;
+		header.mipLevels = info.mipMapOverrider;
+		header.blitMode = (uint32_t)info.blitMode;
+		header.grayscale = info.grayscale;
+		if (!writeCachedTexture(path, header,
+			std::span((const char*)info.data, info.size))) {
+			PLOG_WARNING << "Couldn't write texture " << name << " to the cache!";
+		}
+		return true;
+	}
+
+	inline DecodedTextures loadSTBI(util::WorkerPool& pool,
+		const std::vector<TextureLoadInternal>& data,
+		const std::vector<uint64_t>& hashes, const std::vector<size_t>& indices,
+		const TextureFormats& formats) {
+		DecodedTextures decoded(indices.size());
+		pool.parallelFor(indices.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				const auto& values = data[indices[i]];
+				decodeCached(values.textureInfo, hashes[indices[i]], values.debugName,
+					formats, decoded.infos[i], decoded.mapped[i]);
+			}
+			});
+		return decoded;
+	}
+
+}  // namespace tge::graphics
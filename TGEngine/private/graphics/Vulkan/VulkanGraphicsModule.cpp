@@ -1,5 +1,6 @@
 
 #include <array>
+#include <bit>
 #include <iostream>
 #include <mutex>
 #include <numeric>
@@ -58,12 +59,25 @@ namespace tge::graphics {
                              __FILE__ + " L" + std::to_string(__LINE__)); \
   }
 
+    bool VulkanGraphicsModule::isTextureFormatSupported(const size_t format,
+        const bool blit) const {
+        const auto properties = physicalDevice.getFormatProperties((Format)format);
+        FormatFeatureFlags required = FormatFeatureFlagBits::eSampledImage |
+            FormatFeatureFlagBits::eSampledImageFilterLinear |
+            FormatFeatureFlagBits::eTransferDst;
+        if (blit)
+            required |= FormatFeatureFlagBits::eBlitSrc | FormatFeatureFlagBits::eBlitDst;
+        return (properties.optimalTilingFeatures & required) == required;
+    }
+
     size_t VulkanGraphicsModule::getAligned(const DataType type) const {
         const auto properties = this->physicalDevice.getProperties();
         switch (type) {
         case DataType::All:
         case DataType::Uniform:
             return properties.limits.minUniformBufferOffsetAlignment;
+        case DataType::Storage:
+            return properties.limits.minStorageBufferOffsetAlignment;
         case DataType::VertexData:
         case DataType::IndexData:
         case DataType::VertexIndexData:
@@ -234,49 +248,310 @@ namespace tge::graphics {
         throw std::runtime_error("Error shader translation not implemented!");
     }
 
+    constexpr std::array memoryCategoryNames = { "geometry", "uniform", "texture",
+        "render target", "staging" };
+    static_assert(memoryCategoryNames.size() == (size_t)MemoryCategory::COUNT);
+
+    // Categories of one group share blocks, only buffers or only images
+    constexpr MemoryCategory blockGroup(const MemoryCategory category) {
+        switch (category) {
+        case MemoryCategory::UNIFORM:
+            return MemoryCategory::GEOMETRY;
+        case MemoryCategory::RENDER_TARGET:
+            return MemoryCategory::TEXTURE;
+        default:
+            return category;
+        }
+    }
+
+    inline MemoryCategory categoryFromDataType(const DataType type) {
+        switch (type) {
+        case DataType::IndexData:
+        case DataType::VertexData:
+        case DataType::VertexIndexData:
+            return MemoryCategory::GEOMETRY;
+        default:
+            return MemoryCategory::UNIFORM;
+        }
+    }
+
+    // Type allowed by the requirement bits with all required flags and as many
+    // preferred ones as possible, INVALID_UINT32 if there is none
+    inline uint32_t findMemoryType(const PhysicalDeviceMemoryProperties& properties,
+        const uint32_t typeBits, const MemoryPropertyFlags required,
+        const MemoryPropertyFlags preferred = {}) {
+        auto found = INVALID_UINT32;
+        int foundScore = -1;
+        for (uint32_t i = 0; i < properties.memoryTypeCount; i++) {
+            const auto flags = properties.memoryTypes[i].propertyFlags;
+            if (!(typeBits & (1u << i)) || (flags & required) != required) continue;
+            const auto score = std::popcount((uint32_t)(flags & preferred));
+            if (score <= foundScore) continue;
+            found = i;
+            foundScore = score;
+        }
+        return found;
+    }
+
+    // Device local memory for the resource, host visible as well on unified
+    // memory so data can be written without staging
+    inline uint32_t findDeviceType(VulkanGraphicsModule* vgm, const uint32_t typeBits) {
+        const MemoryPropertyFlags direct = MemoryPropertyFlagBits::eHostVisible |
+            MemoryPropertyFlagBits::eHostCoherent;
+        auto type = findMemoryType(vgm->memoryProperties, typeBits,
+            MemoryPropertyFlagBits::eDeviceLocal, vgm->unifiedMemory ? direct : MemoryPropertyFlags());
+        if (type == INVALID_UINT32)
+            type = findMemoryType(vgm->memoryProperties, typeBits, {});
+        return type;
+    }
+
+    inline uint32_t findHostType(VulkanGraphicsModule* vgm, const uint32_t typeBits) {
+        return findMemoryType(vgm->memoryProperties, typeBits,
+            MemoryPropertyFlagBits::eHostVisible | MemoryPropertyFlagBits::eHostCoherent);
+    }
+
+    // The pools mutex has to be held
+    inline DeviceMemory allocateDeviceMemory(VulkanGraphicsModule* vgm,
+        const size_t size, const uint32_t type) {
+        const MemoryAllocateInfo allocateInfo(size, type);
+        const auto memory = vgm->device.allocateMemory(allocateInfo);
+        vgm->memoryPools.heapBytes[vgm->memoryProperties.memoryTypes[type].heapIndex] += size;
+        return memory;
+    }
+
+    inline void freeDeviceMemory(VulkanGraphicsModule* vgm,
+        const DeviceMemory memory, const size_t size, const uint32_t type) {
+        vgm->device.freeMemory(memory);
+        vgm->memoryPools.heapBytes[vgm->memoryProperties.memoryTypes[type].heapIndex] -= size;
+    }
+
+    // With existingOnly no memory is allocated from the device, the allocation
+    // stays empty if no block has room
+    inline MemoryAllocation allocateFromPools(VulkanGraphicsModule* vgm,
+        const MemoryRequirements& requirements, const uint32_t type,
+        const MemoryCategory category, const bool existingOnly = false) {
+        auto& pools = vgm->memoryPools;
+        const auto flags = vgm->memoryProperties.memoryTypes[type].propertyFlags;
+        const bool hostVisible = (bool)(flags & MemoryPropertyFlagBits::eHostVisible);
+        const auto blockSize = flags & MemoryPropertyFlagBits::eDeviceLocal
+            ? pools.deviceBlockSize : pools.hostBlockSize;
+        const auto group = blockGroup(category);
+        const auto map = [&](const DeviceMemory memory) {
+            return hostVisible
+                ? (char*)vgm->device.mapMemory(memory, 0, VK_WHOLE_SIZE, {})
+                : nullptr;
+            };
+
+        MemoryAllocation allocation;
+        allocation.size = requirements.size;
+        allocation.category = category;
+        allocation.type = type;
+        std::lock_guard guard(pools.mutex);
+        auto& stats = pools.stats[(size_t)category];
+        if (requirements.size > blockSize / 2 && !existingOnly) {
+            allocation.memory = allocateDeviceMemory(vgm, requirements.size, type);
+            allocation.mapped = map(allocation.memory);
+            stats.dedicated++;
+            stats.allocations++;
+            stats.usedBytes += allocation.size;
+            return allocation;
+        }
+
+        auto blockIndex = INVALID_UINT32;
+        for (uint32_t i = 0; i < pools.blocks.size(); i++) {
+            auto& block = pools.blocks[i];
+            if (!block.memory || block.retiring || block.type != type ||
+                block.category != group)
+                continue;
+            allocation.range = block.allocator.allocate(requirements.size,
+                requirements.alignment);
+            if (!allocation.range) continue;
+            blockIndex = i;
+            break;
+        }
+        if (blockIndex == INVALID_UINT32 && existingOnly) return {};
+        if (blockIndex == INVALID_UINT32) {
+            MemoryBlock block{ allocateDeviceMemory(vgm, blockSize, type), type, group,
+                TLSFAllocator(blockSize) };
+            block.mapped = map(block.memory);
+            allocation.range = block.allocator.allocate(requirements.size,
+                requirements.alignment);
+            const auto unused = std::ranges::find_if(pools.blocks,
+                [](const MemoryBlock& other) { return !other.memory; });
+            blockIndex = (uint32_t)std::distance(pools.blocks.begin(), unused);
+            if (unused == pools.blocks.end()) {
+                pools.blocks.push_back(std::move(block));
+            }
+            else {
+                *unused = std::move(block);
+            }
+        }
+        const auto& block = pools.blocks[blockIndex];
+        allocation.memory = block.memory;
+        allocation.block = blockIndex;
+        allocation.offset = allocation.range.offset;
+        if (block.mapped != nullptr) allocation.mapped = block.mapped + allocation.offset;
+        stats.allocations++;
+        stats.usedBytes += allocation.size;
+        return allocation;
+    }
+
+    // Sub-allocates from a block of the memory type and category group, blocks
+    // are created on demand and host visible ones stay mapped. Allocations
+    // larger than half a block get their own memory. Once the device runs out
+    // of memory the allocation falls back to host visible memory if the
+    // resource allows it
+    inline MemoryAllocation allocateMemory(VulkanGraphicsModule* vgm,
+        const MemoryRequirements& requirements, const uint32_t type,
+        const MemoryCategory category) {
+        try {
+            return allocateFromPools(vgm, requirements, type, category);
+        }
+        catch (const OutOfDeviceMemoryError&) {
+            const auto& properties = vgm->memoryProperties;
+            auto fallback = INVALID_UINT32;
+            for (uint32_t i = 0; i < properties.memoryTypeCount; i++) {
+                const auto flags = properties.memoryTypes[i].propertyFlags;
+                if (i != type && (requirements.memoryTypeBits & (1u << i)) &&
+                    (flags & MemoryPropertyFlagBits::eHostVisible) &&
+                    !(flags & MemoryPropertyFlagBits::eDeviceLocal)) {
+                    fallback = i;
+                    break;
+                }
+            }
+            if (fallback == INVALID_UINT32) {
+                PLOG_ERROR << "Out of device memory allocating " << requirements.size
+                    << " bytes of " << memoryCategoryNames[(size_t)category] << "!";
+                throw;
+            }
+            PLOG_WARNING << "Out of device memory, " << requirements.size << " bytes of "
+                << memoryCategoryNames[(size_t)category] << " are allocated in host memory!";
+            return allocateFromPools(vgm, requirements, fallback, category);
+        }
+    }
+
+    // Empty blocks are freed unless they are the last of their type and group
+    inline void releaseMemory(VulkanGraphicsModule* vgm,
+        const MemoryAllocation& allocation) {
+        if (!allocation.memory) return;
+        auto& pools = vgm->memoryPools;
+        std::lock_guard guard(pools.mutex);
+        auto& stats = pools.stats[(size_t)allocation.category];
+        stats.allocations--;
+        stats.usedBytes -= allocation.size;
+        if (allocation.block == INVALID_UINT32) {
+            freeDeviceMemory(vgm, allocation.memory, allocation.size, allocation.type);
+            stats.dedicated--;
+            return;
+        }
+        auto& block = pools.blocks[allocation.block];
+        block.allocator.free(allocation.range);
+        if (!block.allocator.empty()) return;
+        const bool otherBlock = std::ranges::any_of(pools.blocks,
+            [&](const MemoryBlock& other) {
+                return &other != &block && other.memory && !other.retiring &&
+                    other.type == block.type && other.category == block.category;
+            });
+        if (!otherBlock) return;
+        freeDeviceMemory(vgm, block.memory, block.allocator.size(), block.type);
+        block.memory = DeviceMemory();
+        block.mapped = nullptr;
+    }
+
+    MemoryCategoryStats VulkanGraphicsModule::getMemoryStats() {
+        std::lock_guard guard(memoryPools.mutex);
+        return memoryPools.stats;
+    }
+
+    MemoryBudget VulkanGraphicsModule::getMemoryBudget() {
+        MemoryBudget budget;
+        std::vector<size_t> heapBytes;
+        {
+            std::lock_guard guard(memoryPools.mutex);
+            for (size_t i = 0; i < budget.categoryBytes.size(); i++)
+                budget.categoryBytes[i] = memoryPools.stats[i].usedBytes;
+            heapBytes = memoryPools.heapBytes;
+        }
+        // Without the extension only the engine's own allocations are known and
+        // most of the heap is assumed to be available
+        std::vector<size_t> heapUsage(heapBytes);
+        std::vector<size_t> heapBudget(heapBytes.size());
+        if (memoryBudgetSupported) {
+            const auto properties = physicalDevice.getMemoryProperties2<
+                PhysicalDeviceMemoryProperties2, PhysicalDeviceMemoryBudgetPropertiesEXT>();
+            const auto& budgetProperties =
+                properties.get<PhysicalDeviceMemoryBudgetPropertiesEXT>();
+            for (size_t i = 0; i < heapBytes.size(); i++) {
+                heapUsage[i] = budgetProperties.heapUsage[i];
+                heapBudget[i] = budgetProperties.heapBudget[i];
+            }
+        }
+        else {
+            for (size_t i = 0; i < heapBytes.size(); i++)
+                heapBudget[i] = memoryProperties.memoryHeaps[i].size / 10 * 8;
+        }
+        for (size_t i = 0; i < heapBytes.size(); i++) {
+            if (!(memoryProperties.memoryHeaps[i].flags & MemoryHeapFlagBits::eDeviceLocal))
+                continue;
+            budget.usage += heapUsage[i];
+            budget.budget += heapBudget[i];
+        }
+        return budget;
+    }
+
+    // Bytes the streaming systems should evict, negative by the headroom
+    // below the threshold. Eviction takes a few ticks so pressure and
+    // headroom are reported once per interval
+    inline int64_t memoryPressure(VulkanGraphicsModule* vgm) {
+        if (vgm->ticksSincePressure < vgm->memoryPressureInterval) {
+            vgm->ticksSincePressure++;
+            return 0;
+        }
+        const auto budget = vgm->getMemoryBudget();
+        const auto threshold = (size_t)(budget.budget * vgm->memoryPressureThreshold);
+        vgm->ticksSincePressure = 0;
+        if (budget.usage <= threshold) return -(int64_t)(threshold - budget.usage);
+        PLOG_WARNING << "Device memory usage " << budget.usage << " of budget "
+            << budget.budget << ", evicting!";
+        return (int64_t)(budget.usage - threshold);
+    }
+
+    // False while other ranges of the packed buffer are still alive
+    inline bool releasePackedRange(VulkanGraphicsModule* vgm, const Buffer buffer) {
+        std::lock_guard guard(vgm->packedBuffersMutex);
+        const auto found = vgm->packedBuffers.find((VkBuffer)buffer);
+        if (found == vgm->packedBuffers.end()) return true;
+        if (--found->second != 0) return false;
+        vgm->packedBuffers.erase(found);
+        return true;
+    }
+
     void VulkanGraphicsModule::removeData(
-        const std::span<const TDataHolder> dataHolder, bool instant) {
-        if (this->bufferDataHolder.erase(dataHolder)) {
+        const std::span<const TDataHolder> dataHolderIn, bool instant) {
+        const auto dataHolder = dataCache.release(dataHolderIn);
+        if (dataHolder.empty()) return;
+        ((shader::VulkanShaderModule*)shaderAPI)->forgetBuffers(dataHolder);
+        if (this->bufferDataHolder.erase(std::span(dataHolder))) {
             if (instant || this->bufferDataHolder.size() / 2 >=
                 this->bufferDataHolder.translationTable.size()) {
+                flushTransferFrames(this);
                 const auto compactation = this->bufferDataHolder.compact();
                 const auto& buffers = std::get<0>(compactation);
-                for (const auto buffer : buffers) {
-                    device.destroy(buffer);
-                }
-                const std::lock_guard guard(this->bufferDataHolder.mutex);
-                const auto& memorys = std::get<1>(compactation);
-                for (const auto memory : memorys) {
-                    memoryCounter[memory] -= 1;
-
-                    const auto value = memoryCounter[memory];
-                    if (value <= 0) {
-                        device.freeMemory(memory);
-#ifdef DEBUG
-                        const auto memoryDebug =
-                            std::to_string((size_t)((VkDeviceMemory)memory)) + " - " +
-                            memoryDebugTags[memory];
-                        PLOG_DEBUG << "Check passed for memory [" << memoryDebug << "], mc="
-                            << value;
-#endif  // DEBUG1
-                    }
-                    else {
-#ifdef DEBUG
-                        const auto memoryDebug =
-                            std::to_string((size_t)((VkDeviceMemory)memory)) + " - " +
-                            memoryDebugTags[memory];
-                        PLOG_VERBOSE << "Memory counter not <= 0, mc=" << value
-                            << ", memory=" << memoryDebug;
-#endif  // DEBUG
-                    }
+                const auto& allocations = std::get<1>(compactation);
+                for (size_t i = 0; i < buffers.size(); i++) {
+                    if (!releasePackedRange(this, buffers[i])) continue;
+                    device.destroy(buffers[i]);
+                    releaseMemory(this, allocations[i]);
                 }
             }
         }
     }
 
     void VulkanGraphicsModule::removeTextures(
-        const std::span<const TTextureHolder> textureHolder, bool instant) {
-        if (this->textureImageHolder.erase(textureHolder)) {
+        const std::span<const TTextureHolder> textureHolderIn, bool instant) {
+        const auto textureHolder = textureCache.release(textureHolderIn);
+        if (textureHolder.empty()) return;
+        if (this->textureImageHolder.erase(std::span(textureHolder))) {
             if (instant || this->textureImageHolder.size() / 2 >=
                 this->textureImageHolder.translationTable.size()) {
                 const auto compactation = this->textureImageHolder.compact();
@@ -288,19 +563,9 @@ namespace tge::graphics {
                 for (const auto view : views) {
                     device.destroy(view);
                 }
-                const std::lock_guard guard(this->textureImageHolder.mutex);
-                const auto& memorys = std::get<2>(compactation);
-                const auto& allMemorys =
-                    std::get<2>(this->textureImageHolder.internalValues);
-                std::vector<vk::DeviceMemory> uniqueMemory;
-                uniqueMemory.reserve(memorys.size());
-                std::ranges::unique_copy(memorys, std::back_inserter(uniqueMemory));
-                for (const auto memory : uniqueMemory) {
-                    if (std::ranges::none_of(allMemorys, [&](auto memoryIn) {
-                        return memory == memoryIn;
-                        })) {
-                        device.freeMemory(memory);
-                    }
+                const auto& allocations = std::get<2>(compactation);
+                for (const auto& allocation : allocations) {
+                    releaseMemory(this, allocation);
                 }
             }
         }
@@ -320,6 +585,24 @@ namespace tge::graphics {
             return (RenderTarget)(hide ? (type | RenderTarget::NONE) : (type & ~(RenderTarget::NONE))); });
     }
 
+    // Locks the render queue and waits until no frame in flight executes, the
+    // secondary command buffers they reference can be changed afterwards
+    [[nodiscard]] inline std::unique_lock<std::mutex> waitForFrames(
+        VulkanGraphicsModule* vgm) {
+        auto guard = vgm->primarySync->waitAndGet();
+        for (const auto& frame : vgm->frames) {
+            if (!frame.submitted) continue;
+            const auto result =
+                vgm->device.waitForFences(frame.fence, true, INVALID_SIZE_T);
+            VERROR(result);
+        }
+        return guard;
+    }
+
+    std::unique_lock<std::mutex> VulkanGraphicsModule::lockFrames() {
+        return waitForFrames(this);
+    }
+
     TRenderHolder VulkanGraphicsModule::pushRender(const size_t renderInfoCount,
         const RenderInfo* renderInfos,
         const TRenderHolder toOverride,
@@ -337,7 +620,7 @@ namespace tge::graphics {
             commandBuffer = device.allocateCommandBuffers(commandBufferAllocate)[0];
         }
         else {
-            generalLock = primarySync->waitAndGet();
+            generalLock = waitForFrames(this);
             lockGuard =
                 std::unique_lock(*secondaryCommandBuffer.get<2>(toOverride).get());
             commandBuffer = secondaryCommandBuffer.get<0>(toOverride);
@@ -368,18 +651,17 @@ namespace tge::graphics {
                 bufferDataHolder.get<0>(std::span(info.vertexBuffer));
 
             if (!vertexBuffer.empty()) {
-                if (info.vertexOffsets.size() == 0) {
-                    std::vector<DeviceSize> offsets(vertexBuffer.size());
-                    std::fill(offsets.begin(), offsets.end(), 0);
-                    commandBuffer.bindVertexBuffers(0, vertexBuffer, offsets);
-                }
-                else {
+                // Offsets are relative to the range of packed data
+                const auto rangeOffsets =
+                    bufferDataHolder.get<3>(std::span(info.vertexBuffer));
+                std::vector<DeviceSize> offsets(rangeOffsets.begin(), rangeOffsets.end());
+                if (info.vertexOffsets.size() != 0) {
                     TGE_EXPECT(vertexBuffer.size() == info.vertexOffsets.size(),
                         "Size is not equal!", {});
-                    commandBuffer.bindVertexBuffers(0, vertexBuffer.size(),
-                        vertexBuffer.data(),
-                        (DeviceSize*)info.vertexOffsets.data());
+                    for (size_t j = 0; j < offsets.size(); j++)
+                        offsets[j] += info.vertexOffsets[j];
                 }
+                commandBuffer.bindVertexBuffers(0, vertexBuffer, offsets);
             }
 
             if (!info.bindingID) {
@@ -405,14 +687,15 @@ namespace tge::graphics {
 
             if (info.indexSize != IndexSize::NONE) [[likely]] {
                 commandBuffer.bindIndexBuffer(bufferDataHolder.get<0>(info.indexBuffer),
-                    info.indexOffset,
+                    bufferDataHolder.get<3>(info.indexBuffer) + info.indexOffset,
                     (IndexType)info.indexSize);
 
                 commandBuffer.drawIndexed(info.indexCount, info.instanceCount, 0, 0,
                     info.firstInstance);
             }
             else {
-                commandBuffer.draw(info.indexCount, info.instanceCount, 0, 0);
+                commandBuffer.draw(info.indexCount, info.instanceCount, 0,
+                    info.firstInstance);
             }
 #ifdef DEBUG
             if (debugEnabled && !info.debugName.empty())
@@ -434,8 +717,10 @@ namespace tge::graphics {
             nextHolder = TRenderHolder(allocation.beginIndex);
             std::lock_guard guard(renderInfosForRetryHolder);
             renderInfosForRetry.emplace_back(nextHolder, target);
+            // One release per reference, buffers used by several draws count
+            // once while owned data lists every reference the render holds
             std::vector<TDataHolder>& dataHolderToAdd = *dataHolder;
-            dataHolderToAdd.reserve(renderInfoCount * 100);
+            std::vector<TDataHolder> owned;
             std::vector<TPipelineHolder>& pipelineHolder = *pipeline;
             pipelineHolder.reserve(renderInfoCount);
             for (size_t i = 0; i < renderInfoCount; i++) {
@@ -445,7 +730,16 @@ namespace tge::graphics {
                 for (const auto moreHolder : render.vertexBuffer) {
                     dataHolderToAdd.push_back(moreHolder);
                 }
+                owned.insert(owned.end(), render.ownedData.begin(),
+                    render.ownedData.end());
             }
+            std::ranges::sort(dataHolderToAdd, {}, &TDataHolder::internalHandle);
+            const auto [first, last] = std::ranges::unique(dataHolderToAdd);
+            dataHolderToAdd.erase(first, last);
+            std::erase_if(dataHolderToAdd, [&](const TDataHolder holder) {
+                return std::ranges::find(owned, holder) != owned.end();
+                });
+            dataHolderToAdd.insert(dataHolderToAdd.end(), owned.begin(), owned.end());
             std::ranges::fill(needsRefresh, 1);
         }
         return nextHolder;
@@ -458,6 +752,8 @@ namespace tge::graphics {
                 BufferUsageFlagBits::eIndexBuffer;
         case DataType::Uniform:
             return BufferUsageFlagBits::eUniformBuffer;
+        case DataType::Storage:
+            return BufferUsageFlagBits::eStorageBuffer;
         case DataType::VertexData:
             return BufferUsageFlagBits::eVertexBuffer;
         case DataType::IndexData:
@@ -477,221 +773,373 @@ namespace tge::graphics {
         return size + (align - alignmentOffset) % align;
     }
 
-    struct OutputBuffer {
-        vk::Buffer buffer;
-        size_t alignedSize;
-        size_t alignedOffset;
-    };
-
-    template <bool perma = true>
-    inline std::tuple<std::vector<OutputBuffer>, vk::DeviceMemory, size_t>
-        internalBuffer(VulkanGraphicsModule* vgm, const size_t dataCount,
-            const BufferCreateInfo* bufferInfo, bool hostVisible = false) {
-        std::vector<OutputBuffer> tempBuffer;
-        tempBuffer.reserve(dataCount);
+    constexpr size_t STAGING_ALIGNMENT = 16;
 
-        auto lockguard = vgm->bufferDataHolder.allocate(perma ? dataCount : 0);
-        auto [bufferList, bufferMemoryList, bufferSizeList, bufferOffset, alignment] =
-            lockguard.iterator;
+    // Bump allocates from the staging ring, creating it on first use. Uploads
+    // larger than the ring or arriving while it is full get a dedicated buffer.
+    // The region has no buffer if there is no host visible memory for it
+    inline StagingRegion acquireStaging(VulkanGraphicsModule* vgm,
+        const size_t size, const size_t alignment = STAGING_ALIGNMENT) {
+        auto& ring = vgm->stagingRing;
+        const bool powerOfTwo = std::has_single_bit(alignment);
+        {
+            std::lock_guard guard(ring.mutex);
+            if (!ring.buffer) {
+                const BufferCreateInfo bufferInfo({}, vgm->stagingRingSize,
+                    BufferUsageFlagBits::eTransferSrc, SharingMode::eExclusive);
+                ring.buffer = vgm->device.createBuffer(bufferInfo);
+                const auto requirements =
+                    vgm->device.getBufferMemoryRequirements(ring.buffer);
+                const auto type = findHostType(vgm, requirements.memoryTypeBits);
+                if (type == INVALID_UINT32) {
+                    PLOG_ERROR << "No host visible memory for the staging ring!";
+                    vgm->device.destroyBuffer(ring.buffer);
+                    ring.buffer = Buffer();
+                    return {};
+                }
+                ring.memory = allocateMemory(vgm, requirements, type,
+                    MemoryCategory::STAGING);
+                vgm->device.bindBufferMemory(ring.buffer, ring.memory.memory,
+                    ring.memory.offset);
+                ring.allocator = RingAllocator(vgm->stagingRingSize);
+            }
+            const auto ringOffset = powerOfTwo
+                ? ring.allocator.allocate(size, alignment)
+                : ring.allocator.allocate(size + alignment - 1);
+            if (ringOffset != INVALID_SIZE_T) {
+                const auto offset = aligned(ringOffset, alignment);
+                return { ring.buffer, offset, ring.memory.mapped + offset, ringOffset };
+            }
+        }
 
-        size_t tempMemory = 0;
+        StagingRegion region;
+        const BufferCreateInfo bufferInfo({}, size,
+            BufferUsageFlagBits::eTransferSrc, SharingMode::eExclusive);
+        region.buffer = vgm->device.createBuffer(bufferInfo);
+        const auto requirements = vgm->device.getBufferMemoryRequirements(region.buffer);
+        const auto type = findHostType(vgm, requirements.memoryTypeBits);
+        if (type == INVALID_UINT32) {
+            PLOG_ERROR << "No host visible memory for a staging buffer of "
+                << size << " bytes!";
+            vgm->device.destroyBuffer(region.buffer);
+            return {};
+        }
+        region.dedicated = allocateMemory(vgm, requirements, type,
+            MemoryCategory::STAGING);
+        vgm->device.bindBufferMemory(region.buffer, region.dedicated.memory,
+            region.dedicated.offset);
+        region.mapped = region.dedicated.mapped;
+        return region;
+    }
 
-        for (size_t i = 0; i < dataCount; i++) {
-            const auto& info = bufferInfo[i];
-            const auto intermBuffer = vgm->device.createBuffer(info);
-            const auto memRequ = vgm->device.getBufferMemoryRequirements(intermBuffer);
-            const auto tempOffsetedSize = aligned(memRequ.size, memRequ.alignment);
-            tempBuffer.push_back({ intermBuffer, tempOffsetedSize, tempMemory });
-            if constexpr (perma) {
-                *bufferOffset++ = tempMemory;
-                *bufferList++ = intermBuffer;
-                *bufferSizeList++ = tempOffsetedSize;
-                *alignment++ = memRequ.alignment;
-            }
-            tempMemory += tempOffsetedSize;
+    // Only call once the submission reading the region finished
+    inline void releaseStaging(VulkanGraphicsModule* vgm, const StagingRegion& region) {
+        if (region.ringOffset == INVALID_SIZE_T) {
+            vgm->device.destroyBuffer(region.buffer);
+            releaseMemory(vgm, region.dedicated);
+            return;
         }
+        std::lock_guard guard(vgm->stagingRing.mutex);
+        vgm->stagingRing.allocator.release(region.ringOffset);
+    }
 
-        const MemoryAllocateInfo allocLocalInfo(
-            tempMemory, hostVisible ? vgm->memoryTypeHostVisibleCoherent
-            : vgm->memoryTypeDeviceLocal);
-        const auto memory = vgm->device.allocateMemory(allocLocalInfo);
-        if constexpr (perma) {
-            for (size_t i = 0; i < dataCount; i++) {
-                bufferMemoryList[i] = memory;
-            }
+    // Waits for the frame's submission and releases its staging regions
+    inline void retireTransferFrame(VulkanGraphicsModule* vgm, TransferFrame& frame) {
+        if (!frame.pending) return;
+        const auto result =
+            vgm->device.waitForFences(frame.fence, true, INVALID_SIZE_T);
+        VERROR(result);
+        vgm->device.resetFences(frame.fence);
+        frame.pending = false;
+        for (const auto& staging : frame.staging) releaseStaging(vgm, staging);
+        frame.staging.clear();
+        for (const auto& [buffer, allocation] : frame.retiredBuffers) {
+            vgm->device.destroyBuffer(buffer);
+            releaseMemory(vgm, allocation);
         }
-        for (size_t i = 0; i < dataCount; i++) {
-            const auto& buffer = tempBuffer[i];
-            vgm->device.bindBufferMemory(buffer.buffer, memory, buffer.alignedOffset);
+        frame.retiredBuffers.clear();
+    }
+
+    // Stages frames read vertex, index, uniform and storage buffers in
+    constexpr PipelineStageFlags BUFFER_READ_STAGES =
+        PipelineStageFlagBits::eDrawIndirect | PipelineStageFlagBits::eVertexInput |
+        PipelineStageFlagBits::eVertexShader | PipelineStageFlagBits::eFragmentShader;
+
+    // Starts recording the current transfer frame if it is not yet, the
+    // transfer mutex has to be held. The frame's previous submission is
+    // usually long done when it is reused. Copies into buffers frames may
+    // still read need their own barrier, see changeData
+    inline TransferFrame& beginTransferFrame(VulkanGraphicsModule* vgm) {
+        auto& frame = vgm->transferFrames.frames[vgm->transferFrames.current];
+        if (frame.recording) return frame;
+        retireTransferFrame(vgm, frame);
+        const CommandBufferBeginInfo beginInfo(
+            CommandBufferUsageFlagBits::eOneTimeSubmit);
+        frame.commandBuffer.begin(beginInfo);
+        frame.recording = true;
+        return frame;
+    }
+
+    // Submits the changes recorded for this frame and moves on to the next
+    // transfer frame. Returns the semaphore the frame has to wait on, empty if
+    // nothing was recorded or no frame is going to wait on it
+    inline Semaphore submitTransferFrame(VulkanGraphicsModule* vgm,
+        const bool signal) {
+        auto& transfers = vgm->transferFrames;
+        std::lock_guard guard(transfers.mutex);
+        auto& frame = transfers.frames[transfers.current];
+        if (!frame.recording) return {};
+        frame.commandBuffer.end();
+        SubmitInfo submitInfo({}, {}, frame.commandBuffer);
+        if (signal) submitInfo.setSignalSemaphores(frame.semaphore);
+        {
+            // On the render queue so the barrier orders it behind earlier frames
+            std::lock_guard queueGuard(vgm->primarySync->handle);
+            vgm->primarySync->queue.submit(submitInfo, frame.fence);
         }
-        return std::make_tuple(tempBuffer, memory, lockguard.beginIndex);
+        frame.recording = false;
+        frame.pending = true;
+        transfers.current = (transfers.current + 1) % transfers.frames.size();
+        return signal ? frame.semaphore : Semaphore();
     }
 
-    std::vector<TDataHolder> VulkanGraphicsModule::pushData(
+    // Submits outstanding changes and waits for all transfers, needed before
+    // buffers they copy into are destroyed
+    inline void flushTransferFrames(VulkanGraphicsModule* vgm) {
+        submitTransferFrame(vgm, false);
+        auto& transfers = vgm->transferFrames;
+        std::lock_guard guard(transfers.mutex);
+        for (auto& frame : transfers.frames) retireTransferFrame(vgm, frame);
+    }
+
+    // Submits the copies recorded on the upload queue and then the render
+    // family buffer acquiring their resources, waits for both
+    inline void submitUploadAndWait(VulkanGraphicsModule* vgm,
+        std::unique_lock<std::mutex>&& uploadGuard, const CommandBuffer renderBuffer,
+        std::unique_lock<std::mutex>&& renderGuard) {
+        auto& upload = vgm->uploadQueue;
+        upload.commandBuffer.end();
+        const SubmitInfo uploadInfo({}, {}, upload.commandBuffer, upload.semaphore);
+        upload.sync->submit(uploadInfo, std::move(uploadGuard));
+        constexpr PipelineStageFlags waitStage = PipelineStageFlagBits::eAllCommands;
+        const SubmitInfo renderInfo(upload.semaphore, waitStage, renderBuffer);
+        vgm->secondarySync->endSubmitAndWait(renderInfo, std::move(renderGuard));
+    }
+
+    // Packed data shares one buffer, each holder keeps the offset of its range.
+    // Buffers in host coherent memory are written directly, the others are
+    // uploaded through the upload queue if there is one
+    inline std::vector<TDataHolder> pushBuffers(VulkanGraphicsModule* vgm,
         const size_t dataCount, const BufferInfo* bufferInfo,
-        const std::string& debugTag) {
-        EXPECT(dataCount != 0 && bufferInfo != nullptr);
+        const std::string& debugTag, const bool packed) {
+        const auto device = vgm->device;
+        std::lock_guard moveGuard(vgm->bufferMoveMutex);
+
+        // Ranges start at the offset alignment of their type, 16 bytes at least
+        // so index and vertex data stay aligned as well
+        std::vector<size_t> rangeOffsets(dataCount);
+        BufferUsageFlags packedUsage = BufferUsageFlagBits::eTransferDst |
+            BufferUsageFlagBits::eTransferSrc;
+        size_t packedSize = 0;
+        auto packedCategory = categoryFromDataType(bufferInfo[0].type);
+        if (packed) {
+            for (size_t i = 0; i < dataCount; i++) {
+                const auto& info = bufferInfo[i];
+                packedUsage |= getUsageFlagsFromDataType(info.type);
+                if (categoryFromDataType(info.type) != packedCategory)
+                    packedCategory = MemoryCategory::GEOMETRY;
+                rangeOffsets[i] = aligned(packedSize,
+                    std::max(vgm->getAligned(info.type), STAGING_ALIGNMENT));
+                packedSize = rangeOffsets[i] + info.size;
+            }
+        }
 
-        std::vector<Buffer> tempBuffer;
-        tempBuffer.reserve(dataCount);
-        std::vector<size_t> tempBufferAlignedSize;
-        tempBufferAlignedSize.resize(dataCount);
-        std::vector<size_t> bufferAlignedSize;
-        bufferAlignedSize.resize(dataCount);
-        size_t tempMemory = 0;
-        size_t actualMemory = 0;
+        const auto createBuffer = [&](const size_t size, const BufferUsageFlags usage,
+            const MemoryCategory category) {
+            const BufferCreateInfo bufferLocalCreateInfo(
+                {}, size, usage, SharingMode::eExclusive);
+            const auto localBuffer = device.createBuffer(bufferLocalCreateInfo);
+            const auto memRequLocal = device.getBufferMemoryRequirements(localBuffer);
+            const auto allocation = allocateMemory(vgm, memRequLocal,
+                findDeviceType(vgm, memRequLocal.memoryTypeBits), category);
+            device.bindBufferMemory(localBuffer, allocation.memory, allocation.offset);
+            return std::make_tuple(localBuffer, allocation, memRequLocal.alignment);
+        };
 
         size_t returnIndex = 0;
+        std::vector<Buffer> buffers(dataCount);
+        std::vector<char*> mapped(dataCount);
         {
-            auto bufferAllocate = bufferDataHolder.allocate(dataCount);
+            auto bufferAllocate = vgm->bufferDataHolder.allocate(dataCount);
             auto [bufferList, bufferMemoryList, bufferSizeList, bufferOffset,
-                alignment] = bufferAllocate.iterator;
+                alignment, usageList] = bufferAllocate.iterator;
             returnIndex = bufferAllocate.beginIndex;
 
+            std::tuple<Buffer, MemoryAllocation, DeviceSize> packedBuffer;
+            if (packed) {
+                packedBuffer = createBuffer(packedSize, packedUsage, packedCategory);
+                std::lock_guard guard(vgm->packedBuffersMutex);
+                vgm->packedBuffers[(VkBuffer)std::get<0>(packedBuffer)] = dataCount;
+            }
+
             for (size_t i = 0; i < dataCount; i++) {
                 const auto& info = bufferInfo[i];
-                const BufferUsageFlags bufferUsage = getUsageFlagsFromDataType(info.type);
-
-                const BufferCreateInfo bufferCreateInfo({}, info.size,
-                    BufferUsageFlagBits::eTransferSrc,
-                    SharingMode::eExclusive);
-                const auto intermBuffer = device.createBuffer(bufferCreateInfo);
-                tempBuffer.push_back(intermBuffer);
-                const auto memRequ = device.getBufferMemoryRequirements(intermBuffer);
-                const auto tempOffsetedSize = aligned(memRequ.size, memRequ.alignment);
-                tempMemory += tempOffsetedSize;
-                tempBufferAlignedSize[i] = tempOffsetedSize;
-
-                const BufferCreateInfo bufferLocalCreateInfo(
-                    {}, info.size,
-                    BufferUsageFlagBits::eTransferDst |
-                    BufferUsageFlagBits::eTransferSrc | bufferUsage,
-                    SharingMode::eExclusive);
-                const auto localBuffer = device.createBuffer(bufferLocalCreateInfo);
-                const auto memRequLocal = device.getBufferMemoryRequirements(localBuffer);
-
-                const auto offsetedSize =
-                    aligned(memRequLocal.size, memRequLocal.alignment);
-                bufferAlignedSize[i] = offsetedSize;
-                const auto old = actualMemory;
-                actualMemory = aligned(actualMemory, memRequLocal.alignment);
-                const auto difference = actualMemory - old;
-                if (difference > 0 && i > 0) bufferAlignedSize[i - 1] += difference;
-                actualMemory += offsetedSize;
-
-                *(bufferOffset++) = actualMemory;
-                *(bufferList + i) = localBuffer;
-                *(bufferSizeList++) = offsetedSize;
-                *(alignment++) = memRequLocal.alignment;
+                const auto usage = packed ? packedUsage
+                    : BufferUsageFlagBits::eTransferDst |
+                    BufferUsageFlagBits::eTransferSrc |
+                    getUsageFlagsFromDataType(info.type);
+                const auto [localBuffer, allocation, memoryAlignment] = packed
+                    ? packedBuffer
+                    : createBuffer(info.size, usage, categoryFromDataType(info.type));
+
+                buffers[i] = localBuffer;
+                const auto flags = vgm->memoryProperties.memoryTypes[allocation.type].propertyFlags;
+                if (allocation.mapped != nullptr && flags & MemoryPropertyFlagBits::eHostCoherent)
+                    mapped[i] = allocation.mapped + rangeOffsets[i];
+                *(bufferList++) = localBuffer;
+                *(bufferMemoryList++) = allocation;
+                *(bufferSizeList++) = info.size;
+                *(bufferOffset++) = rangeOffsets[i];
+                *(alignment++) = memoryAlignment;
+                *(usageList++) = usage;
             }
         }
 
-        const MemoryAllocateInfo allocLocalInfo(actualMemory, memoryTypeDeviceLocal);
-        const auto localMem = device.allocateMemory(allocLocalInfo);
-        memoryCounter[localMem] = dataCount;
-        this->bufferDataHolder.fill_adjacent<1>(returnIndex, localMem, dataCount);
-
-        const MemoryAllocateInfo allocInfo(tempMemory, memoryTypeHostVisibleCoherent);
-        const auto hostVisibleMemory = device.allocateMemory(allocInfo);
-
 #ifdef DEBUG
         if (debugTag.empty())
         {
             PLOG_WARNING << "Debug Tag Empty!";
         }
-        memoryDebugTags[localMem] = debugTag;
+        else if (vgm->debugEnabled) {
+            for (size_t i = 0; i < (packed ? 1 : dataCount); i++) {
+                DebugUtilsObjectNameInfoEXT objectName(ObjectType::eBuffer,
+                    (uint64_t)(VkBuffer)buffers[i], debugTag.c_str());
+                device.setDebugUtilsObjectNameEXT(objectName, vgm->dynamicLoader);
+            }
+        }
 #endif  // DEBUG
 
-        const auto& cmdBuf = noneRenderCmdbuffer[DATA_ONLY_BUFFER];
+        std::vector<TDataHolder> dataHolders(dataCount);
+        for (size_t i = 0; i < dataCount; i++) {
+            dataHolders[i] = TDataHolder(returnIndex + i);
+        }
+
+        // Nothing reads the new buffers yet and the next submit makes host
+        // writes visible to the device
+        if (std::ranges::none_of(mapped, [](char* ptr) { return ptr == nullptr; })) {
+            for (size_t i = 0; i < dataCount; i++)
+                memcpy(mapped[i], bufferInfo[i].data, bufferInfo[i].size);
+            return dataHolders;
+        }
+
+        std::vector<size_t> stagingOffsets(dataCount);
+        size_t stagingSize = 0;
+        for (size_t i = 0; i < dataCount; i++) {
+            stagingOffsets[i] = stagingSize;
+            stagingSize = aligned(stagingSize + bufferInfo[i].size, STAGING_ALIGNMENT);
+        }
+        const auto staging = acquireStaging(vgm, stagingSize);
+        // The buffers keep undefined contents, the error is logged already
+        if (!staging.buffer) return dataHolders;
+        const auto& cmdBuf = vgm->noneRenderCmdbuffer[DATA_ONLY_BUFFER];
+        auto& uploadQueue = vgm->uploadQueue;
 
         {
             const CommandBufferBeginInfo beginInfo(
                 CommandBufferUsageFlagBits::eOneTimeSubmit);
-            auto guard = secondarySync->begin(cmdBuf, beginInfo);
-
-            size_t currentOffset = 0;
-            size_t tempCurrentOffset = 0;
+            auto guard = vgm->secondarySync->begin(cmdBuf, beginInfo);
+            const bool upload = uploadQueue.sync != nullptr;
+            const auto copyBuffer = upload ? uploadQueue.commandBuffer : cmdBuf;
+            std::unique_lock<std::mutex> uploadGuard;
+            if (upload) uploadGuard = uploadQueue.sync->begin(copyBuffer, beginInfo);
+
+            std::vector<BufferMemoryBarrier> release;
+            std::vector<BufferMemoryBarrier> acquire;
             for (size_t i = 0; i < dataCount; i++) {
                 const auto& info = bufferInfo[i];
-                const auto dataptr = (const uint8_t*)info.data;
-
-                const auto tempBuf = tempBuffer[i];
-                device.bindBufferMemory(tempBuf, hostVisibleMemory, tempCurrentOffset);
-
-                const auto tempCurrentSize = tempBufferAlignedSize[i];
-                const auto mappedHandle =
-                    device.mapMemory(hostVisibleMemory, tempCurrentOffset, tempCurrentSize);
-                memcpy(mappedHandle, dataptr, info.size);
-                device.unmapMemory(hostVisibleMemory);
-                tempCurrentOffset += tempCurrentSize;
-
-                const auto currentBuffer = this->bufferDataHolder.get<0>(i + returnIndex);
-                device.bindBufferMemory(currentBuffer, localMem, currentOffset);
-                currentOffset += bufferAlignedSize[i];
-
-                const BufferCopy copyInfo(0, 0, info.size);
-                cmdBuf.copyBuffer(tempBuf, currentBuffer, copyInfo);
+                memcpy(staging.mapped + stagingOffsets[i], info.data, info.size);
+
+                const BufferCopy copyInfo(staging.offset + stagingOffsets[i],
+                    rangeOffsets[i], info.size);
+                copyBuffer.copyBuffer(staging.buffer, buffers[i], copyInfo);
+                if (!upload) continue;
+                release.emplace_back(AccessFlagBits::eTransferWrite, AccessFlags(),
+                    uploadQueue.family, vgm->queueFamilyIndex, buffers[i],
+                    rangeOffsets[i], info.size);
+                acquire.emplace_back(AccessFlags(),
+                    AccessFlagBits::eMemoryRead | AccessFlagBits::eMemoryWrite,
+                    uploadQueue.family, vgm->queueFamilyIndex, buffers[i],
+                    rangeOffsets[i], info.size);
             }
 
-            const SubmitInfo info({}, {}, cmdBuf);
-            secondarySync->endSubmitAndWait(info, std::move(guard));
+            if (upload) {
+                copyBuffer.pipelineBarrier(PipelineStageFlagBits::eTransfer,
+                    PipelineStageFlagBits::eBottomOfPipe, {}, {}, release, {});
+                cmdBuf.pipelineBarrier(PipelineStageFlagBits::eTopOfPipe,
+                    PipelineStageFlagBits::eAllCommands, {}, {}, acquire, {});
+                submitUploadAndWait(vgm, std::move(uploadGuard), cmdBuf, std::move(guard));
+            }
+            else {
+                const SubmitInfo info({}, {}, cmdBuf);
+                vgm->secondarySync->endSubmitAndWait(info, std::move(guard));
+            }
         }
+        releaseStaging(vgm, staging);
+        return dataHolders;
+    }
 
-        device.freeMemory(hostVisibleMemory);
-        for (const auto buf : tempBuffer) device.destroyBuffer(buf);
+    std::vector<TDataHolder> VulkanGraphicsModule::pushData(
+        const size_t dataCount, const BufferInfo* bufferInfo,
+        const std::string& debugTag) {
+        EXPECT(dataCount != 0 && bufferInfo != nullptr);
+        return pushBuffers(this, dataCount, bufferInfo, debugTag, false);
+    }
 
-        std::vector<TDataHolder> dataHolders(dataCount);
-        for (size_t i = 0; i < dataCount; i++) {
-            dataHolders[i] = TDataHolder(returnIndex + i);
-        }
-        return dataHolders;
+    std::vector<TDataHolder> VulkanGraphicsModule::pushPackedData(
+        const size_t dataCount, const BufferInfo* bufferInfo,
+        const std::string& debugTag) {
+        EXPECT(dataCount != 0 && bufferInfo != nullptr);
+        return pushBuffers(this, dataCount, bufferInfo, debugTag, true);
     }
 
     void VulkanGraphicsModule::changeData(const size_t sizes,
         const BufferChange* changeInfos) {
         EXPECT(sizes >= 0 && changeInfos != nullptr);
+        if (sizes == 0) return;
 
-        std::vector<BufferCreateInfo> createInfo;
-        createInfo.resize(sizes);
+        std::vector<size_t> stagingOffsets(sizes);
+        size_t stagingSize = 0;
         for (size_t i = 0; i < sizes; i++) {
-            createInfo[i] = BufferCreateInfo({}, changeInfos[i].size,
-                BufferUsageFlagBits::eTransferSrc);
+            stagingOffsets[i] = stagingSize;
+            stagingSize = aligned(stagingSize + changeInfos[i].size, STAGING_ALIGNMENT);
         }
-        const auto& [bufferList, memory, returnID] =
-            internalBuffer<false>(this, sizes, createInfo.data(), true);
-
-        const auto mappedHandle = device.mapMemory(memory, 0, VK_WHOLE_SIZE);
-
-        for (size_t i = 0; i < sizes; i++) {
-            const auto& change = changeInfos[i];
-            memcpy(((uint8_t*)mappedHandle) + bufferList[i].alignedOffset, change.data,
-                change.size);
-        }
-
-        device.unmapMemory(memory);
-
-        const auto& cmdBuf = noneRenderCmdbuffer[DATA_ONLY_BUFFER];
-
-        const CommandBufferBeginInfo beginInfo(
-            CommandBufferUsageFlagBits::eOneTimeSubmit);
-        auto guard = secondarySync->begin(cmdBuf, beginInfo);
-
+        // Recorded into this frame's transfer, the frame waits for it on the GPU
+        std::lock_guard guard(transferFrames.mutex);
+        auto& frame = beginTransferFrame(this);
+        const auto staging = acquireStaging(this, stagingSize);
+        if (!staging.buffer) return;
+        frame.staging.push_back(staging);
+
+        std::vector<BufferCopy> copies(sizes);
+        std::vector<Buffer> targets(sizes);
+        // Frames still in flight may read the ranges about to be overwritten,
+        // only those ranges wait for them and for earlier copies into them
+        std::vector<BufferMemoryBarrier> barriers(sizes);
         for (size_t i = 0; i < sizes; i++) {
             const auto& change = changeInfos[i];
-
-            const BufferCopy copyRegion(0, change.offset, change.size);
-
-            const auto currentBuffer = this->bufferDataHolder.get<0>(change.holder);
-            cmdBuf.copyBuffer(bufferList[i].buffer, currentBuffer, copyRegion);
-        }
-
-        const SubmitInfo info({}, {}, cmdBuf);
-        secondarySync->endSubmitAndWait(info, std::move(guard));
-
-        device.freeMemory(memory);
-        for (const auto& buffer : bufferList) {
-            device.destroyBuffer(buffer.buffer);
+            memcpy(staging.mapped + stagingOffsets[i], change.data, change.size);
+            targets[i] = this->bufferDataHolder.get<0>(change.holder);
+            copies[i] = BufferCopy(staging.offset + stagingOffsets[i],
+                this->bufferDataHolder.get<3>(change.holder) + change.offset, change.size);
+            barriers[i] = BufferMemoryBarrier(AccessFlagBits::eTransferWrite,
+                AccessFlagBits::eTransferWrite, VK_QUEUE_FAMILY_IGNORED,
+                VK_QUEUE_FAMILY_IGNORED, targets[i], copies[i].dstOffset, change.size);
         }
+        frame.commandBuffer.pipelineBarrier(
+            BUFFER_READ_STAGES | PipelineStageFlagBits::eTransfer,
+            PipelineStageFlagBits::eTransfer, {}, {}, barriers, {});
+        for (size_t i = 0; i < sizes; i++)
+            frame.commandBuffer.copyBuffer(staging.buffer, targets[i], copies[i]);
     }
 
     TSamplerHolder VulkanGraphicsModule::pushSampler(const SamplerInfo& sampler) {
@@ -711,20 +1159,18 @@ namespace tge::graphics {
     inline std::vector<TTextureHolder> createInternalImages(
         VulkanGraphicsModule* vgm,
         const std::vector<InternalImageInfo>& internalImageInfos) {
-        std::vector<std::tuple<ImageViewCreateInfo, size_t, std::string>>
+        std::vector<std::tuple<ImageViewCreateInfo, MemoryAllocation, std::string>>
             memoryAndOffsets;
         memoryAndOffsets.reserve(internalImageInfos.size());
-        size_t wholeSize = 0;
 
         for (const auto& imageInfo : internalImageInfos) {
-            const ImageUsageFlagBits additionalFlags =
-                imageInfo.mipmapCount > 1 ? ImageUsageFlagBits::eTransferSrc
-                : (ImageUsageFlagBits)0;
             const ImageCreateInfo depthImageCreateInfo(
-                {}, ImageType::e2D, imageInfo.format,
+                imageInfo.cubemap ? ImageCreateFlagBits::eCubeCompatible
+                : ImageCreateFlags{},
+                ImageType::e2D, imageInfo.format,
                 { imageInfo.extent.width, imageInfo.extent.height, 1 },
-                imageInfo.mipmapCount, 1, imageInfo.sampleCount, ImageTiling::eOptimal,
-                imageInfo.usage | additionalFlags);
+                imageInfo.mipmapCount, imageInfo.layers, imageInfo.sampleCount,
+                ImageTiling::eOptimal, imageInfo.usage);
             const auto depthImage = vgm->device.createImage(depthImageCreateInfo);
 
             const MemoryRequirements memoryRequirements =
@@ -739,34 +1185,34 @@ namespace tge::graphics {
                     ? ImageAspectFlagBits::eDepth
                     : (ImageAspectFlagBits)0);
             const ImageSubresourceRange subresourceRange(aspect, 0,
-                imageInfo.mipmapCount, 0, 1);
+                imageInfo.mipmapCount, 0, imageInfo.layers);
 
+            const auto viewType = imageInfo.cubemap
+                ? (imageInfo.layers > 6 ? ImageViewType::eCubeArray : ImageViewType::eCube)
+                : (imageInfo.layers > 1 ? ImageViewType::e2DArray : ImageViewType::e2D);
             const ImageViewCreateInfo depthImageViewCreateInfo(
-                {}, depthImage, ImageViewType::e2D, imageInfo.format, {},
-                subresourceRange);
-
-            const auto rest = wholeSize % memoryRequirements.alignment;
-            if (rest != 0) {
-                wholeSize += memoryRequirements.alignment - rest;
-            }
-
+                {}, depthImage, viewType, imageInfo.format,
+                imageInfo.components, subresourceRange);
+
+            const bool isRenderTarget = (bool)(imageInfo.usage &
+                (ImageUsageFlagBits::eColorAttachment |
+                    ImageUsageFlagBits::eDepthStencilAttachment));
+            const auto allocation = allocateMemory(vgm, memoryRequirements,
+                findDeviceType(vgm, memoryRequirements.memoryTypeBits), isRenderTarget
+                ? MemoryCategory::RENDER_TARGET : MemoryCategory::TEXTURE);
             memoryAndOffsets.push_back(std::make_tuple(depthImageViewCreateInfo,
-                wholeSize, imageInfo.debugInfo));
-            wholeSize += memoryRequirements.size;
+                allocation, imageInfo.debugInfo));
         }
 
-        const MemoryAllocateInfo allocationInfo(wholeSize,
-            vgm->memoryTypeDeviceLocal);
-        const auto imageMemory = vgm->device.allocateMemory(allocationInfo);
-
         std::vector<TTextureHolder> internalTexture;
         internalTexture.reserve(internalImageInfos.size());
 
         const auto output =
             vgm->textureImageHolder.allocate(internalImageInfos.size());
         auto [imageItr, viewItr, memoryItr, offsetItr, internalItr] = output.iterator;
-        for (const auto& [image, offset, debug] : memoryAndOffsets) {
-            vgm->device.bindImageMemory(image.image, imageMemory, offset);
+        for (const auto& [image, allocation, debug] : memoryAndOffsets) {
+            vgm->device.bindImageMemory(image.image, allocation.memory,
+                allocation.offset);
 
             const auto imageView = vgm->device.createImageView(image);
 #ifdef DEBUG
@@ -783,45 +1229,129 @@ namespace tge::graphics {
 #endif  // DEBUG
             * (imageItr++) = image.image;
             *(viewItr++) = imageView;
-            *(memoryItr++) = imageMemory;
-            *(offsetItr++) = offset;
+            *(memoryItr++) = allocation;
+            *(offsetItr++) = allocation.offset;
             internalTexture.emplace_back(internalTexture.size() + output.beginIndex);
         }
         std::copy(internalImageInfos.begin(), internalImageInfos.end(), internalItr);
         return internalTexture;
     }
 
-    inline size_t formatRatio(Format format) {
+    struct FormatBlock {
+        uint32_t width;
+        uint32_t height;
+        uint32_t bytes;
+    };
+
+    // Texel block extent and bytes per block, uncompressed formats are 1x1
+    inline FormatBlock formatBlock(Format format) {
         switch (format) {
-        case vk::Format::eBc1RgbUnormBlock:
-        case vk::Format::eBc1RgbSrgbBlock:
-        case vk::Format::eBc1RgbaUnormBlock:
-        case vk::Format::eBc1RgbaSrgbBlock:
-        case vk::Format::eBc2UnormBlock:
-        case vk::Format::eBc2SrgbBlock:
-            return 2;
-        case vk::Format::eBc3UnormBlock:
-        case vk::Format::eBc3SrgbBlock:
-        case vk::Format::eBc4UnormBlock:
-        case vk::Format::eBc4SnormBlock:
-        case vk::Format::eBc5UnormBlock:
-        case vk::Format::eBc5SnormBlock:
-        case vk::Format::eBc6HUfloatBlock:
-        case vk::Format::eBc6HSfloatBlock:
-        case vk::Format::eBc7UnormBlock:
-        case vk::Format::eBc7SrgbBlock:
-            return 1;
+        case Format::eBc1RgbUnormBlock:
+        case Format::eBc1RgbSrgbBlock:
+        case Format::eBc1RgbaUnormBlock:
+        case Format::eBc1RgbaSrgbBlock:
+        case Format::eBc4UnormBlock:
+        case Format::eBc4SnormBlock:
+            return { 4, 4, 8 };
+        case Format::eBc2UnormBlock:
+        case Format::eBc2SrgbBlock:
+        case Format::eBc3UnormBlock:
+        case Format::eBc3SrgbBlock:
+        case Format::eBc5UnormBlock:
+        case Format::eBc5SnormBlock:
+        case Format::eBc6HUfloatBlock:
+        case Format::eBc6HSfloatBlock:
+        case Format::eBc7UnormBlock:
+        case Format::eBc7SrgbBlock:
+            return { 4, 4, 16 };
+        case Format::eR8Unorm:
+        case Format::eR8Snorm:
+        case Format::eR8Uint:
+        case Format::eR8Sint:
+        case Format::eR8Srgb:
+            return { 1, 1, 1 };
+        case Format::eR8G8Unorm:
+        case Format::eR8G8Snorm:
+        case Format::eR8G8Uint:
+        case Format::eR8G8Sint:
+        case Format::eR16Unorm:
+        case Format::eR16Snorm:
+        case Format::eR16Uint:
+        case Format::eR16Sint:
+        case Format::eR16Sfloat:
+        case Format::eR5G6B5UnormPack16:
+        case Format::eA1R5G5B5UnormPack16:
+            return { 1, 1, 2 };
+        case Format::eR8G8B8A8Unorm:
+        case Format::eR8G8B8A8Snorm:
+        case Format::eR8G8B8A8Uint:
+        case Format::eR8G8B8A8Sint:
+        case Format::eR8G8B8A8Srgb:
+        case Format::eB8G8R8A8Unorm:
+        case Format::eB8G8R8A8Srgb:
+        case Format::eR16G16Unorm:
+        case Format::eR16G16Snorm:
+        case Format::eR16G16Uint:
+        case Format::eR16G16Sint:
+        case Format::eR16G16Sfloat:
+        case Format::eR32Uint:
+        case Format::eR32Sint:
+        case Format::eR32Sfloat:
+        case Format::eA2B10G10R10UnormPack32:
+        case Format::eA2B10G10R10UintPack32:
+        case Format::eB10G11R11UfloatPack32:
+        case Format::eE5B9G9R9UfloatPack32:
+            return { 1, 1, 4 };
+        case Format::eR16G16B16A16Unorm:
+        case Format::eR16G16B16A16Snorm:
+        case Format::eR16G16B16A16Uint:
+        case Format::eR16G16B16A16Sint:
+        case Format::eR16G16B16A16Sfloat:
+        case Format::eR32G32Uint:
+        case Format::eR32G32Sint:
+        case Format::eR32G32Sfloat:
+            return { 1, 1, 8 };
+        case Format::eR32G32B32Uint:
+        case Format::eR32G32B32Sint:
+        case Format::eR32G32B32Sfloat:
+            return { 1, 1, 12 };
+        case Format::eR32G32B32A32Uint:
+        case Format::eR32G32B32A32Sint:
+        case Format::eR32G32B32A32Sfloat:
+            return { 1, 1, 16 };
         default:
-            throw std::runtime_error("No format Ratio!");
+            throw std::runtime_error("No block size for format " + vk::to_string(format) + "!");
         }
     }
 
     inline uint32_t getMipMapsNeeded(uint32_t allLevel, const TextureInfo& info) {
-        const auto mipMaps = std::min(allLevel, info.mipMapOverrider);
-        const auto clampedMaps = std::max(mipMaps, (uint32_t)1);
-        return std::min(
+        // Levels provided by the caller are all kept, only limited by the full chain
+        if (info.mipMapOverrider != INVALID_UINT32) {
+            const auto fullChain =
+                (uint32_t)std::floor(std::log2(std::max(info.height, info.width))) + 1;
+            return std::max(std::min(info.mipMapOverrider, fullChain), 1u);
+        }
+        const auto clampedMaps = std::max(allLevel, (uint32_t)1);
+        return std::max(std::min(
             (uint32_t)std::floor(std::log2(std::max(info.height, info.width))),
-            clampedMaps);
+            clampedMaps), 1u);
+    }
+
+    inline ComponentMapping getComponentMapping(const TextureInfo& info) {
+        constexpr auto I = ComponentSwizzle::eIdentity;
+        if (info.opaque) return { I, I, I, ComponentSwizzle::eOne };
+        if (!info.grayscale) return {};
+        constexpr auto R = ComponentSwizzle::eR;
+        switch ((Format)info.internalFormatOverride) {
+        case Format::eR8Unorm:
+        case Format::eR16Unorm:
+            return { R, R, R, ComponentSwizzle::eOne };
+        case Format::eR8G8Unorm:
+        case Format::eR16G16Unorm:
+            return { R, R, R, ComponentSwizzle::eG };
+        default:
+            return {};
+        }
     }
 
     std::vector<TTextureHolder> VulkanGraphicsModule::pushTexture(
@@ -829,14 +1359,11 @@ namespace tge::graphics {
         EXPECT(textureCount != 0 && textures != nullptr);
         FeatureSet& features = getGraphicsModule()->features;
 
-        std::vector<Buffer> bufferList;
-        std::vector<DeviceMemory> memoryList;
-        bufferList.reserve(textureCount);
-        memoryList.reserve(textureCount);
+        std::vector<StagingRegion> stagingList;
+        stagingList.reserve(textureCount);
 
         util::OnExit exitHandle([&] {
-            for (auto memory : memoryList) device.freeMemory(memory);
-            for (auto buffer : bufferList) device.destroyBuffer(buffer);
+            for (const auto& staging : stagingList) releaseStaging(this, staging);
             });
 
         const auto& commandBuffer = noneRenderCmdbuffer[TEXTURE_ONLY_BUFFER];
@@ -844,6 +1371,12 @@ namespace tge::graphics {
         const CommandBufferBeginInfo beginInfo(
             CommandBufferUsageFlagBits::eOneTimeSubmit, {});
         auto guard = secondarySync->begin(commandBuffer, beginInfo);
+        // Copies run on the upload queue if there is one, blits need the
+        // render family
+        const bool upload = uploadQueue.sync != nullptr;
+        const auto copyBuffer = upload ? uploadQueue.commandBuffer : commandBuffer;
+        std::unique_lock<std::mutex> uploadGuard;
+        if (upload) uploadGuard = uploadQueue.sync->begin(copyBuffer, beginInfo);
 
         std::vector<InternalImageInfo> imagesIn(textureCount);
         for (size_t i = 0; i < textureCount; i++) {
@@ -854,97 +1387,136 @@ namespace tge::graphics {
                 getMipMapsNeeded(features.mipMapLevels, textureInfo);
             const ImageSubresourceRange range(ImageAspectFlagBits::eColor, 0,
                 mipMapCount, 0, 1);
+            // Blits and readbacks copy from the image, whether its mips came from
+            // the CPU or the GPU
+            const auto usage = ImageUsageFlagBits::eTransferDst |
+                ImageUsageFlagBits::eSampled | ImageUsageFlagBits::eTransferSrc;
             imagesIn[i] = {
                 format,
                 ext,
-                ImageUsageFlagBits::eTransferDst | ImageUsageFlagBits::eSampled,
+                usage,
                 SampleCountFlagBits::e1,
                 mipMapCount,
-                textureInfo.debugInfo };
+                textureInfo.debugInfo,
+                getComponentMapping(textureInfo),
+                std::max(textureInfo.layers, 1u),
+                textureInfo.cubemap };
         }
 
         const auto internalImageHolder = createInternalImages(this, imagesIn);
 
         for (size_t i = 0; i < textureCount; i++) {
             const TextureInfo& textureInfo = textures[i];
-            const Extent3D extent = { textureInfo.width, textureInfo.height, 1 };
             const bool blitNeeded = textureInfo.blitMode == BlitMode::LINEAR;
             const auto mipMapCount =
                 getMipMapsNeeded(features.mipMapLevels, textureInfo);
-
-            const BufferCreateInfo bufferCreateInfo({}, textureInfo.size,
-                BufferUsageFlagBits::eTransferSrc,
-                SharingMode::eExclusive, {});
-            const auto buffer = device.createBuffer(bufferCreateInfo);
-            bufferList.push_back(buffer);
-            const auto memoryRequirements = device.getBufferMemoryRequirements(buffer);
-            const MemoryAllocateInfo allocationInfo(memoryRequirements.size,
-                memoryTypeHostVisibleCoherent);
-            const auto memory = device.allocateMemory(allocationInfo);
-            memoryList.push_back(memory);
-            device.bindBufferMemory(buffer, memory, 0);
-            const auto handle = device.mapMemory(memory, 0, VK_WHOLE_SIZE, {});
-            std::memcpy(handle, textureInfo.data, textureInfo.size);
-            device.unmapMemory(memory);
+            const auto layers = std::max(textureInfo.layers, 1u);
 
             const auto holderInformation = internalImageHolder[i];
             const auto currentImage =
                 textureImageHolder.get<0>(holderInformation.internalHandle);
 
             const Format format = (Format)textureInfo.internalFormatOverride;
+            const auto block = formatBlock(format);
+
+            // Buffer offsets of image copies have to be a multiple of the
+            // block size and of four, the device prefers its optimal alignment
+            const auto copyAlignment = std::lcm(
+                std::lcm((size_t)block.bytes, (size_t)4),
+                std::max<size_t>(deviceLimits.optimalBufferCopyOffsetAlignment, 1));
+            const auto staging = acquireStaging(this, textureInfo.size,
+                copyAlignment);
+            if (staging.buffer) {
+                stagingList.push_back(staging);
+                std::memcpy(staging.mapped, textureInfo.data, textureInfo.size);
+            }
 
             const ImageSubresourceRange range(ImageAspectFlagBits::eColor, 0,
-                mipMapCount, 0, 1);
+                mipMapCount, 0, layers);
 
             waitForImageTransition(
-                commandBuffer, ImageLayout::eUndefined,
+                copyBuffer, ImageLayout::eUndefined,
                 ImageLayout::eTransferDstOptimal, currentImage, range,
                 PipelineStageFlagBits::eTopOfPipe, AccessFlagBits::eNoneKHR,
                 PipelineStageFlagBits::eTransfer, AccessFlagBits::eTransferWrite);
 
+            // Levels are tightly packed and padded to whole blocks, every layer
+            // holds all stored levels, only the first one if mips are blitted
+            const auto levelSize = [&](const uint32_t width, const uint32_t height) {
+                return (size_t)((width + block.width - 1) / block.width) *
+                    ((height + block.height - 1) / block.height) * block.bytes;
+            };
+            const auto storedLevels = blitNeeded ? 1u
+                : textureInfo.mipMapOverrider == INVALID_UINT32 ? mipMapCount
+                : textureInfo.mipMapOverrider;
+            const auto uploadLevels = blitNeeded ? 1u : mipMapCount;
+
             std::vector<vk::BufferImageCopy> bufferToImage;
-            bufferToImage.reserve(blitNeeded ? 1 : mipMapCount);
-            bufferToImage.emplace_back(
-                0u, textureInfo.width, textureInfo.height,
-                ImageSubresourceLayers{ ImageAspectFlagBits::eColor, 0u, 0u, 1u },
-                Offset3D{}, extent);
-
-            if (!blitNeeded) {
-                const auto ratio = formatRatio(format);
-                auto currentOffset = textureInfo.width * textureInfo.height / ratio;
-                auto entry = currentOffset;
-                for (size_t i = 1; i < mipMapCount; i++) {
-                    const uint32_t divider = 1 << i;
-                    currentOffset >>= 2;
-                    currentOffset = std::max(currentOffset, (size_t)16u / ratio);
-                    const auto width = std::max(textureInfo.width / divider, 1u);
-                    const auto height = std::max(textureInfo.height / divider, 1u);
-                    const auto texelWidth = std::max(width, 4u);
-                    const auto texelHeight = std::max(height, 4u);
-                    bufferToImage.emplace_back(
-                        entry, texelWidth, texelHeight,
-                        ImageSubresourceLayers{ ImageAspectFlagBits::eColor, (uint32_t)i, 0,
-                                               1 },
-                        Offset3D{}, Extent3D{ width, height, 1 });
-                    entry += currentOffset;
+            bufferToImage.reserve((size_t)uploadLevels * layers);
+            size_t entry = 0;
+            for (uint32_t layer = 0; layer < layers; layer++) {
+                for (uint32_t level = 0; level < storedLevels; level++) {
+                    const auto width = std::max(textureInfo.width >> level, 1u);
+                    const auto height = std::max(textureInfo.height >> level, 1u);
+                    if (level < uploadLevels) {
+                        bufferToImage.emplace_back(
+                            staging.offset + entry, 0u, 0u,
+                            ImageSubresourceLayers{ ImageAspectFlagBits::eColor, level,
+                                                   layer, 1 },
+                            Offset3D{}, Extent3D{ width, height, 1 });
+                    }
+                    entry += levelSize(width, height);
                 }
             }
+            if (entry > textureInfo.size) {
+                PLOG_ERROR << "Texture " << textureInfo.debugInfo << " needs " << entry
+                    << " bytes but has only " << textureInfo.size << "!";
+                bufferToImage.clear();
+            }
+            // Like a texture that is too short it keeps undefined texels
+            if (!staging.buffer) bufferToImage.clear();
 
-            commandBuffer.copyBufferToImage(
-                buffer, currentImage, ImageLayout::eTransferDstOptimal, bufferToImage);
+            if (!bufferToImage.empty()) {
+                copyBuffer.copyBufferToImage(staging.buffer, currentImage,
+                    ImageLayout::eTransferDstOptimal, bufferToImage);
+            }
+
+            // Images without blits change their layout with the handover
+            const bool blitsMips = blitNeeded && mipMapCount > 1;
+            if (upload) {
+                const auto handoverLayout = blitsMips
+                    ? ImageLayout::eTransferDstOptimal
+                    : ImageLayout::eShaderReadOnlyOptimal;
+                const ImageMemoryBarrier release(AccessFlagBits::eTransferWrite,
+                    AccessFlags(), ImageLayout::eTransferDstOptimal, handoverLayout,
+                    uploadQueue.family, queueFamilyIndex, currentImage, range);
+                copyBuffer.pipelineBarrier(PipelineStageFlagBits::eTransfer,
+                    PipelineStageFlagBits::eBottomOfPipe, {}, {}, {}, release);
+                const ImageMemoryBarrier acquire(AccessFlags(),
+                    blitsMips
+                    ? AccessFlagBits::eTransferRead | AccessFlagBits::eTransferWrite
+                    : AccessFlags(AccessFlagBits::eShaderRead),
+                    ImageLayout::eTransferDstOptimal, handoverLayout,
+                    uploadQueue.family, queueFamilyIndex, currentImage, range);
+                commandBuffer.pipelineBarrier(PipelineStageFlagBits::eTopOfPipe,
+                    blitsMips ? PipelineStageFlagBits::eTransfer
+                    : PipelineStageFlagBits::eFragmentShader,
+                    {}, {}, {}, acquire);
+            }
 
             if (blitNeeded) {
                 vk::ImageBlit blit(
-                    ImageSubresourceLayers{ ImageAspectFlagBits::eColor, 0, 0, 1 },
+                    ImageSubresourceLayers{ ImageAspectFlagBits::eColor, 0, 0, layers },
                     std::array{ Offset3D{},
                                Offset3D(textureInfo.width, textureInfo.height, 1) },
-                    ImageSubresourceLayers{ ImageAspectFlagBits::eColor, 1, 0, 1 },
+                    ImageSubresourceLayers{ ImageAspectFlagBits::eColor, 1, 0, layers },
                     std::array{ Offset3D{}, Offset3D(textureInfo.width / 2,
                                                     textureInfo.height / 2, 1) });
 
                 for (size_t i = 1; i < mipMapCount; i++) {
                     const ImageSubresourceRange rangeIn(
-                        ImageAspectFlagBits::eColor, blit.srcSubresource.mipLevel, 1, 0, 1);
+                        ImageAspectFlagBits::eColor, blit.srcSubresource.mipLevel, 1, 0,
+                        layers);
                     blit.dstOffsets[1].x = std::max(blit.dstOffsets[1].x, 1);
                     blit.dstOffsets[1].y = std::max(blit.dstOffsets[1].y, 1);
 
@@ -976,10 +1548,11 @@ namespace tge::graphics {
 
             const auto rangeLast =
                 blitNeeded ? ImageSubresourceRange{ ImageAspectFlagBits::eColor,
-                                                   (uint32_t)mipMapCount - 1, 1, 0, 1 }
+                                                   (uint32_t)mipMapCount - 1, 1, 0, layers }
                 : ImageSubresourceRange{ ImageAspectFlagBits::eColor, 0,
-                                        (uint32_t)mipMapCount, 0, 1 };
+                                        (uint32_t)mipMapCount, 0, layers };
 
+            if (upload && !blitsMips) continue;
             waitForImageTransition(
                 commandBuffer, ImageLayout::eTransferDstOptimal,
                 ImageLayout::eShaderReadOnlyOptimal, currentImage, rangeLast,
@@ -987,8 +1560,14 @@ namespace tge::graphics {
                 PipelineStageFlagBits::eFragmentShader, AccessFlagBits::eShaderRead);
         }
 
-        const SubmitInfo info({}, {}, commandBuffer);
-        secondarySync->endSubmitAndWait(info, std::move(guard));
+        if (upload) {
+            submitUploadAndWait(this, std::move(uploadGuard), commandBuffer,
+                std::move(guard));
+        }
+        else {
+            const SubmitInfo info({}, {}, commandBuffer);
+            secondarySync->endSubmitAndWait(info, std::move(guard));
+        }
         return internalImageHolder;
     }
 
@@ -1139,9 +1718,15 @@ namespace tge::graphics {
         vgm->viewport = Viewport(0, 0, capabilities.currentExtent.width,
             capabilities.currentExtent.height, 0, 1.0f);
 
+        // Copying the presented image is needed for output readbacks only
+        vgm->outputReadable = (bool)(capabilities.supportedUsageFlags &
+            ImageUsageFlagBits::eTransferSrc);
+        const auto usage = vgm->outputReadable
+            ? ImageUsageFlagBits::eColorAttachment | ImageUsageFlagBits::eTransferSrc
+            : ImageUsageFlags(ImageUsageFlagBits::eColorAttachment);
         const SwapchainCreateInfoKHR swapchainCreateInfo(
             {}, vgm->surface, 3, vgm->format.format, vgm->format.colorSpace,
-            capabilities.currentExtent, 1, ImageUsageFlagBits::eColorAttachment,
+            capabilities.currentExtent, 1, usage,
             SharingMode::eExclusive, 0, nullptr,
             SurfaceTransformFlagBitsKHR::eIdentity,
             CompositeAlphaFlagBitsKHR::eOpaque, vgm->presentMode, true,
@@ -1152,6 +1737,10 @@ namespace tge::graphics {
         vgm->swapchainImages = vgm->device.getSwapchainImagesKHR(vgm->swapchain);
         vgm->needsRefresh.resize(vgm->swapchainImages.size());
         std::ranges::fill(vgm->needsRefresh, 1);
+        while (vgm->presentSemaphores.size() < vgm->swapchainImages.size()) {
+            vgm->presentSemaphores.push_back(vgm->device.createSemaphore({}));
+        }
+        vgm->imagesInFlight.assign(vgm->swapchainImages.size(), Fence());
 
         const Extent2D extent = { (uint32_t)vgm->viewport.width,
                                  (uint32_t)vgm->viewport.height };
@@ -1259,7 +1848,7 @@ namespace tge::graphics {
 #pragma region Instance
         const ApplicationInfo applicationInfo(APPLICATION_NAME, APPLICATION_VERSION,
             ENGINE_NAME, ENGINE_VERSION,
-            VK_API_VERSION_1_0);
+            std::min(enumerateInstanceVersion(), (uint32_t)VK_API_VERSION_1_1));
 
         const auto layerInfos = enumerateInstanceLayerProperties();
         std::vector<const char*> layerEnabled;
@@ -1341,8 +1930,19 @@ namespace tge::graphics {
         std::fill(priorities.begin(), priorities.end(), 0.0f);
         queueIndex = 0;
         secondaryqueueIndex = queueFamily.queueCount > 1 ? 1 : 0;
-        const DeviceQueueCreateInfo queueCreateInfo(
-            {}, queueIndex, secondaryqueueIndex + 1, priorities.data());
+        std::vector<DeviceQueueCreateInfo> queueCreateInfos = { DeviceQueueCreateInfo(
+            {}, queueFamilyIndex, secondaryqueueIndex + 1, priorities.data()) };
+
+        // Families only able to transfer usually map to dedicated copy engines
+        const auto transferFamilyItr = std::find_if(bgnitr, enditr, [](auto queue) {
+            return (queue.queueFlags & QueueFlagBits::eTransfer) &&
+                !(queue.queueFlags & (QueueFlagBits::eGraphics | QueueFlagBits::eCompute));
+            });
+        if (transferQueueEnabled && transferFamilyItr != enditr) {
+            uploadQueue.family = (uint32_t)std::distance(bgnitr, transferFamilyItr);
+            queueCreateInfos.push_back(DeviceQueueCreateInfo({}, uploadQueue.family, 1,
+                priorities.data()));
+        }
 
         const auto devextensions =
             physicalDevice.enumerateDeviceExtensionProperties();
@@ -1352,6 +1952,16 @@ namespace tge::graphics {
                 return strcmp(prop.extensionName, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0;
             });
         if (fndDevExtItr == devextEndItr) return main::Error::SWAPCHAIN_EXT_NOT_FOUND;
+        std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+        // Querying the budget needs the properties2 functions of Vulkan 1.1
+        memoryBudgetSupported =
+            applicationInfo.apiVersion >= VK_API_VERSION_1_1 &&
+            physicalDevice.getProperties().apiVersion >= VK_API_VERSION_1_1 &&
+            std::ranges::any_of(devextensions, [](const ExtensionProperties& prop) {
+                return strcmp(prop.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0;
+            });
+        if (memoryBudgetSupported)
+            deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
 
         this->deviceLimits = this->physicalDevice.getProperties().limits;
         const auto vkFeatures = this->physicalDevice.getFeatures();
@@ -1364,9 +1974,9 @@ namespace tge::graphics {
         enabledFeatures.samplerAnisotropy = features.anisotropicfiltering != 0;
         enabledFeatures.independentBlend = VK_TRUE;
 
-        const char* name = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
-        const DeviceCreateInfo deviceCreateInfo({}, 1, &queueCreateInfo, 0, {}, 1,
-            &name, &enabledFeatures);
+        const DeviceCreateInfo deviceCreateInfo({}, (uint32_t)queueCreateInfos.size(),
+            queueCreateInfos.data(), 0, {}, (uint32_t)deviceExtensions.size(),
+            deviceExtensions.data(), &enabledFeatures);
         this->device = this->physicalDevice.createDevice(deviceCreateInfo);
 
         const auto c4Props =
@@ -1395,8 +2005,11 @@ namespace tge::graphics {
         }
 
         const SemaphoreCreateInfo semaphoreCreateInfo;
-        waitSemaphore = device.createSemaphore(semaphoreCreateInfo);
-        signalSemaphore = device.createSemaphore(semaphoreCreateInfo);
+        if (uploadQueue.family != INVALID_UINT32) {
+            uploadQueue.sync = new QueueSync(
+                this->device, device.getQueue(uploadQueue.family, 0));
+            uploadQueue.semaphore = device.createSemaphore(semaphoreCreateInfo);
+        }
 #pragma endregion
 
 #pragma region Queue, Surface, Prepipe, MemTypes
@@ -1415,21 +2028,29 @@ namespace tge::graphics {
         if (fitr == surfEndItr) return main::Error::FORMAT_NOT_FOUND;
         format = *fitr;
 
-        const auto memoryProperties = physicalDevice.getMemoryProperties();
-        const auto memBeginItr = memoryProperties.memoryTypes.begin();
-        const auto memEndItr = memoryProperties.memoryTypes.end();
-
-        const auto findMemoryIndex = [&](auto prop) {
-            const auto findItr = std::find_if(memBeginItr, memEndItr, [&](auto& type) {
-                return type.propertyFlags & (prop);
-                });
-            return std::distance(memBeginItr, findItr);
-            };
+        memoryProperties = physicalDevice.getMemoryProperties();
+        memoryPools.heapBytes.assign(memoryProperties.memoryHeapCount, 0);
+        const MemoryPropertyFlags hostCoherent = MemoryPropertyFlagBits::eHostVisible |
+            MemoryPropertyFlagBits::eHostCoherent;
+        // Integrated GPUs and software rasterizers only have host visible device
+        // local memory, buffers are written there without staging
+        unifiedMemory = false;
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            const auto flags = memoryProperties.memoryTypes[i].propertyFlags;
+            if (!(flags & MemoryPropertyFlagBits::eDeviceLocal)) continue;
+            unifiedMemory = (flags & hostCoherent) == hostCoherent;
+            if (!unifiedMemory) break;
+        }
 
-        memoryTypeDeviceLocal = findMemoryIndex(MemoryPropertyFlagBits::eDeviceLocal);
-        memoryTypeHostVisibleCoherent =
-            findMemoryIndex(MemoryPropertyFlagBits::eHostVisible |
-                MemoryPropertyFlagBits::eHostCoherent);
+        memoryTypeDeviceLocal = findMemoryType(memoryProperties, ~0u,
+            MemoryPropertyFlagBits::eDeviceLocal);
+        memoryTypeHostVisibleCoherent = findMemoryType(memoryProperties, ~0u, hostCoherent);
+        if (memoryTypeDeviceLocal == INVALID_UINT32 ||
+            memoryTypeHostVisibleCoherent == INVALID_UINT32) {
+            PLOG_ERROR << "No device local or host coherent memory type found!";
+            return main::Error::VULKAN_ERROR;
+        }
+        PLOG_INFO << "Unified memory " << (unifiedMemory ? "enabled" : "disabled");
 
         const auto capabilities = physicalDevice.getSurfaceCapabilitiesKHR(surface);
         viewport = Viewport(0, 0, capabilities.currentExtent.width,
@@ -1563,13 +2184,34 @@ namespace tge::graphics {
         secondaryPool = device.createCommandPool(commandPoolCreateInfo);
         secondaryBufferPool = device.createCommandPool(commandPoolCreateInfo);
 
+        framesInFlight = std::max<size_t>(features.framesInFlight, 1);
         const CommandBufferAllocateInfo cmdBufferAllocInfo(
-            pool, CommandBufferLevel::ePrimary, (uint32_t)3);
-        cmdbuffer = device.allocateCommandBuffers(cmdBufferAllocInfo);
+            pool, CommandBufferLevel::ePrimary, (uint32_t)framesInFlight);
+        for (const auto frameBuffer : device.allocateCommandBuffers(cmdBufferAllocInfo)) {
+            frames.push_back({ frameBuffer, device.createSemaphore(semaphoreCreateInfo),
+                device.createFence({}) });
+        }
 
         const CommandBufferAllocateInfo cmdBufferAllocInfoSecond(
             secondaryPool, CommandBufferLevel::ePrimary, (uint32_t)3);
         noneRenderCmdbuffer = device.allocateCommandBuffers(cmdBufferAllocInfoSecond);
+
+        if (uploadQueue.sync != nullptr) {
+            const CommandPoolCreateInfo uploadPoolInfo(
+                CommandPoolCreateFlagBits::eResetCommandBuffer, uploadQueue.family);
+            uploadQueue.pool = device.createCommandPool(uploadPoolInfo);
+            const CommandBufferAllocateInfo uploadAllocInfo(uploadQueue.pool,
+                CommandBufferLevel::ePrimary, 1);
+            uploadQueue.commandBuffer = device.allocateCommandBuffers(uploadAllocInfo)[0];
+        }
+
+        transferFrames.pool = device.createCommandPool(commandPoolCreateInfo);
+        const CommandBufferAllocateInfo transferAllocInfo(transferFrames.pool,
+            CommandBufferLevel::ePrimary, (uint32_t)std::max<size_t>(transferFrameCount, 1));
+        for (const auto transferBuffer : device.allocateCommandBuffers(transferAllocInfo)) {
+            transferFrames.frames.push_back({ transferBuffer,
+                device.createSemaphore(semaphoreCreateInfo), device.createFence({}) });
+        }
         createSwapchain(this);
 #pragma endregion
 
@@ -1596,23 +2238,241 @@ namespace tge::graphics {
         return main::Error::NONE;
     }
 
+    // Copies the presented image of this frame for every output readback and
+    // returns the fences to signal after the frame was submitted
+    inline std::vector<Fence> recordOutputReadbacks(VulkanGraphicsModule* vgm,
+        const CommandBuffer buffer) {
+        auto& ring = vgm->readbackRing;
+        std::lock_guard ringGuard(ring.mutex);
+        std::vector<Fence> fences;
+        fences.reserve(ring.outputReadbacks.size());
+        const auto image = vgm->swapchainImages[vgm->nextImage];
+        constexpr ImageSubresourceRange range(ImageAspectFlagBits::eColor, 0, 1, 0,
+            1);
+        for (const auto slot : ring.outputReadbacks) {
+            auto& readback = ring.readbacks[slot];
+            fences.push_back(readback.fence);
+            // The swapchain was recreated since, the readback stays empty
+            if (readback.extent.width != (uint32_t)vgm->viewport.width ||
+                readback.extent.height != (uint32_t)vgm->viewport.height) {
+                readback.size = 0;
+                continue;
+            }
+            waitForImageTransition(buffer, ImageLayout::ePresentSrcKHR,
+                ImageLayout::eTransferSrcOptimal, image, range,
+                PipelineStageFlagBits::eColorAttachmentOutput,
+                AccessFlagBits::eColorAttachmentWrite,
+                PipelineStageFlagBits::eTransfer, AccessFlagBits::eTransferRead);
+            constexpr ImageSubresourceLayers layers(ImageAspectFlagBits::eColor, 0, 0,
+                1);
+            const BufferImageCopy copy(readback.offset, 0, 0, layers, {},
+                { readback.extent.width, readback.extent.height, 1 });
+            buffer.copyImageToBuffer(image, ImageLayout::eTransferSrcOptimal,
+                ring.buffer, copy);
+            waitForImageTransition(buffer, ImageLayout::eTransferSrcOptimal,
+                ImageLayout::ePresentSrcKHR, image, range,
+                PipelineStageFlagBits::eTransfer, AccessFlagBits::eTransferRead,
+                PipelineStageFlagBits::eBottomOfPipe, AccessFlagBits::eNoneKHR);
+            const BufferMemoryBarrier hostBarrier(AccessFlagBits::eTransferWrite,
+                AccessFlagBits::eHostRead, VK_QUEUE_FAMILY_IGNORED,
+                VK_QUEUE_FAMILY_IGNORED, ring.buffer, readback.offset, readback.size);
+            buffer.pipelineBarrier(PipelineStageFlagBits::eTransfer,
+                PipelineStageFlagBits::eHost, {}, {}, hostBarrier, {});
+        }
+        ring.outputReadbacks.clear();
+        return fences;
+    }
+
+    // Sparsest device local buffer block whose live buffers fit into the free
+    // space of the other blocks, INVALID_UINT32 if there is none. Packed
+    // buffers are shared by several holders and can't be moved, so blocks
+    // holding one are skipped
+    inline uint32_t findSparseBlock(VulkanGraphicsModule* vgm) {
+        std::unordered_set<uint32_t> packedBlocks;
+        {
+            auto& holder = vgm->bufferDataHolder;
+            std::lock_guard holderGuard(holder.mutex);
+            std::lock_guard packedGuard(vgm->packedBuffersMutex);
+            const auto& buffers = std::get<0>(holder.internalValues);
+            const auto& allocations = std::get<1>(holder.internalValues);
+            for (const auto& [handle, index] : holder.translationTable) {
+                if (vgm->packedBuffers.contains((VkBuffer)buffers[index]))
+                    packedBlocks.insert(allocations[index].block);
+            }
+        }
+        auto& pools = vgm->memoryPools;
+        std::lock_guard guard(pools.mutex);
+        auto sparsest = INVALID_UINT32;
+        for (uint32_t i = 0; i < pools.blocks.size(); i++) {
+            const auto& block = pools.blocks[i];
+            if (!block.memory || block.mapped != nullptr || block.retiring ||
+                block.category != MemoryCategory::GEOMETRY || packedBlocks.contains(i))
+                continue;
+            const auto used = block.allocator.usedSize();
+            if (used > block.allocator.size() * vgm->defragmentThreshold) continue;
+            size_t freeBytes = 0;
+            for (const auto& other : pools.blocks) {
+                if (&other == &block || !other.memory || other.retiring ||
+                    other.type != block.type || other.category != block.category)
+                    continue;
+                freeBytes += other.allocator.size() - other.allocator.usedSize();
+            }
+            if (freeBytes < used) continue;
+            if (sparsest == INVALID_UINT32 ||
+                used < pools.blocks[sparsest].allocator.usedSize())
+                sparsest = i;
+        }
+        if (sparsest != INVALID_UINT32) pools.blocks[sparsest].retiring = true;
+        return sparsest;
+    }
+
+    // Copies live buffers of the retiring block into new buffers in this
+    // frame's transfer and swaps them in, the old ones are released with the
+    // transfer. Returns the moved data, the block is done once all moved or
+    // once a buffer doesn't fit into the free ranges of the other blocks
+    inline std::vector<TDataHolder> moveBuffers(VulkanGraphicsModule* vgm) {
+        std::lock_guard transferGuard(vgm->transferFrames.mutex);
+        auto& holder = vgm->bufferDataHolder;
+        std::lock_guard holderGuard(holder.mutex);
+        auto& [buffers, allocations, sizes, _offsets, alignments, usages] =
+            holder.internalValues;
+        // Orders the copies after earlier changes and before later ones
+        const MemoryBarrier barrier(AccessFlagBits::eTransferWrite,
+            AccessFlagBits::eTransferRead | AccessFlagBits::eTransferWrite);
+
+        std::vector<TDataHolder> moved;
+        TransferFrame* frame = nullptr;
+        size_t copied = 0;
+        bool done = true;
+        bool giveUp = false;
+        for (const auto& [handle, index] : holder.translationTable) {
+            const auto oldAllocation = allocations[index];
+            // The block holds no packed buffers, see findSparseBlock
+            if (oldAllocation.block != vgm->defragmentBlock) continue;
+            if (copied != 0 && copied + sizes[index] > vgm->defragmentBytesPerFrame) {
+                done = false;
+                break;
+            }
+            const BufferCreateInfo createInfo({}, sizes[index], usages[index],
+                SharingMode::eExclusive);
+            const auto buffer = vgm->device.createBuffer(createInfo);
+            const auto requirements = vgm->device.getBufferMemoryRequirements(buffer);
+            // Only free ranges of the other blocks are used, a new block would
+            // grow the memory the step is meant to shrink
+            const auto allocation = allocateFromPools(vgm, requirements,
+                oldAllocation.type, oldAllocation.category, true);
+            if (!allocation.memory) {
+                vgm->device.destroyBuffer(buffer);
+                giveUp = true;
+                break;
+            }
+            vgm->device.bindBufferMemory(buffer, allocation.memory, allocation.offset);
+
+            if (frame == nullptr) {
+                frame = &beginTransferFrame(vgm);
+                frame->commandBuffer.pipelineBarrier(PipelineStageFlagBits::eTransfer,
+                    PipelineStageFlagBits::eTransfer, {}, barrier, {}, {});
+            }
+            frame->commandBuffer.copyBuffer(buffers[index], buffer,
+                BufferCopy(0, 0, sizes[index]));
+            frame->retiredBuffers.emplace_back(buffers[index], oldAllocation);
+            buffers[index] = buffer;
+            allocations[index] = allocation;
+            alignments[index] = requirements.alignment;
+            moved.push_back(TDataHolder(handle));
+            copied += sizes[index];
+        }
+        if (frame != nullptr) {
+            frame->commandBuffer.pipelineBarrier(PipelineStageFlagBits::eTransfer,
+                PipelineStageFlagBits::eTransfer, {}, barrier, {}, {});
+        }
+        if (giveUp) {
+            // The free space is too fragmented, the block is used again and
+            // the next step looks for another one
+            std::lock_guard guard(vgm->memoryPools.mutex);
+            vgm->memoryPools.blocks[vgm->defragmentBlock].retiring = false;
+        }
+        if (done || giveUp) vgm->defragmentBlock = INVALID_UINT32;
+        return moved;
+    }
+
+    // Empties sparse device local buffer blocks a few buffers per tick so they
+    // can be freed, the descriptor sets and render commands using the moved
+    // buffers are updated
+    inline void defragmentBuffers(VulkanGraphicsModule* vgm) {
+        if (vgm->defragmentBytesPerFrame == 0) return;
+        // Every step waits for the frames in flight, so steps are spread out
+        if (vgm->ticksSinceDefragment < vgm->defragmentInterval) {
+            vgm->ticksSinceDefragment++;
+            return;
+        }
+        std::vector<TDataHolder> moved;
+        {
+            // Uploads in flight write into their buffers, try again next tick
+            std::unique_lock moveGuard(vgm->bufferMoveMutex, std::try_to_lock);
+            if (!moveGuard) return;
+            if (vgm->defragmentBlock == INVALID_UINT32)
+                vgm->defragmentBlock = findSparseBlock(vgm);
+            if (vgm->defragmentBlock == INVALID_UINT32) return;
+            moved = moveBuffers(vgm);
+        }
+        if (moved.empty()) return;
+        vgm->ticksSinceDefragment = 0;
+        {
+            // Descriptor sets can only be written while no frame uses them
+            auto guard = waitForFrames(vgm);
+            ((shader::VulkanShaderModule*)vgm->shaderAPI)->rebindBuffers(moved);
+        }
+        const std::unordered_set<TDataHolder> movedSet(moved.begin(), moved.end());
+        std::unique_lock lock(vgm->renderInfosForRetryHolder);
+        for (const auto [renderHolder, target] : vgm->renderInfosForRetry) {
+            const auto data = vgm->secondaryCommandBuffer.get<3>(renderHolder.internalHandle);
+            if (std::ranges::none_of(data,
+                [&](const TDataHolder holder) { return movedSet.contains(holder); }))
+                continue;
+            const auto currentVector =
+                vgm->secondaryCommandBuffer.get<1>(renderHolder.internalHandle);
+            if (currentVector.empty()) continue;
+            (void)vgm->pushRender(currentVector.size(), currentVector.data(),
+                renderHolder, target);
+        }
+    }
+
     void VulkanGraphicsModule::tick(double time) {
         const auto winModule = this->getGraphicsModule()->getWindowModule();
-        if (winModule->isMinimized() || exitFailed) return;
-
-        if (this->nextImage > cmdbuffer.size()) {
-            PLOG(plog::fatal) << "Size greater command buffer size!";
+        if (winModule->isMinimized() || exitFailed) {
+            submitTransferFrame(this, false);
+            return;
+        }
+        const auto pressure = memoryPressure(this);
+        if (pressure != 0) notifyMemoryPressure(pressure);
+        defragmentBuffers(this);
+
+        auto& frame = frames[currentFrame];
+        // Usually signaled long ago, only blocks if the CPU runs ahead
+        if (frame.submitted) {
+            const auto result = device.waitForFences(frame.fence, true, INVALID_SIZE_T);
+            VERROR(result);
         }
 
         auto nextimage = device.acquireNextImageKHR(swapchain, INVALID_SIZE_T,
-            waitSemaphore, {});
+            frame.acquired, {});
         if (checkAndRecreate(this, nextimage.result)) {
-            device.destroySemaphore(waitSemaphore);
-            waitSemaphore = device.createSemaphore({});
+            submitTransferFrame(this, false);
+            device.destroySemaphore(frame.acquired);
+            frame.acquired = device.createSemaphore({});
             return;
         }
         this->nextImage = nextimage.value;
-        const auto currentBuffer = cmdbuffer[this->nextImage];
+        // An older frame still rendering into the same image
+        const auto imageFence = imagesInFlight[this->nextImage];
+        if (imageFence && imageFence != frame.fence) {
+            const auto result = device.waitForFences(imageFence, true, INVALID_SIZE_T);
+            VERROR(result);
+        }
+        imagesInFlight[this->nextImage] = frame.fence;
+        const auto currentBuffer = frame.commandBuffer;
+        std::vector<Fence> outputReadbacks;
 
         if (true) {
             needsRefresh[this->nextImage] = 0;
@@ -1624,7 +2484,8 @@ namespace tge::graphics {
                                            ClearValue(clearColor),
                                            ClearValue(clearColor) };
 
-            const CommandBufferBeginInfo cmdBufferBeginInfo({}, nullptr);
+            const CommandBufferBeginInfo cmdBufferBeginInfo(
+                CommandBufferUsageFlagBits::eOneTimeSubmit, nullptr);
             auto currentLock = primarySync->begin(currentBuffer, cmdBufferBeginInfo);
 
             const RenderPassBeginInfo renderPassBeginInfo(
@@ -1698,6 +2559,8 @@ namespace tge::graphics {
                 textureImageHolder.get<0>(internalImageData[0]),
                 { ImageAspectFlagBits::eDepth, 0, 1, 0, 1 });
 
+            outputReadbacks = recordOutputReadbacks(this, currentBuffer);
+
             currentBuffer.end();
         }
 
@@ -1706,17 +2569,30 @@ namespace tge::graphics {
         constexpr PipelineStageFlags stageFlag =
             PipelineStageFlagBits::eColorAttachmentOutput |
             PipelineStageFlagBits::eLateFragmentTests;
-        const SubmitInfo submitInfo(waitSemaphore, stageFlag, primary,
-            signalSemaphore);
+        std::vector<Semaphore> frameWaits = { frame.acquired };
+        std::vector<PipelineStageFlags> frameWaitStages = { stageFlag };
+        // The buffer changes of this frame have to land before they are read
+        if (const auto transferSemaphore = submitTransferFrame(this, true)) {
+            frameWaits.push_back(transferSemaphore);
+            frameWaitStages.push_back(BUFFER_READ_STAGES);
+        }
+        const auto presentSemaphore = presentSemaphores[this->nextImage];
+        const SubmitInfo submitInfo(frameWaits, frameWaitStages, primary,
+            presentSemaphore);
 
-        const PresentInfoKHR presentInfo(signalSemaphore, swapchain, this->nextImage,
+        const PresentInfoKHR presentInfo(presentSemaphore, swapchain, this->nextImage,
             nullptr);
 
-        primarySync->submit(submitInfo);
-
         Result result;
         {
-            std::lock_guard lockGuard(primarySync->handle);
+            auto lockGuard = primarySync->waitAndGet();
+            device.resetFences(frame.fence);
+            primarySync->queue.submit(submitInfo, frame.fence);
+            frame.submitted = true;
+            currentFrame = (currentFrame + 1) % frames.size();
+            // Signaled once the frame and with it the copies are done
+            for (const auto fence : outputReadbacks)
+                primarySync->queue.submit(nullptr, fence);
             result = primarySync->queue.presentKHR(&presentInfo);
         }
         checkAndRecreate(this, result);
@@ -1728,21 +2604,63 @@ namespace tge::graphics {
         this->shaderAPI->destroy();
         delete primarySync;
         if (primarySync != secondarySync) delete secondarySync;
-        device.destroySemaphore(waitSemaphore);
-        device.destroySemaphore(signalSemaphore);
+        if (uploadQueue.sync != nullptr) {
+            delete uploadQueue.sync;
+            device.destroySemaphore(uploadQueue.semaphore);
+            device.destroyCommandPool(uploadQueue.pool);
+        }
+        for (const auto& frame : frames) {
+            device.destroySemaphore(frame.acquired);
+            device.destroyFence(frame.fence);
+        }
+        frames.clear();
+        for (const auto semaphore : presentSemaphores) device.destroySemaphore(semaphore);
+        presentSemaphores.clear();
+        if (readbackRing.buffer) {
+            for (const auto& readback : readbackRing.readbacks)
+                device.destroyFence(readback.fence);
+            device.destroyCommandPool(readbackRing.pool);
+            device.destroyBuffer(readbackRing.buffer);
+            releaseMemory(this, readbackRing.memory);
+        }
+        for (const auto& frame : transferFrames.frames) {
+            for (const auto& staging : frame.staging) releaseStaging(this, staging);
+            for (const auto& [buffer, allocation] : frame.retiredBuffers) {
+                device.destroyBuffer(buffer);
+                releaseMemory(this, allocation);
+            }
+            device.destroySemaphore(frame.semaphore);
+            device.destroyFence(frame.fence);
+        }
+        transferFrames.frames.clear();
+        if (transferFrames.pool) device.destroyCommandPool(transferFrames.pool);
+        if (stagingRing.buffer) {
+            device.destroyBuffer(stagingRing.buffer);
+            releaseMemory(this, stagingRing.memory);
+        }
         auto [imageList, viewList, memoryList, _u1, _u2] = textureImageHolder.clear();
         for (auto image : imageList) device.destroy(image);
         for (auto view : viewList) device.destroy(view);
-        const auto imageMemoryEnd = std::unique(memoryList.begin(), memoryList.end());
-        for (auto iterator = memoryList.begin(); iterator != imageMemoryEnd;
-            iterator++)
-            device.freeMemory(*iterator);
         for (const auto samp : sampler) device.destroySampler(samp);
-        for (const auto memory :
-            std::ranges::unique(std::get<1>(bufferDataHolder.internalValues)))
-            device.freeMemory(memory);
-        for (const auto buf : std::get<0>(bufferDataHolder.internalValues))
-            device.destroyBuffer(buf);
+        // Ranges of packed buffers share their buffer and memory
+        std::unordered_set<VkBuffer> destroyedBuffers;
+        for (const auto buf : std::get<0>(bufferDataHolder.internalValues)) {
+            if (destroyedBuffers.insert((VkBuffer)buf).second) device.destroyBuffer(buf);
+        }
+        // Blocks are freed as a whole, only dedicated allocations on their own
+        for (const auto& allocation : memoryList) {
+            if (allocation.block == INVALID_UINT32) device.freeMemory(allocation.memory);
+        }
+        std::unordered_set<VkDeviceMemory> freedMemory;
+        for (const auto& allocation : std::get<1>(bufferDataHolder.internalValues)) {
+            if (allocation.block == INVALID_UINT32 &&
+                freedMemory.insert((VkDeviceMemory)allocation.memory).second)
+                device.freeMemory(allocation.memory);
+        }
+        for (const auto& block : memoryPools.blocks) {
+            if (block.memory) device.freeMemory(block.memory);
+        }
+        memoryPools.blocks.clear();
         const auto pipeList = std::get<0>(materialHolder.clear());
         for (const auto pipe : pipeList) device.destroyPipeline(pipe);
         for (const auto shader : shaderModules) device.destroyShaderModule(shader);
@@ -1783,7 +2701,7 @@ namespace tge::graphics {
             const auto tuple = secondaryCommandBuffer.compact();
             const auto& lostBuffer = std::get<0>(tuple);
             if (!lostBuffer.empty()) {
-                auto guard1 = this->primarySync->waitAndGet();
+                auto guard1 = waitForFrames(this);
                 std::unique_lock<std::mutex> guard2;
                 if (this->primarySync != this->secondarySync)
                     guard2 = this->secondarySync->waitAndGet();
@@ -1801,6 +2719,7 @@ namespace tge::graphics {
                 holder.resize(oldSize + values.size());
                 std::copy(values.begin(), values.end(), holder.begin() + oldSize);
             }
+            // Renders sharing a cached buffer each hold a reference to it
             removeData(holder, true);
         }
     }
@@ -1811,63 +2730,264 @@ namespace tge::graphics {
 
     APILayer* getNewVulkanModule() { return new VulkanGraphicsModule(); }
 
+    // The cache is not needed anymore with the readback ring and only
+    // passed back
     std::pair<std::vector<char>, TDataHolder> VulkanGraphicsModule::getImageData(
         const TTextureHolder imageId, const TDataHolder cache) {
-        const auto currentImage = textureImageHolder.get<0>(imageId);
-        const auto requireMents = device.getImageMemoryRequirements(currentImage);
-
-        Buffer dataBuffer(nullptr);
-        DeviceMemory memoryBuffer(nullptr);
-        TDataHolder dataHolder = cache;
-        if (!dataHolder) {
-            const BufferCreateInfo bufferCreateInfo({}, requireMents.size,
-                BufferUsageFlagBits::eTransferDst);
-            const auto& [output, memory, returnID] =
-                internalBuffer<true>(this, 1, &bufferCreateInfo, true);
-            dataBuffer = output.back().buffer;
-            memoryBuffer = memory;
-            dataHolder = TDataHolder(returnID);
+        const auto readback = readImageAsync(imageId);
+        if (!readback) return std::make_pair(std::vector<char>(), cache);
+        const auto data = getReadbackData(readback);
+        std::vector<char> vector(data.begin(), data.end());
+        releaseReadback(readback);
+        return std::make_pair(std::move(vector), cache);
+    }
+
+    // Copy offsets have to be a multiple of the texel or block size
+    constexpr size_t READBACK_ALIGNMENT = 256;
+
+    // Creates the ring on first use and grows it while it is unused
+    inline bool reserveReadbackRing(VulkanGraphicsModule* vgm, const size_t size) {
+        auto& ring = vgm->readbackRing;
+        const auto device = vgm->device;
+        if (ring.buffer && ring.allocator.size() >= size) return true;
+        if (ring.buffer) {
+            if (!ring.allocator.empty()) {
+                PLOG_WARNING << "Readback of " << size
+                    << " bytes does not fit into the readback ring!";
+                return false;
+            }
+            device.destroyBuffer(ring.buffer);
+            releaseMemory(vgm, ring.memory);
         }
         else {
-            dataBuffer = bufferDataHolder.get<0>(dataHolder);
-            memoryBuffer = bufferDataHolder.get<1>(dataHolder);
+            const CommandPoolCreateInfo poolInfo(
+                CommandPoolCreateFlagBits::eResetCommandBuffer, vgm->queueFamilyIndex);
+            ring.pool = device.createCommandPool(poolInfo);
         }
+        const auto capacity = std::max(vgm->readbackRingSize, size);
+        const BufferCreateInfo bufferInfo({}, capacity,
+            BufferUsageFlagBits::eTransferDst, SharingMode::eExclusive, {});
+        ring.buffer = device.createBuffer(bufferInfo);
+        const auto requirements = device.getBufferMemoryRequirements(ring.buffer);
+
+        // Cached memory makes reading the mapped texels fast
+        const auto& properties = vgm->memoryProperties;
+        const auto type = findMemoryType(properties, requirements.memoryTypeBits,
+            MemoryPropertyFlagBits::eHostVisible, MemoryPropertyFlagBits::eHostCached);
+        if (type == INVALID_UINT32) {
+            PLOG_ERROR << "No host visible memory for readbacks!";
+            device.destroyBuffer(ring.buffer);
+            ring.buffer = Buffer();
+            return false;
+        }
+        ring.coherent = (bool)(properties.memoryTypes[type].propertyFlags &
+            MemoryPropertyFlagBits::eHostCoherent);
 
-        const auto buffer = noneRenderCmdbuffer[DATA_ONLY_BUFFER];
-        static constexpr CommandBufferBeginInfo info;
-        std::unique_lock<std::mutex> lockGuard;
-        if (secondarySync != primarySync) {
-            lockGuard = std::unique_lock(secondarySync->handle);
+        ring.memory = allocateMemory(vgm, requirements, type, MemoryCategory::STAGING);
+        device.bindBufferMemory(ring.buffer, ring.memory.memory, ring.memory.offset);
+        ring.allocator = RingAllocator(capacity);
+        return true;
+    }
+
+    // Reserves ring space and a slot with its command buffer and fence, the
+    // ring mutex has to be held. INVALID_SIZE_T if the ring is full
+    inline size_t acquireReadback(VulkanGraphicsModule* vgm, const size_t size) {
+        auto& ring = vgm->readbackRing;
+        if (!reserveReadbackRing(vgm, size)) return INVALID_SIZE_T;
+        const auto offset = ring.allocator.allocate(size, READBACK_ALIGNMENT);
+        if (offset == INVALID_SIZE_T) {
+            PLOG_WARNING << "Readback ring is full, release older readbacks!";
+            return INVALID_SIZE_T;
         }
-        auto guard = primarySync->begin(buffer, info);
 
+        size_t slot;
+        if (ring.freeReadbacks.empty()) {
+            const CommandBufferAllocateInfo allocateInfo(ring.pool,
+                CommandBufferLevel::ePrimary, 1);
+            slot = ring.readbacks.size();
+            ring.readbacks.push_back({
+                vgm->device.allocateCommandBuffers(allocateInfo)[0],
+                vgm->device.createFence({}) });
+        }
+        else {
+            slot = ring.freeReadbacks.back();
+            ring.freeReadbacks.pop_back();
+        }
+        auto& readback = ring.readbacks[slot];
+        readback.offset = offset;
+        readback.size = size;
+        return slot;
+    }
+
+    // Handles carry the generation of their slot in the upper bits, so a handle
+    // kept after its release doesn't reach the next readback of the slot
+    constexpr size_t READBACK_SLOT_BITS = 32;
+
+    inline TReadbackHolder readbackHandle(const VulkanGraphicsModule* vgm,
+        const size_t slot) {
+        const auto generation = vgm->readbackRing.readbacks[slot].generation;
+        return TReadbackHolder(slot | ((size_t)generation << READBACK_SLOT_BITS));
+    }
+
+    inline size_t readbackSlot(const TReadbackHolder readback) {
+        return readback.internalHandle & (((size_t)1 << READBACK_SLOT_BITS) - 1);
+    }
+
+    // Entry of a pending readback, nullptr for invalid, released or stale
+    // handles. The ring mutex has to be held
+    inline Readback* findReadback(VulkanGraphicsModule* vgm,
+        const TReadbackHolder readback) {
+        auto& ring = vgm->readbackRing;
+        const auto slot = readbackSlot(readback);
+        if (!readback || slot >= ring.readbacks.size()) return nullptr;
+        auto& entry = ring.readbacks[slot];
+        if (entry.offset == INVALID_SIZE_T ||
+            entry.generation != readback.internalHandle >> READBACK_SLOT_BITS)
+            return nullptr;
+        return &entry;
+    }
+
+    TReadbackHolder VulkanGraphicsModule::readImageAsync(
+        const TTextureHolder imageId) {
+        EXPECT(!(!imageId));
+        const auto currentImage = textureImageHolder.get<0>(imageId);
+        const auto imageInfo = textureImageHolder.get<4>(imageId);
+        const auto block = formatBlock(imageInfo.format);
+        const auto width = imageInfo.extent.width, height = imageInfo.extent.height;
+        const auto size = (size_t)((width + block.width - 1) / block.width) *
+            ((height + block.height - 1) / block.height) * block.bytes;
+
+        std::unique_lock ringGuard(readbackRing.mutex);
+        const auto slot = acquireReadback(this, size);
+        if (slot == INVALID_SIZE_T) return TReadbackHolder();
+        auto& readback = readbackRing.readbacks[slot];
+        readback.extent = Extent2D(width, height);
+        readback.format = imageInfo.format;
+        const auto offset = readback.offset;
+        const auto fence = readback.fence;
+        const auto handle = readbackHandle(this, slot);
+
+        const auto buffer = readback.commandBuffer;
+        buffer.begin(CommandBufferBeginInfo(CommandBufferUsageFlagBits::eOneTimeSubmit));
         constexpr ImageSubresourceRange range(ImageAspectFlagBits::eColor, 0, 1, 0,
             1);
-
         waitForImageTransition(buffer, ImageLayout::eShaderReadOnlyOptimal,
-            ImageLayout::eTransferSrcOptimal, currentImage, range);
-
-        const auto oldInfo = this->textureImageHolder.get<4>(imageId);
+            ImageLayout::eTransferSrcOptimal, currentImage, range,
+            PipelineStageFlagBits::eAllCommands, AccessFlagBits::eMemoryWrite,
+            PipelineStageFlagBits::eTransfer, AccessFlagBits::eTransferRead);
         constexpr ImageSubresourceLayers layers(ImageAspectFlagBits::eColor, 0, 0, 1);
-        const BufferImageCopy imageInfo(
-            0, 0, 0, layers, {}, { oldInfo.extent.width, oldInfo.extent.height, 1 });
+        const BufferImageCopy copy(offset, 0, 0, layers, {}, { width, height, 1 });
         buffer.copyImageToBuffer(currentImage, ImageLayout::eTransferSrcOptimal,
-            dataBuffer, imageInfo);
-
+            readbackRing.buffer, copy);
         waitForImageTransition(buffer, ImageLayout::eTransferSrcOptimal,
-            ImageLayout::eShaderReadOnlyOptimal, currentImage,
-            range);
-
+            ImageLayout::eShaderReadOnlyOptimal, currentImage, range,
+            PipelineStageFlagBits::eTransfer, AccessFlagBits::eTransferRead,
+            PipelineStageFlagBits::eAllGraphics, AccessFlagBits::eShaderRead);
+        const BufferMemoryBarrier hostBarrier(AccessFlagBits::eTransferWrite,
+            AccessFlagBits::eHostRead, VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED, readbackRing.buffer, offset, size);
+        buffer.pipelineBarrier(PipelineStageFlagBits::eTransfer,
+            PipelineStageFlagBits::eHost, {}, {}, hostBarrier, {});
+        buffer.end();
+        // tick takes the ring mutex while it holds the queue, so the queue is
+        // never locked with the ring mutex held. The handle isn't out yet, so
+        // nobody else touches the slot meanwhile
+        ringGuard.unlock();
+
+        // Submitted behind the frames on the render queue without waiting
+        std::unique_lock<std::mutex> secondaryGuard;
+        if (secondarySync != primarySync) {
+            secondaryGuard = std::unique_lock(secondarySync->handle);
+        }
+        std::lock_guard queueGuard(primarySync->handle);
         const SubmitInfo submit({}, {}, buffer, {});
-        primarySync->endSubmitAndWait(submit, std::move(guard));
+        primarySync->queue.submit(submit, fence);
+        return handle;
+    }
 
-        std::vector<char> vector(requireMents.size);
-        const char* readMemory =
-            (char*)device.mapMemory(memoryBuffer, 0, requireMents.size);
-        std::copy(readMemory, (readMemory + requireMents.size), vector.begin());
-        device.unmapMemory(memoryBuffer);
+    TReadbackHolder VulkanGraphicsModule::readOutputAsync() {
+        if (!outputReadable) {
+            PLOG_WARNING << "The swapchain images can not be copied!";
+            return TReadbackHolder();
+        }
+        const auto block = formatBlock(format.format);
+        const Extent2D extent((uint32_t)viewport.width, (uint32_t)viewport.height);
+        const auto size = (size_t)extent.width * extent.height * block.bytes;
+
+        std::lock_guard ringGuard(readbackRing.mutex);
+        const auto slot = acquireReadback(this, size);
+        if (slot == INVALID_SIZE_T) return TReadbackHolder();
+        auto& readback = readbackRing.readbacks[slot];
+        readback.extent = extent;
+        readback.format = format.format;
+        // Recorded and submitted by the next render
+        readbackRing.outputReadbacks.push_back(slot);
+        return readbackHandle(this, slot);
+    }
 
-        return std::make_pair(vector, dataHolder);
+    TextureInfo VulkanGraphicsModule::getReadbackInfo(
+        const TReadbackHolder readback) {
+        std::lock_guard ringGuard(readbackRing.mutex);
+        const auto entry = findReadback(this, readback);
+        if (entry == nullptr) {
+            PLOG_WARNING << "Readback " << readback.internalHandle << " is not valid!";
+            return {};
+        }
+        TextureInfo info;
+        info.size = (uint32_t)entry->size;
+        info.width = entry->extent.width;
+        info.height = entry->extent.height;
+        info.channel = 4;
+        info.internalFormatOverride = (size_t)entry->format;
+        return info;
+    }
+
+    bool VulkanGraphicsModule::isReadbackReady(const TReadbackHolder readback) {
+        std::lock_guard ringGuard(readbackRing.mutex);
+        const auto entry = findReadback(this, readback);
+        if (entry == nullptr) return false;
+        return device.getFenceStatus(entry->fence) == Result::eSuccess;
+    }
+
+    std::span<const char> VulkanGraphicsModule::getReadbackData(
+        const TReadbackHolder readback) {
+        std::lock_guard ringGuard(readbackRing.mutex);
+        const auto entry = findReadback(this, readback);
+        if (entry == nullptr) {
+            PLOG_WARNING << "Readback " << readback.internalHandle << " is not valid!";
+            return {};
+        }
+        if (std::ranges::find(readbackRing.outputReadbacks, readbackSlot(readback)) !=
+            readbackRing.outputReadbacks.end())
+            return {};
+        const auto result = device.waitForFences(entry->fence, true, INVALID_SIZE_T);
+        VERROR(result);
+        if (!readbackRing.coherent) {
+            const auto atom = deviceLimits.nonCoherentAtomSize;
+            const MappedMemoryRange range(readbackRing.memory.memory,
+                (readbackRing.memory.offset + entry->offset) / atom * atom, VK_WHOLE_SIZE);
+            device.invalidateMappedMemoryRanges(range);
+        }
+        return std::span(readbackRing.memory.mapped + entry->offset, entry->size);
+    }
+
+    void VulkanGraphicsModule::releaseReadback(const TReadbackHolder readback) {
+        std::lock_guard ringGuard(readbackRing.mutex);
+        const auto entry = findReadback(this, readback);
+        if (entry == nullptr) return;
+        const auto slot = readbackSlot(readback);
+        // Output readbacks that were never recorded have nothing to wait for
+        const auto erased = std::erase(readbackRing.outputReadbacks, slot);
+        if (erased == 0) {
+            // The ring space can only be reused once the copy is done
+            const auto result = device.waitForFences(entry->fence, true, INVALID_SIZE_T);
+            VERROR(result);
+            device.resetFences(entry->fence);
+        }
+        readbackRing.allocator.release(entry->offset);
+        entry->offset = INVALID_SIZE_T;
+        entry->generation++;
+        readbackRing.freeReadbacks.push_back(slot);
     }
 
     void VulkanGraphicsModule::initDebugGUI() {
@@ -5,6 +5,7 @@
 #include <glslang/SPIRV/GlslangToSpv.h>
 
 #include <iostream>
+#include <unordered_set>
 #include <vulkan/vulkan.hpp>
 
 #include "../../../public/Error.hpp"
@@ -165,7 +166,9 @@ inline std::pair<DescriptorType, uint32_t> getDescTypeFromELF(
       return std::pair(DescriptorType::eSampler, count);
     return std::pair(DescriptorType::eSampledImage, count);
   } else if (type.getBasicType() == glslang::TBasicType::EbtBlock) {
-    return std::pair(DescriptorType::eUniformBuffer, count);
+    if (type.getQualifier().storage == glslang::TStorageQualifier::EvqBuffer)
+      return std::pair(DescriptorType::eStorageBuffer, count);
+    return std::pair(DescriptorType::eUniformBufferDynamic, count);
   }
   std::cout << type.getQualifier().layoutAttachment << " <- Attachment";
   throw std::runtime_error("Descriptor could not be found for: " +
@@ -257,6 +260,16 @@ void __implCreateDescSets(VulkanShaderPipe* shaderPipe,
     const auto descPool = vgm->device.createDescriptorPool(descPoolCreateInfo);
     vsm->descPools.push_back(descPool);
 
+    std::vector<uint32_t> dynamicBindings;
+    for (const auto& binding : shaderPipe->descriptorLayoutBindings) {
+      if (binding.descriptorType != DescriptorType::eUniformBufferDynamic)
+        continue;
+      dynamicBindings.insert(dynamicBindings.end(), binding.descriptorCount,
+                             binding.binding);
+    }
+    std::ranges::sort(dynamicBindings);
+    vsm->dynamicBindings.push_back(std::move(dynamicBindings));
+
     const auto layoutCreateInfo =
         PipelineLayoutCreateInfo({}, descLayout, shaderPipe->constranges);
     const auto pipeLayout = vgm->device.createPipelineLayout(layoutCreateInfo);
@@ -344,9 +357,12 @@ std::vector<TBindingHolder> VulkanShaderModule::createBindings(
   const auto layout = shaderPipe->layoutID;
   if (layout == INVALID_SIZE_T) return {};
   auto output = bindingHolder.allocate(count);
-  auto [descriptorSets, layoutsOut, pipeLayouts, status, expected] =
-      output.iterator;
+  auto [descriptorSets, layoutsOut, pipeLayouts, status, expected, layoutIDs,
+        offsets] = output.iterator;
   std::fill(layoutsOut, layoutsOut + count, this->setLayouts[layout]);
+  std::fill(layoutIDs, layoutIDs + count, layout);
+  std::fill(offsets, offsets + count,
+            std::vector<uint32_t>(this->dynamicBindings[layout].size(), 0));
 #ifdef DEBUG
   std::fill(status, status + count, 0);
   size_t allBindings = 0;
@@ -367,6 +383,42 @@ std::vector<TBindingHolder> VulkanShaderModule::createBindings(
   return output.generateOutputArray<TBindingHolder>(count);
 }
 
+std::vector<TBindingHolder> VulkanShaderModule::shareBindings(
+    const TBindingHolder bindingSet, const size_t count) {
+  const auto descriptorSet = bindingHolder.get<0>(bindingSet);
+  const auto setLayout = bindingHolder.get<1>(bindingSet);
+  const auto pipeLayout = bindingHolder.get<2>(bindingSet);
+  const auto bound = bindingHolder.get<3>(bindingSet);
+  const auto expectedBound = bindingHolder.get<4>(bindingSet);
+  const auto layout = bindingHolder.get<5>(bindingSet);
+  const auto dynamicOffsets = bindingHolder.get<6>(bindingSet);
+  auto output = bindingHolder.allocate(count);
+  auto [descriptorSets, layoutsOut, pipeLayouts, status, expected, layoutIDs,
+        offsets] = output.iterator;
+  std::fill(descriptorSets, descriptorSets + count, descriptorSet);
+  std::fill(layoutsOut, layoutsOut + count, setLayout);
+  std::fill(pipeLayouts, pipeLayouts + count, pipeLayout);
+  // Bindings are only tracked for the holder they were bound through
+  std::fill(status, status + count, bound);
+  std::fill(expected, expected + count, expectedBound);
+  std::fill(layoutIDs, layoutIDs + count, layout);
+  std::fill(offsets, offsets + count, dynamicOffsets);
+  return output.generateOutputArray<TBindingHolder>(count);
+}
+
+void VulkanShaderModule::setDynamicOffset(const TBindingHolder bindingSet,
+                                          const size_t binding,
+                                          const uint32_t offset) {
+  const auto& bindings = dynamicBindings[bindingHolder.get<5>(bindingSet)];
+  const auto found = std::ranges::find(bindings, (uint32_t)binding);
+  if (found == bindings.end()) {
+    PLOG_WARNING << "Binding " << binding << " is no uniform buffer!";
+    return;
+  }
+  bindingHolder.change<6>(bindingSet)
+      .data[std::distance(bindings.begin(), found)] = offset;
+}
+
 void VulkanShaderModule::changeInputBindings(const ShaderPipe pipe,
                                              const size_t bindingID,
                                              const size_t buffer) {}
@@ -395,14 +447,20 @@ void VulkanShaderModule::bindData(const BindingInfo* info, const size_t count) {
         const auto& bufferBindingInfo = cinfo.data.buffer;
         const auto buffer =
             vgm->bufferDataHolder.get<0>(bufferBindingInfo.dataID);
-        bufferInfo[i] = (DescriptorBufferInfo(buffer, bufferBindingInfo.offset,
-                                              bufferBindingInfo.size));
+        // Packed data starts at its range in the shared buffer
+        const auto rangeOffset =
+            vgm->bufferDataHolder.get<3>(bufferBindingInfo.dataID);
+        bufferInfo[i] = (DescriptorBufferInfo(
+            buffer, rangeOffset + bufferBindingInfo.offset,
+            bufferBindingInfo.size));
         set.push_back(
             WriteDescriptorSet(descriptorSet, cinfo.binding, 0, 1,
                                cinfo.type == BindingType::UniformBuffer
-                                   ? DescriptorType::eUniformBuffer
+                                   ? DescriptorType::eUniformBufferDynamic
                                    : DescriptorType::eStorageBuffer,
                                nullptr, bufferInfo.data() + i));
+        std::lock_guard guard(bufferBindingsMutex);
+        bufferBindings[{(VkDescriptorSet)descriptorSet, cinfo.binding}] = cinfo;
       } break;
       case BindingType::Texture:
       case BindingType::Sampler:
@@ -430,11 +488,36 @@ void VulkanShaderModule::bindData(const BindingInfo* info, const size_t count) {
   return;
 }
 
+void VulkanShaderModule::rebindBuffers(
+    const std::span<const graphics::TDataHolder> buffers) {
+  const std::unordered_set<graphics::TDataHolder> moved(buffers.begin(),
+                                                        buffers.end());
+  std::vector<BindingInfo> bindings;
+  {
+    std::lock_guard guard(bufferBindingsMutex);
+    for (const auto& [key, binding] : bufferBindings) {
+      if (moved.contains(binding.data.buffer.dataID)) bindings.push_back(binding);
+    }
+  }
+  if (!bindings.empty()) bindData(bindings.data(), bindings.size());
+}
+
+void VulkanShaderModule::forgetBuffers(
+    const std::span<const graphics::TDataHolder> buffers) {
+  const std::unordered_set<graphics::TDataHolder> removed(buffers.begin(),
+                                                          buffers.end());
+  std::lock_guard guard(bufferBindingsMutex);
+  std::erase_if(bufferBindings, [&](const auto& entry) {
+    return removed.contains(entry.second.data.buffer.dataID);
+  });
+}
+
 void VulkanShaderModule::addToRender(
     const std::span<const TBindingHolder> bindings, void* customData) {
   for (const auto binding : bindings) {
     const auto pipeLayout = bindingHolder.get<2>(binding);
     const auto descriptorSet = bindingHolder.get<0>(binding);
+    const auto dynamicOffsets = bindingHolder.get<6>(binding);
 #ifdef DEBUG
     auto bitset = bindingHolder.get<3>(binding);
     auto expected = bindingHolder.get<4>(binding);
@@ -444,7 +527,7 @@ void VulkanShaderModule::addToRender(
 
     ((CommandBuffer*)customData)
         ->bindDescriptorSets(PipelineBindPoint::eGraphics, pipeLayout, 0,
-                             descriptorSet, {});
+                             descriptorSet, dynamicOffsets);
   }
 }
 
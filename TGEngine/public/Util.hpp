@@ -5,6 +5,7 @@
 #include <plog/Initializers/ConsoleInitializer.h>
 
 #include <filesystem>
+#include <span>
 #include <stdint.h>
 #include <type_traits>
 #include <vector>
@@ -32,6 +33,37 @@ public:
 
 std::vector<char> wholeFile(const fs::path &path);
 
+// Read only memory mapping of a whole file, the view stays valid for the
+// lifetime of the object
+class MappedFile {
+  const char *mappedData = nullptr;
+  size_t mappedSize = 0;
+#ifdef COMPILED_IN_WINDOWS
+  void *fileHandle = nullptr;
+  void *mappingHandle = nullptr;
+#endif
+
+  void release();
+
+public:
+  MappedFile() = default;
+  explicit MappedFile(const fs::path &path);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  ~MappedFile() { release(); }
+
+  [[nodiscard]] std::span<const char> view() const {
+    return std::span(mappedData, mappedSize);
+  }
+
+  [[nodiscard]] inline bool operator!() const { return mappedData == nullptr; }
+};
+
+// 64 bit content hash (xxHash64), used to identify equal asset data
+uint64_t hash64(const void *data, const size_t size, const uint64_t seed = 0);
+
 extern bool exitRequest;
 
 void requestExit();
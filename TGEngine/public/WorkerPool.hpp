@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace tge::util {
+
+class WorkerPool {
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool stopping = false;
+
+  void work() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock lock(mutex);
+        condition.wait(lock, [&] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) return;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+ public:
+  explicit WorkerPool(
+      const size_t threadCount =
+          std::max(std::thread::hardware_concurrency(), 2u) - 1) {
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+      workers.emplace_back([this] { work(); });
+    }
+  }
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  ~WorkerPool() {
+    {
+      std::lock_guard guard(mutex);
+      stopping = true;
+    }
+    condition.notify_all();
+    for (auto& worker : workers) worker.join();
+  }
+
+  [[nodiscard]] size_t size() const { return workers.size(); }
+
+  template <class F>
+  [[nodiscard]] std::future<std::invoke_result_t<F>> submit(F&& function) {
+    using Result = std::invoke_result_t<F>;
+    auto task = std::make_shared<std::packaged_task<Result()>>(
+        std::forward<F>(function));
+    auto future = task->get_future();
+    if (workers.empty()) {
+      (*task)();
+      return future;
+    }
+    {
+      std::lock_guard guard(mutex);
+      tasks.emplace_back([task] { (*task)(); });
+    }
+    condition.notify_one();
+    return future;
+  }
+
+  // Calls function(begin, end) on batches of at least minBatch items, the
+  // calling thread takes part and the call returns once every batch is done
+  template <class F>
+  void parallelFor(const size_t count, const size_t minBatch, F&& function) {
+    if (count == 0) return;
+    const auto batchSize = std::max<size_t>(minBatch, 1);
+    const auto batchCount = (count + batchSize - 1) / batchSize;
+    if (batchCount == 1 || workers.empty()) {
+      function((size_t)0, count);
+      return;
+    }
+    std::atomic_size_t nextBatch = 0;
+    const auto runBatches = [&] {
+      for (;;) {
+        const auto batch = nextBatch.fetch_add(1);
+        if (batch >= batchCount) return;
+        const auto begin = batch * batchSize;
+        function(begin, std::min(begin + batchSize, count));
+      }
+    };
+    const auto helperCount = std::min(batchCount - 1, workers.size());
+    std::vector<std::future<void>> helpers;
+    helpers.reserve(helperCount);
+    for (size_t i = 0; i < helperCount; i++) {
+      helpers.push_back(submit(runBatches));
+    }
+    // helpers reference this frame, so they have to finish even on failure
+    std::exception_ptr error;
+    try {
+      runBatches();
+    } catch (...) {
+      error = std::current_exception();
+      nextBatch = batchCount;
+    }
+    for (auto& helper : helpers) {
+      try {
+        helper.get();
+      } catch (...) {
+        if (!error) error = std::current_exception();
+      }
+    }
+    if (error) std::rethrow_exception(error);
+  }
+};
+
+}  // namespace tge::util
@@ -2,6 +2,7 @@
 
 #include <stdint.h>
 
+#include <array>
 #include <functional>
 #include <glm/glm.hpp>
 #include <mutex>
@@ -10,6 +11,7 @@
 #include <vector>
 
 #include "../Module.hpp"
+#include "ContentCache.hpp"
 #include "ElementHolder.hpp"
 #include "Material.hpp"
 
@@ -46,6 +48,7 @@ struct RenderInfo {
   size_t firstInstance = 0;
   std::vector<PushConstRanges> constRanges;
   std::string debugName{};
+  std::vector<TDataHolder> ownedData{};  // released together with the render
 };
 
 enum class BlitMode : uint32_t {
@@ -62,6 +65,14 @@ struct TextureInfo {
   size_t internalFormatOverride = 37;
   uint32_t mipMapOverrider = INVALID_UINT32;
   BlitMode blitMode = BlitMode::LINEAR;
+  // One and two channel textures are sampled as gray and gray alpha
+  bool grayscale = false;
+  // The alpha channel is padding and sampled as one, e.g. for BGRX formats
+  bool opaque = false;
+  // Array layers, six per cube for cubemaps. Each layer holds its whole mip
+  // chain before the next one starts
+  uint32_t layers = 1;
+  bool cubemap = false;
   std::string debugInfo{};
 };
 
@@ -100,6 +111,7 @@ enum class DataType {
   VertexData,
   VertexIndexData,
   Uniform,
+  Storage,
   All,
   Invalid
 };
@@ -122,13 +134,50 @@ struct BufferChange {
   size_t offset = 0;
 };
 
+// What device memory is spent on, render targets are the internal
+// attachments the frame is rendered into
+enum class MemoryCategory {
+  GEOMETRY,
+  UNIFORM,
+  TEXTURE,
+  RENDER_TARGET,
+  STAGING,
+  COUNT
+};
+
+struct MemoryBudget {
+  // Device local bytes of this process and how many it can use before
+  // allocations start to fail
+  size_t usage = 0;
+  size_t budget = 0;
+  // Bytes of the allocations of each category, including host memory
+  std::array<size_t, (size_t)MemoryCategory::COUNT> categoryBytes{};
+};
+
+// Gets the device local bytes that should be freed, negative bytes are the
+// headroom left once the usage is below the threshold again
+using MemoryPressureCallback = std::function<void(const int64_t bytes)>;
+
 class APILayer : public main::Module {  // Interface
  protected:
   GameGraphicsModule* graphicsModule = nullptr;
   shader::ShaderAPI* shaderAPI;
   std::mutex referenceCounterMutex;
+  std::mutex memoryPressureMutex;
+  std::vector<std::pair<size_t, MemoryPressureCallback>> memoryPressureCallbacks;
+  size_t nextMemoryPressureCallback = 0;
+
+  void notifyMemoryPressure(const int64_t bytes) {
+    std::lock_guard guard(memoryPressureMutex);
+    for (const auto& [id, callback] : memoryPressureCallbacks) callback(bytes);
+  }
 
  public:
+  // Content addressed caches shared by all load paths, only the backend's
+  // caches are used, see backend()
+  ContentCache<TDataHolder> dataCache;
+  ContentCache<TTextureHolder> textureCache;
+
   inline void setGameGraphicsModule(GameGraphicsModule* graphicsModule) {
     this->graphicsModule = graphicsModule;
   }
@@ -144,6 +193,13 @@ class APILayer : public main::Module {  // Interface
       const size_t dataCount, const BufferInfo* bufferInfo,
       const std::string& debugTag = "Unkown") = 0;
 
+  // Packs all data into one buffer, every holder refers to its own range.
+  // Offsets of bindings, vertex and index buffers and changes stay relative
+  // to the range, the buffer is freed once all holders are removed
+  [[nodiscard]] virtual std::vector<TDataHolder> pushPackedData(
+      const size_t dataCount, const BufferInfo* bufferInfo,
+      const std::string& debugTag = "Unknown") = 0;
+
   virtual void changeData(const size_t sizes,
                           const BufferChange* changeInfos) = 0;
 
@@ -160,6 +216,12 @@ class APILayer : public main::Module {  // Interface
     return pushData(bufferInfo.size(), bufferInfo.data(), debugInfo);
   }
 
+  [[nodiscard]] std::vector<TDataHolder> pushPackedData(
+      const std::span<const BufferInfo> bufferInfo,
+      const std::string& debugInfo = "Unknown") {
+    return pushPackedData(bufferInfo.size(), bufferInfo.data(), debugInfo);
+  }
+
   void changeData(const std::span<const BufferChange> changeInfos) {
     changeData(changeInfos.size(), changeInfos.data());
   }
@@ -218,6 +280,11 @@ class APILayer : public main::Module {  // Interface
 
   [[nodiscard]] virtual size_t getAligned(const DataType type) const = 0;
 
+  // Whether textures of this format can be sampled and uploaded, with blit
+  // also whether mip maps can be generated from it
+  [[nodiscard]] virtual bool isTextureFormatSupported(
+      const size_t format, const bool blit = true) const = 0;
+
   [[nodiscard]] GameGraphicsModule* getGraphicsModule() const {
     return graphicsModule;
   };
@@ -232,6 +299,58 @@ class APILayer : public main::Module {  // Interface
       const TTextureHolder imageId,
       const TDataHolder cache = TDataHolder()) = 0;
 
+  // Copies the first level of the image into a persistently mapped readback
+  // ring without waiting for it. Returns an empty holder if the ring is full
+  [[nodiscard]] virtual TReadbackHolder readImageAsync(
+      const TTextureHolder imageId) = 0;
+
+  // Copies the next rendered frame into the readback ring right before it is
+  // presented. Returns an empty holder if the ring is full or the output can
+  // not be copied
+  [[nodiscard]] virtual TReadbackHolder readOutputAsync() = 0;
+
+  // Size and format of the texels, the format is the internal one of the
+  // image and stored in internalFormatOverride
+  [[nodiscard]] virtual TextureInfo getReadbackInfo(
+      const TReadbackHolder readback) = 0;
+
+  [[nodiscard]] virtual bool isReadbackReady(
+      const TReadbackHolder readback) = 0;
+
+  // Waits for the copy if needed, the texels stay in place until the
+  // readback is released. Empty for output readbacks no frame was rendered for
+  [[nodiscard]] virtual std::span<const char> getReadbackData(
+      const TReadbackHolder readback) = 0;
+
+  virtual void releaseReadback(const TReadbackHolder readback) = 0;
+
+  // Usage and budget of the device local heaps together
+  [[nodiscard]] virtual MemoryBudget getMemoryBudget() = 0;
+
+  // Frames the CPU may record ahead of the GPU, resources replaced in a tick
+  // can still be used by the frames of this many ticks
+  [[nodiscard]] virtual size_t getFramesInFlight() const = 0;
+
+  // Waits until no frame in flight executes, no new frame is submitted while
+  // the lock is held. Descriptor sets the frames use can be written meanwhile
+  [[nodiscard]] virtual std::unique_lock<std::mutex> lockFrames() = 0;
+
+  // Called from the render thread once the device local usage gets close to
+  // the budget, so streaming systems can evict before allocations fail. Only
+  // the backend calls them, see backend()
+  size_t addMemoryPressureCallback(MemoryPressureCallback&& callback) {
+    std::lock_guard guard(memoryPressureMutex);
+    const auto id = nextMemoryPressureCallback++;
+    memoryPressureCallbacks.emplace_back(id, std::move(callback));
+    return id;
+  }
+
+  void removeMemoryPressureCallback(const size_t id) {
+    std::lock_guard guard(memoryPressureMutex);
+    std::erase_if(memoryPressureCallbacks,
+                  [&](const auto& entry) { return entry.first == id; });
+  }
+
   [[nodiscard]] virtual APILayer* backend() { return this; }
 
   virtual void initDebugGUI() = 0;
@@ -0,0 +1,137 @@
+#pragma once
+
+#define GLM_ENABLE_EXPERIMENTAL 1
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../DataHolder.hpp"
+#include "../WorkerPool.hpp"
+#include "ElementHolder.hpp"
+
+namespace tge::graphics {
+
+DEFINE_HOLDER(Node);
+DEFINE_HOLDER(Animation);
+
+struct NodeTransform {
+  glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.0f);
+  glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f);
+  glm::quat rotation = glm::quat(0.0f, 0.0f, 0.0f, 0.0f);
+};
+
+enum class AnimationPath : uint8_t { TRANSLATION, ROTATION, SCALE };
+
+// Keyframes of every channel of a clip, the keys of a channel are a
+// contiguous range in times and values. Values are vec4 so a key is read
+// with a single load, only rotations use w
+struct AnimationClip {
+  struct Channel {
+    uint32_t target;
+    AnimationPath path;
+    bool step;
+    uint32_t firstKey;
+    uint32_t keyCount;
+  };
+
+  std::string name;
+  float duration = 0.0f;
+  std::vector<Channel> channels;
+  std::vector<float> times;
+  std::vector<glm::vec4> values;
+
+  void addKey(const float time, const glm::vec4& value) {
+    times.push_back(time);
+    values.push_back(value);
+  }
+};
+
+// Value of the channel at the time, rotations are interpolated along the
+// shorter arc and not normalized
+[[nodiscard]] glm::vec4 sampleChannel(const AnimationClip& clip,
+                                      const AnimationClip::Channel& channel,
+                                      const float time);
+
+// Nodes the animations are written into, the mutex guards the translation
+// table and both columns. Statuses are set to 1 for every written transform
+struct AnimationNodes {
+  std::mutex& mutex;
+  const std::unordered_map<size_t, size_t>& translationTable;
+  std::vector<NodeTransform>& transforms;
+  std::vector<char>& statuses;
+};
+
+struct AnimationInfo {
+  std::shared_ptr<const AnimationClip> clip;
+  // Indexed by the channel targets of the clip
+  std::vector<TNodeHolder> targets;
+  float time = 0.0f;
+  float speed = 1.0f;
+  float weight = 1.0f;
+  bool loop = true;
+};
+
+// Samples and blends all playing clips and writes the resulting transforms
+// into the nodes
+class AnimationSystem {
+  struct PlayState {
+    float time;
+    float speed;
+    float weight;
+    bool loop;
+  };
+
+  struct Contribution {
+    size_t player;
+    uint32_t channel;
+  };
+
+  struct AnimatedNode {
+    TNodeHolder node;
+    NodeTransform rest;
+    size_t firstContribution;
+    size_t contributionCount;
+  };
+
+  DataHolder<std::shared_ptr<const AnimationClip>, std::vector<TNodeHolder>,
+             PlayState>
+      players;
+  std::vector<AnimatedNode> animatedNodes;
+  std::vector<Contribution> contributions;
+  std::unordered_map<TNodeHolder, NodeTransform> restPoses;
+  bool dirty = false;
+
+  void rebuild(const AnimationNodes& nodes);
+
+ public:
+  [[nodiscard]] std::vector<TAnimationHolder> play(
+      const std::span<const AnimationInfo> infos);
+
+  void stop(const std::span<const TAnimationHolder> animations);
+
+  void setWeight(const TAnimationHolder animation, const float weight) {
+    players.change<2>(animation).data.weight = weight;
+  }
+
+  void setSpeed(const TAnimationHolder animation, const float speed) {
+    players.change<2>(animation).data.speed = speed;
+  }
+
+  void setTime(const TAnimationHolder animation, const float time) {
+    players.change<2>(animation).data.time = time;
+  }
+
+  [[nodiscard]] float getTime(const TAnimationHolder animation) {
+    return players.get<2>(animation).time;
+  }
+
+  void update(const double delta, const AnimationNodes& nodes,
+              util::WorkerPool& pool);
+};
+
+}  // namespace tge::graphics
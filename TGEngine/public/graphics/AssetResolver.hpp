@@ -0,0 +1,240 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../WorkerPool.hpp"
+
+namespace tge::graphics {
+
+using ResolverFunction = std::function<std::vector<char>(const std::string&)>;
+
+struct ResolverStatistics {
+  std::string name;
+  size_t requests = 0;
+  size_t hits = 0;
+  size_t bytes = 0;
+  double seconds = 0.0;
+};
+
+struct AssetCacheStatistics {
+  size_t hits = 0;
+  size_t misses = 0;
+  size_t bytes = 0;
+  size_t entries = 0;
+};
+
+// Chain of resolvers queried in order, the first non empty result wins.
+// Results are kept in a size capped LRU and resolves of the same name that
+// are in flight are only executed once. Resolvers are called from worker
+// threads and have to be thread safe
+class AssetResolver {
+ public:
+  using Blob = std::shared_ptr<const std::vector<char>>;
+
+ private:
+  struct Resolver {
+    ResolverFunction function;
+    ResolverStatistics statistics;
+  };
+
+  struct Pending {
+    std::atomic_bool claimed = false;
+    std::promise<Blob> promise;
+    std::shared_future<Blob> future = promise.get_future().share();
+  };
+
+  using LRUList = std::list<std::pair<std::string, Blob>>;
+
+  util::WorkerPool& pool;
+  std::mutex mutex;
+  std::vector<Resolver> resolvers;
+  std::unordered_map<std::string, std::shared_ptr<Pending>> pending;
+  LRUList lru;
+  std::unordered_map<std::string, LRUList::iterator> lruLookup;
+  size_t cacheCapacity;
+  AssetCacheStatistics cacheStatistics;
+
+  void insertCache(const std::string& name, const Blob& blob) {
+    if (!blob || blob->size() > cacheCapacity) return;
+    if (lruLookup.contains(name)) return;
+    lru.emplace_front(name, blob);
+    lruLookup[name] = lru.begin();
+    cacheStatistics.bytes += blob->size();
+    evict(cacheCapacity);
+  }
+
+  void evict(const size_t capacity) {
+    while (cacheStatistics.bytes > capacity && !lru.empty()) {
+      cacheStatistics.bytes -= lru.back().second->size();
+      lruLookup.erase(lru.back().first);
+      lru.pop_back();
+    }
+    cacheStatistics.entries = lru.size();
+  }
+
+  Blob runResolvers(const std::string& name) {
+    std::vector<ResolverFunction> functions;
+    {
+      std::lock_guard guard(mutex);
+      functions.reserve(resolvers.size());
+      for (const auto& resolver : resolvers)
+        functions.push_back(resolver.function);
+    }
+    for (size_t i = 0; i < functions.size(); i++) {
+      const auto start = std::chrono::steady_clock::now();
+      auto data = functions[i](name);
+      const std::chrono::duration<double> time =
+          std::chrono::steady_clock::now() - start;
+      std::lock_guard guard(mutex);
+      auto& statistics = resolvers[i].statistics;
+      statistics.requests++;
+      statistics.seconds += time.count();
+      if (data.empty()) continue;
+      statistics.hits++;
+      statistics.bytes += data.size();
+      return std::make_shared<const std::vector<char>>(std::move(data));
+    }
+    return nullptr;
+  }
+
+  // Whoever claims a pending resolve runs it, everyone else waits on a
+  // resolve that is already running, so waiting on workers can't deadlock
+  void run(const std::string& name, Pending& job) {
+    if (job.claimed.exchange(true)) return;
+    Blob blob;
+    try {
+      blob = runResolvers(name);
+    } catch (...) {
+      std::lock_guard guard(mutex);
+      pending.erase(name);
+      job.promise.set_exception(std::current_exception());
+      return;
+    }
+    std::lock_guard guard(mutex);
+    insertCache(name, blob);
+    pending.erase(name);
+    job.promise.set_value(blob);
+  }
+
+  // Returns a ready future on a cache hit, otherwise the job to run
+  std::pair<std::shared_future<Blob>, std::shared_ptr<Pending>> lookup(
+      const std::string& name, bool& created) {
+    std::lock_guard guard(mutex);
+    created = false;
+    const auto cached = lruLookup.find(name);
+    if (cached != std::end(lruLookup)) {
+      cacheStatistics.hits++;
+      lru.splice(lru.begin(), lru, cached->second);
+      std::promise<Blob> ready;
+      ready.set_value(cached->second->second);
+      return {ready.get_future().share(), nullptr};
+    }
+    cacheStatistics.misses++;
+    auto& job = pending[name];
+    if (!job) {
+      job = std::make_shared<Pending>();
+      created = true;
+    }
+    return {job->future, job};
+  }
+
+ public:
+  explicit AssetResolver(util::WorkerPool& pool,
+                         const size_t cacheCapacity = 256 * 1024 * 1024)
+      : pool(pool), cacheCapacity(cacheCapacity) {}
+
+  AssetResolver(const AssetResolver&) = delete;
+  AssetResolver& operator=(const AssetResolver&) = delete;
+
+  // Queued jobs reference this, so they are cancelled or waited for
+  ~AssetResolver() {
+    std::vector<std::pair<std::string, std::shared_ptr<Pending>>> jobs;
+    {
+      std::lock_guard guard(mutex);
+      jobs.assign(pending.begin(), pending.end());
+    }
+    for (auto& [name, job] : jobs) {
+      if (job->claimed.exchange(true)) {
+        job->future.wait();
+        continue;
+      }
+      std::lock_guard guard(mutex);
+      pending.erase(name);
+      job->promise.set_value(nullptr);
+    }
+  }
+
+  void add(ResolverFunction&& function, const std::string& name = "") {
+    std::lock_guard guard(mutex);
+    resolvers.push_back({std::move(function), {name}});
+  }
+
+  [[nodiscard]] Blob resolve(const std::string& name) {
+    bool created;
+    auto [future, job] = lookup(name, created);
+    if (job) run(name, *job);
+    return future.get();
+  }
+
+  [[nodiscard]] std::shared_future<Blob> resolveAsync(const std::string& name) {
+    bool created;
+    auto [future, job] = lookup(name, created);
+    if (created) {
+      (void)pool.submit([this, name, job = job] {
+        if (!job->claimed.load()) run(name, *job);
+      });
+    }
+    return future;
+  }
+
+  // Resolves all names in parallel, the results are in the order of names
+  [[nodiscard]] std::vector<Blob> resolve(
+      const std::span<const std::string> names) {
+    std::vector<Blob> blobs(names.size());
+    pool.parallelFor(names.size(), 1, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) blobs[i] = resolve(names[i]);
+    });
+    return blobs;
+  }
+
+  // Starts resolving names in the background so later resolves hit the cache
+  void prefetch(const std::span<const std::string> names) {
+    for (const auto& name : names) (void)resolveAsync(name);
+  }
+
+  void setCacheCapacity(const size_t capacity) {
+    std::lock_guard guard(mutex);
+    cacheCapacity = capacity;
+    evict(capacity);
+  }
+
+  void clearCache() {
+    std::lock_guard guard(mutex);
+    evict(0);
+  }
+
+  [[nodiscard]] std::vector<ResolverStatistics> statistics() {
+    std::lock_guard guard(mutex);
+    std::vector<ResolverStatistics> out;
+    out.reserve(resolvers.size());
+    for (const auto& resolver : resolvers) out.push_back(resolver.statistics);
+    return out;
+  }
+
+  [[nodiscard]] AssetCacheStatistics cacheStats() {
+    std::lock_guard guard(mutex);
+    return cacheStatistics;
+  }
+};
+
+}  // namespace tge::graphics
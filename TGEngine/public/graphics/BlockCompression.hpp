@@ -0,0 +1,574 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "../WorkerPool.hpp"
+#include "../headerlibs/ddspp.h"
+#include "MipGeneration.hpp"
+
+namespace tge::graphics {
+
+enum class BlockFormat : uint8_t { NONE, BC1, BC3, BC5, BC7 };
+
+// Bytes of one 4x4 block
+constexpr size_t blockSize(const BlockFormat format) {
+  switch (format) {
+    case BlockFormat::BC1:
+      return 8;
+    case BlockFormat::BC3:
+    case BlockFormat::BC5:
+    case BlockFormat::BC7:
+      return 16;
+    default:
+      return 0;
+  }
+}
+
+// The VkFormat of the unorm variant
+constexpr size_t blockVulkanFormat(const BlockFormat format) {
+  switch (format) {
+    case BlockFormat::BC1:
+      return 133;
+    case BlockFormat::BC3:
+      return 137;
+    case BlockFormat::BC5:
+      return 141;
+    case BlockFormat::BC7:
+      return 145;
+    default:
+      return 0;
+  }
+}
+
+constexpr ddspp::DXGIFormat blockDXGIFormat(const BlockFormat format) {
+  switch (format) {
+    case BlockFormat::BC1:
+      return ddspp::BC1_UNORM;
+    case BlockFormat::BC3:
+      return ddspp::BC3_UNORM;
+    case BlockFormat::BC5:
+      return ddspp::BC5_UNORM;
+    case BlockFormat::BC7:
+      return ddspp::BC7_UNORM;
+    default:
+      return ddspp::UNKNOWN;
+  }
+}
+
+// Mip levels are stored back to back, each padded to whole blocks
+struct CompressedTexture {
+  std::vector<uint8_t> data;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t mipLevels = 0;
+  BlockFormat format = BlockFormat::NONE;
+};
+
+namespace bc {
+
+using Vec4 = std::array<float, 4>;
+using Block = std::array<Vec4, 16>;
+
+constexpr std::array<uint8_t, 16> BC7_WEIGHTS = {
+    0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+inline float distance(const Vec4& a, const Vec4& b, const size_t channels) {
+  float sum = 0.0f;
+  for (size_t c = 0; c < channels; c++) {
+    const auto difference = a[c] - b[c];
+    sum += difference * difference;
+  }
+  return sum;
+}
+
+// Endpoints at the extremes of the projection on the principal axis
+inline std::pair<Vec4, Vec4> principalEndpoints(const Block& block,
+                                                const size_t channels) {
+  Vec4 mean = {};
+  for (const auto& pixel : block)
+    for (size_t c = 0; c < channels; c++) mean[c] += pixel[c] / 16.0f;
+  float covariance[4][4] = {};
+  for (const auto& pixel : block)
+    for (size_t a = 0; a < channels; a++)
+      for (size_t b = 0; b < channels; b++)
+        covariance[a][b] += (pixel[a] - mean[a]) * (pixel[b] - mean[b]);
+
+  Vec4 axis = {1.0f, 1.0f, 1.0f, 1.0f};
+  for (int iteration = 0; iteration < 8; iteration++) {
+    Vec4 next = {};
+    float length = 0.0f;
+    for (size_t a = 0; a < channels; a++) {
+      for (size_t b = 0; b < channels; b++) next[a] += covariance[a][b] * axis[b];
+      length = std::max(length, std::abs(next[a]));
+    }
+    if (length <= 1e-6f) break;
+    for (size_t c = 0; c < channels; c++) axis[c] = next[c] / length;
+  }
+
+  float minimum = 0.0f, maximum = 0.0f;
+  for (const auto& pixel : block) {
+    float projection = 0.0f;
+    for (size_t c = 0; c < channels; c++)
+      projection += (pixel[c] - mean[c]) * axis[c];
+    minimum = std::min(minimum, projection);
+    maximum = std::max(maximum, projection);
+  }
+  float axisLength = 0.0f;
+  for (size_t c = 0; c < channels; c++) axisLength += axis[c] * axis[c];
+  if (axisLength > 0.0f) {
+    minimum /= axisLength;
+    maximum /= axisLength;
+  }
+  Vec4 low = {}, high = {};
+  for (size_t c = 0; c < channels; c++) {
+    low[c] = std::clamp(mean[c] + axis[c] * minimum, 0.0f, 255.0f);
+    high[c] = std::clamp(mean[c] + axis[c] * maximum, 0.0f, 255.0f);
+  }
+  return {low, high};
+}
+
+// Least squares endpoints for fixed interpolation weights, false if the
+// system is singular
+inline bool refineEndpoints(const Block& block, const std::array<float, 16>& t,
+                            const size_t channels, Vec4& low, Vec4& high) {
+  float a = 0.0f, b = 0.0f, c = 0.0f;
+  Vec4 x = {}, y = {};
+  for (size_t i = 0; i < 16; i++) {
+    const auto w = t[i];
+    a += (1.0f - w) * (1.0f - w);
+    b += (1.0f - w) * w;
+    c += w * w;
+    for (size_t k = 0; k < channels; k++) {
+      x[k] += (1.0f - w) * block[i][k];
+      y[k] += w * block[i][k];
+    }
+  }
+  const auto determinant = a * c - b * b;
+  if (std::abs(determinant) < 1e-6f) return false;
+  for (size_t k = 0; k < channels; k++) {
+    low[k] = std::clamp((c * x[k] - b * y[k]) / determinant, 0.0f, 255.0f);
+    high[k] = std::clamp((a * y[k] - b * x[k]) / determinant, 0.0f, 255.0f);
+  }
+  return true;
+}
+
+struct BC1Result {
+  uint16_t color0, color1;
+  uint32_t indices;
+  float error;
+  // Interpolation weight of the high endpoint per pixel
+  std::array<float, 16> weights;
+};
+
+inline Vec4 expand565(const uint16_t color) {
+  const auto r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+  return {(float)((r << 3) | (r >> 2)), (float)((g << 2) | (g >> 4)),
+          (float)((b << 3) | (b >> 2)), 255.0f};
+}
+
+inline uint16_t quantize565(const Vec4& color) {
+  const auto r = (uint16_t)std::lround(color[0] * 31.0f / 255.0f);
+  const auto g = (uint16_t)std::lround(color[1] * 63.0f / 255.0f);
+  const auto b = (uint16_t)std::lround(color[2] * 31.0f / 255.0f);
+  return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+inline BC1Result evaluateBC1(const Block& block, const Vec4& low,
+                             const Vec4& high) {
+  BC1Result result{quantize565(high), quantize565(low), 0, 0.0f, {}};
+  const bool swapped = result.color0 < result.color1;
+  if (swapped) std::swap(result.color0, result.color1);
+  const auto c0 = expand565(result.color0), c1 = expand565(result.color1);
+  std::array<Vec4, 4> palette = {c0, c1};
+  for (size_t c = 0; c < 3; c++) {
+    palette[2][c] = std::floor((2.0f * c0[c] + c1[c]) / 3.0f);
+    palette[3][c] = std::floor((c0[c] + 2.0f * c1[c]) / 3.0f);
+  }
+  constexpr std::array<float, 4> weights = {1.0f, 0.0f, 2.0f / 3.0f,
+                                            1.0f / 3.0f};
+  const auto entries = result.color0 == result.color1 ? 1 : 4;
+  for (size_t i = 0; i < 16; i++) {
+    uint32_t best = 0;
+    float bestError = distance(block[i], palette[0], 3);
+    for (int entry = 1; entry < entries; entry++) {
+      const auto error = distance(block[i], palette[entry], 3);
+      if (error < bestError) {
+        bestError = error;
+        best = entry;
+      }
+    }
+    result.indices |= best << (i * 2);
+    result.error += bestError;
+    result.weights[i] = swapped ? 1.0f - weights[best] : weights[best];
+  }
+  return result;
+}
+
+inline BC1Result fitBC1(const Block& block, const uint32_t refinements) {
+  auto [low, high] = principalEndpoints(block, 3);
+  auto best = evaluateBC1(block, low, high);
+  for (uint32_t i = 0; i < refinements && best.error > 0.0f; i++) {
+    if (!refineEndpoints(block, best.weights, 3, low, high)) break;
+    const auto candidate = evaluateBC1(block, low, high);
+    if (candidate.error >= best.error) break;
+    best = candidate;
+  }
+  return best;
+}
+
+inline void writeBC1(const BC1Result& result, uint8_t* out) {
+  std::memcpy(out, &result.color0, 2);
+  std::memcpy(out + 2, &result.color1, 2);
+  std::memcpy(out + 4, &result.indices, 4);
+}
+
+// Eight value mode between the minimum and maximum of the channel
+inline void encodeBC4(const Block& block, const size_t channel, uint8_t* out) {
+  float minimum = 255.0f, maximum = 0.0f;
+  for (const auto& pixel : block) {
+    minimum = std::min(minimum, pixel[channel]);
+    maximum = std::max(maximum, pixel[channel]);
+  }
+  const auto high = (uint8_t)std::lround(maximum);
+  const auto low = (uint8_t)std::lround(minimum);
+  out[0] = high;
+  out[1] = low;
+  uint64_t indices = 0;
+  if (high != low) {
+    const float range = (float)(high - low);
+    for (size_t i = 0; i < 16; i++) {
+      const auto position =
+          (uint64_t)std::lround((high - block[i][channel]) * 7.0f / range);
+      const auto index = position == 0 ? 0 : position == 7 ? 1 : position + 1;
+      indices |= index << (i * 3);
+    }
+  }
+  for (size_t i = 0; i < 6; i++) out[2 + i] = (uint8_t)(indices >> (i * 8));
+}
+
+inline void encodeBC1(const Block& block, uint8_t* out,
+                      const uint32_t refinements) {
+  writeBC1(fitBC1(block, refinements), out);
+}
+
+inline void encodeBC3(const Block& block, uint8_t* out,
+                      const uint32_t refinements) {
+  encodeBC4(block, 3, out);
+  writeBC1(fitBC1(block, refinements), out + 8);
+}
+
+inline void encodeBC5(const Block& block, uint8_t* out) {
+  encodeBC4(block, 0, out);
+  encodeBC4(block, 1, out + 8);
+}
+
+struct BC7Result {
+  std::array<uint8_t, 4> endpoint0, endpoint1;
+  uint8_t pbit0, pbit1;
+  std::array<uint8_t, 16> indices;
+  float error;
+};
+
+// Seven bit endpoint and the shared p bit that reproduce a color best
+inline void quantizeBC7(const Vec4& color, std::array<uint8_t, 4>& endpoint,
+                        uint8_t& pbit) {
+  float bestError = INFINITY;
+  for (uint8_t p = 0; p < 2; p++) {
+    std::array<uint8_t, 4> candidate;
+    float error = 0.0f;
+    for (size_t c = 0; c < 4; c++) {
+      candidate[c] =
+          (uint8_t)std::clamp(std::lround((color[c] - p) / 2.0f), 0l, 127l);
+      const auto difference = (float)((candidate[c] << 1) | p) - color[c];
+      error += difference * difference;
+    }
+    if (error < bestError) {
+      bestError = error;
+      endpoint = candidate;
+      pbit = p;
+    }
+  }
+}
+
+inline BC7Result evaluateBC7(const Block& block, const Vec4& low,
+                             const Vec4& high) {
+  BC7Result result{};
+  quantizeBC7(low, result.endpoint0, result.pbit0);
+  quantizeBC7(high, result.endpoint1, result.pbit1);
+  std::array<Vec4, 16> palette;
+  for (size_t i = 0; i < 16; i++) {
+    const auto weight = BC7_WEIGHTS[i];
+    for (size_t c = 0; c < 4; c++) {
+      const auto e0 = (result.endpoint0[c] << 1) | result.pbit0;
+      const auto e1 = (result.endpoint1[c] << 1) | result.pbit1;
+      palette[i][c] = (float)(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+    }
+  }
+  for (size_t i = 0; i < 16; i++) {
+    uint8_t best = 0;
+    float bestError = distance(block[i], palette[0], 4);
+    for (uint8_t entry = 1; entry < 16; entry++) {
+      const auto error = distance(block[i], palette[entry], 4);
+      if (error < bestError) {
+        bestError = error;
+        best = entry;
+      }
+    }
+    result.indices[i] = best;
+    result.error += bestError;
+  }
+  return result;
+}
+
+// Mode 6, a single subset with 7 bit RGBA endpoints and 4 bit indices
+inline void encodeBC7(const Block& block, uint8_t* out,
+                      const uint32_t refinements) {
+  auto [low, high] = principalEndpoints(block, 4);
+  auto best = evaluateBC7(block, low, high);
+  for (uint32_t i = 0; i < refinements && best.error > 0.0f; i++) {
+    std::array<float, 16> weights;
+    for (size_t p = 0; p < 16; p++)
+      weights[p] = BC7_WEIGHTS[best.indices[p]] / 64.0f;
+    if (!refineEndpoints(block, weights, 4, low, high)) break;
+    const auto candidate = evaluateBC7(block, low, high);
+    if (candidate.error >= best.error) break;
+    best = candidate;
+  }
+  // The anchor index is stored without its top bit
+  if (best.indices[0] >= 8) {
+    std::swap(best.endpoint0, best.endpoint1);
+    std::swap(best.pbit0, best.pbit1);
+    for (auto& index : best.indices) index = (uint8_t)(15 - index);
+  }
+
+  std::memset(out, 0, 16);
+  size_t bit = 0;
+  const auto write = [&](uint32_t value, const size_t bits) {
+    for (size_t i = 0; i < bits; i++, bit++, value >>= 1)
+      out[bit / 8] |= (uint8_t)((value & 1) << (bit % 8));
+  };
+  write(1 << 6, 7);
+  for (size_t c = 0; c < 4; c++) {
+    write(best.endpoint0[c], 7);
+    write(best.endpoint1[c], 7);
+  }
+  write(best.pbit0, 1);
+  write(best.pbit1, 1);
+  write(best.indices[0], 3);
+  for (size_t i = 1; i < 16; i++) write(best.indices[i], 4);
+}
+
+inline void decodeBC1(const uint8_t* in, uint8_t* out, const bool alwaysFour) {
+  uint16_t color0, color1;
+  uint32_t indices;
+  std::memcpy(&color0, in, 2);
+  std::memcpy(&color1, in + 2, 2);
+  std::memcpy(&indices, in + 4, 4);
+  const auto c0 = expand565(color0), c1 = expand565(color1);
+  std::array<Vec4, 4> palette = {c0, c1};
+  const bool four = alwaysFour || color0 > color1;
+  for (size_t c = 0; c < 3; c++) {
+    palette[2][c] = four ? std::floor((2.0f * c0[c] + c1[c]) / 3.0f)
+                         : std::floor((c0[c] + c1[c]) / 2.0f);
+    palette[3][c] = four ? std::floor((c0[c] + 2.0f * c1[c]) / 3.0f) : 0.0f;
+  }
+  palette[2][3] = 255.0f;
+  palette[3][3] = four ? 255.0f : 0.0f;
+  for (size_t i = 0; i < 16; i++) {
+    const auto& color = palette[(indices >> (i * 2)) & 3];
+    for (size_t c = 0; c < 4; c++) out[i * 4 + c] = (uint8_t)color[c];
+  }
+}
+
+inline void decodeBC4(const uint8_t* in, uint8_t* out, const size_t channel) {
+  std::array<uint32_t, 8> palette = {in[0], in[1]};
+  for (uint32_t i = 2; i < 8; i++) {
+    palette[i] = in[0] > in[1]
+                     ? ((8 - i) * in[0] + (i - 1) * in[1]) / 7
+                     : i < 6 ? ((6 - i) * in[0] + (i - 1) * in[1]) / 5
+                             : (i == 6 ? 0 : 255);
+  }
+  uint64_t indices = 0;
+  for (size_t i = 0; i < 6; i++) indices |= (uint64_t)in[2 + i] << (i * 8);
+  for (size_t i = 0; i < 16; i++)
+    out[i * 4 + channel] = (uint8_t)palette[(indices >> (i * 3)) & 7];
+}
+
+}  // namespace bc
+
+// Decodes a block into 4x4 RGBA8 texels, BC7 blocks have to be mode 6 which
+// is the only mode the encoder writes
+inline bool decodeBlock(const BlockFormat format, const uint8_t* in,
+                        uint8_t* out) {
+  switch (format) {
+    case BlockFormat::BC1:
+      bc::decodeBC1(in, out, false);
+      return true;
+    case BlockFormat::BC3:
+      bc::decodeBC1(in + 8, out, true);
+      bc::decodeBC4(in, out, 3);
+      return true;
+    case BlockFormat::BC5:
+      bc::decodeBC4(in, out, 0);
+      bc::decodeBC4(in + 8, out, 1);
+      for (size_t i = 0; i < 16; i++) {
+        out[i * 4 + 2] = 0;
+        out[i * 4 + 3] = 255;
+      }
+      return true;
+    case BlockFormat::BC7: {
+      if ((in[0] & 0x7F) != (1 << 6)) return false;
+      size_t bit = 7;
+      const auto read = [&](const size_t bits) {
+        uint32_t value = 0;
+        for (size_t i = 0; i < bits; i++, bit++)
+          value |= ((in[bit / 8] >> (bit % 8)) & 1u) << i;
+        return value;
+      };
+      std::array<uint32_t, 4> e0, e1;
+      for (size_t c = 0; c < 4; c++) {
+        e0[c] = read(7) << 1;
+        e1[c] = read(7) << 1;
+      }
+      const auto p0 = read(1), p1 = read(1);
+      for (size_t i = 0; i < 16; i++) {
+        const auto weight = bc::BC7_WEIGHTS[read(i == 0 ? 3 : 4)];
+        for (size_t c = 0; c < 4; c++) {
+          out[i * 4 + c] = (uint8_t)(((64 - weight) * (e0[c] | p0) +
+                                      weight * (e1[c] | p1) + 32) >>
+                                     6);
+        }
+      }
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+// Compresses a RGBA8 image and its mip chain, pass a pool to encode the
+// blocks in parallel. Refinements trade speed for endpoint quality, normal
+// maps should turn gamma correction of the mips off
+inline CompressedTexture compressTexture(
+    const uint8_t* rgba, const uint32_t width, const uint32_t height,
+    const BlockFormat format, const MipSettings& mips = {},
+    const uint32_t refinements = 1, util::WorkerPool* pool = nullptr) {
+  CompressedTexture texture;
+  texture.width = width;
+  texture.height = height;
+  texture.format = format;
+  const auto bytes = blockSize(format);
+  if (bytes == 0 || rgba == nullptr || width == 0 || height == 0)
+    return texture;
+  const auto chain = generateMipChain(rgba, width, height, 4, mips);
+  texture.mipLevels = (uint32_t)chain.offsets.size();
+
+  struct Level {
+    const uint8_t* rgba;
+    uint32_t width, height, blocksX, firstBlock;
+  };
+  std::vector<Level> levels;
+  levels.reserve(texture.mipLevels);
+  uint32_t blockCount = 0;
+  for (uint32_t level = 0; level < texture.mipLevels; level++) {
+    const auto levelWidth = std::max(width >> level, 1u);
+    const auto levelHeight = std::max(height >> level, 1u);
+    const auto data = chain.data.data() + chain.offsets[level];
+    const auto blocksX = (levelWidth + 3) / 4;
+    const auto blocksY = (levelHeight + 3) / 4;
+    levels.push_back({data, levelWidth, levelHeight, blocksX, blockCount});
+    blockCount += blocksX * blocksY;
+  }
+  texture.data.resize((size_t)blockCount * bytes);
+
+  const auto encode = [&](const size_t begin, const size_t end) {
+    auto level = std::upper_bound(levels.begin(), levels.end(), begin,
+                                  [](const size_t block, const Level& level) {
+                                    return block < level.firstBlock;
+                                  }) -
+                 1;
+    bc::Block block;
+    for (size_t index = begin; index < end; index++) {
+      if (level + 1 != levels.end() && index >= (level + 1)->firstBlock)
+        level++;
+      const auto local = index - level->firstBlock;
+      const auto blockX = (uint32_t)(local % level->blocksX) * 4;
+      const auto blockY = (uint32_t)(local / level->blocksX) * 4;
+      for (uint32_t y = 0; y < 4; y++) {
+        const auto row = std::min(blockY + y, level->height - 1);
+        for (uint32_t x = 0; x < 4; x++) {
+          const auto column = std::min(blockX + x, level->width - 1);
+          const auto texel =
+              level->rgba + ((size_t)row * level->width + column) * 4;
+          for (size_t c = 0; c < 4; c++) block[y * 4 + x][c] = texel[c];
+        }
+      }
+      const auto out = texture.data.data() + index * bytes;
+      switch (format) {
+        case BlockFormat::BC1:
+          bc::encodeBC1(block, out, refinements);
+          break;
+        case BlockFormat::BC3:
+          bc::encodeBC3(block, out, refinements);
+          break;
+        case BlockFormat::BC5:
+          bc::encodeBC5(block, out);
+          break;
+        default:
+          bc::encodeBC7(block, out, refinements);
+          break;
+      }
+    }
+  };
+  if (pool == nullptr) {
+    encode(0, blockCount);
+  } else {
+    pool->parallelFor(blockCount, 64, encode);
+  }
+  return texture;
+}
+
+// DDS file of one 2D texture whose levels are stored back to back
+inline std::vector<char> writeDDS(const ddspp::DXGIFormat format,
+                                  const uint32_t width, const uint32_t height,
+                                  const uint32_t mipLevels,
+                                  const std::span<const uint8_t> data) {
+  ddspp::Header header;
+  ddspp::HeaderDXT10 dxt10Header;
+  ddspp::encode_header(format, width, height, 1, ddspp::Texture2D, mipLevels,
+                       1, header, dxt10Header);
+  std::vector<char> file(sizeof(ddspp::internal::DDS_MAGIC) + sizeof(header) +
+                         sizeof(dxt10Header) + data.size());
+  auto out = file.data();
+  std::memcpy(out, &ddspp::internal::DDS_MAGIC,
+              sizeof(ddspp::internal::DDS_MAGIC));
+  out += sizeof(ddspp::internal::DDS_MAGIC);
+  std::memcpy(out, &header, sizeof(header));
+  out += sizeof(header);
+  std::memcpy(out, &dxt10Header, sizeof(dxt10Header));
+  out += sizeof(dxt10Header);
+  std::memcpy(out, data.data(), data.size());
+  return file;
+}
+
+// Bakes the texture so it can be loaded with DDSPP without encoding again
+inline std::vector<char> toDDS(const CompressedTexture& texture) {
+  return writeDDS(blockDXGIFormat(texture.format), texture.width,
+                  texture.height, texture.mipLevels, texture.data);
+}
+
+// Bakes a RGBA8 mip chain
+inline std::vector<char> toDDS(const MipChain& chain, const uint32_t width,
+                               const uint32_t height) {
+  return writeDDS(ddspp::R8G8B8A8_UNORM, width, height,
+                  (uint32_t)chain.offsets.size(), chain.data);
+}
+
+}  // namespace tge::graphics
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "ElementHolder.hpp"
+
+namespace tge::graphics {
+
+template <class Holder>
+class ContentCache {
+  struct CacheEntry {
+    uint64_t hash;
+    size_t references;
+  };
+
+  std::mutex mutex;
+  std::unordered_map<uint64_t, Holder> hashToHolder;
+  std::unordered_map<Holder, CacheEntry> holderToEntry;
+
+ public:
+  [[nodiscard]] Holder acquire(const uint64_t hash) {
+    std::lock_guard guard(mutex);
+    const auto found = hashToHolder.find(hash);
+    if (found == std::end(hashToHolder)) return Holder();
+    holderToEntry[found->second].references++;
+    return found->second;
+  }
+
+  void insert(const uint64_t hash, const Holder holder) {
+    std::lock_guard guard(mutex);
+    if (hashToHolder.contains(hash)) return;
+    hashToHolder[hash] = holder;
+    holderToEntry[holder] = {hash, 1};
+  }
+
+  // Returns the holders that are no longer referenced and can be freed,
+  // holders that were never added to the cache are always returned
+  [[nodiscard]] std::vector<Holder> release(
+      const std::span<const Holder> holders) {
+    std::lock_guard guard(mutex);
+    std::vector<Holder> toFree;
+    toFree.reserve(holders.size());
+    for (const auto holder : holders) {
+      const auto found = holderToEntry.find(holder);
+      if (found == std::end(holderToEntry)) {
+        toFree.push_back(holder);
+        continue;
+      }
+      auto& entry = found->second;
+      entry.references--;
+      if (entry.references == 0) {
+        hashToHolder.erase(entry.hash);
+        holderToEntry.erase(found);
+        toFree.push_back(holder);
+      }
+    }
+    std::ranges::sort(toFree, {}, &Holder::internalHandle);
+    const auto [first, last] = std::ranges::unique(toFree);
+    toFree.erase(first, last);
+    return toFree;
+  }
+
+  [[nodiscard]] size_t references(const Holder holder) {
+    std::lock_guard guard(mutex);
+    const auto found = holderToEntry.find(holder);
+    if (found == std::end(holderToEntry)) return 0;
+    return found->second.references;
+  }
+
+  [[nodiscard]] size_t size() {
+    std::lock_guard guard(mutex);
+    return hashToHolder.size();
+  }
+
+  void clear() {
+    std::lock_guard guard(mutex);
+    hashToHolder.clear();
+    holderToEntry.clear();
+  }
+};
+
+}  // namespace tge::graphics
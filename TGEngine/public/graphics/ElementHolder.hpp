@@ -35,6 +35,7 @@ DEFINE_HOLDER(Render);
 DEFINE_HOLDER(Sampler);
 DEFINE_HOLDER(Texture);
 DEFINE_HOLDER(Data);
+DEFINE_HOLDER(Readback);
 
 }  // namespace tge::graphics
 
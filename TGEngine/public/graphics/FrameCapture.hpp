@@ -0,0 +1,136 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "../Module.hpp"
+#include "../WorkerPool.hpp"
+#include "ElementHolder.hpp"
+
+namespace tge::graphics {
+
+class APILayer;
+
+enum class CaptureEncoding { PNG, RAW };
+
+struct CaptureSettings {
+  std::filesystem::path directory = "capture";
+  CaptureEncoding encoding = CaptureEncoding::PNG;
+  // Every interval-th tick is captured
+  uint32_t interval = 1;
+  // Stops capturing after this many frames, zero captures until destroyed
+  size_t maxFrames = 0;
+  // Readbacks waiting for the GPU and frames waiting for a worker, captures
+  // beyond these are dropped instead of stalling the render loop
+  size_t maxReadbacks = 3;
+  size_t maxEncodes = 8;
+  // Threads encoding the frames, zero uses all but one core
+  size_t encodeThreads = 0;
+  // Color texture to capture, the presented frame if empty
+  TTextureHolder target{};
+};
+
+// Events per second over the last window seconds
+class RateCounter {
+  std::deque<double> times;
+
+ public:
+  double window = 1.0;
+
+  void add(const double time) {
+    times.push_back(time);
+    while (times.size() > 2 && time - times.front() > window) times.pop_front();
+  }
+
+  [[nodiscard]] double rate() const {
+    if (times.size() < 2 || times.back() <= times.front()) return 0.0;
+    return (double)(times.size() - 1) / (times.back() - times.front());
+  }
+};
+
+struct CaptureStats {
+  size_t captured = 0;
+  size_t encoded = 0;
+  size_t dropped = 0;
+  size_t failed = 0;
+  double captureRate = 0.0;
+  double encodeRate = 0.0;
+};
+
+// Converts 8 bit RGBA and BGRA texels of the given Vulkan format into RGBA
+// with opaque alpha, false for every other format
+inline bool toRGBA8(const uint8_t* texels, const size_t count,
+                    const size_t format, uint8_t* output) {
+  bool swap;
+  switch (format) {
+    case 37:  // R8G8B8A8Unorm
+    case 43:  // R8G8B8A8Srgb
+      swap = false;
+      break;
+    case 44:  // B8G8R8A8Unorm
+    case 50:  // B8G8R8A8Srgb
+      swap = true;
+      break;
+    default:
+      return false;
+  }
+  for (size_t i = 0; i < count * 4; i += 4) {
+    output[i] = texels[swap ? i + 2 : i];
+    output[i + 1] = texels[i + 1];
+    output[i + 2] = texels[swap ? i : i + 2];
+    output[i + 3] = 255;
+  }
+  return true;
+}
+
+// Reads back a frame every settings.interval ticks without waiting for the
+// GPU and writes it as PNG or raw texels on worker threads, add it to the
+// lateModules so it ticks after the frame was submitted
+class FrameCaptureModule : public main::Module {
+  struct Pending {
+    TReadbackHolder readback;
+    size_t frame;
+  };
+
+  std::unique_ptr<util::WorkerPool> pool;
+  std::deque<Pending> readbacks;
+  std::deque<std::future<bool>> encodes;
+  std::chrono::steady_clock::time_point start;
+  RateCounter captureCounter;
+  RateCounter encodeCounter;
+  CaptureStats stats;
+  APILayer* api = nullptr;
+  size_t ticks = 0;
+  size_t frames = 0;
+
+  [[nodiscard]] double now() const {
+    const std::chrono::duration<double> time =
+        std::chrono::steady_clock::now() - start;
+    return time.count();
+  }
+
+  // Hands finished readbacks to the workers, waits for them when flushing
+  void collect(bool flush);
+
+ public:
+  CaptureSettings settings;
+
+  explicit FrameCaptureModule(const CaptureSettings& settings = {})
+      : settings(settings) {}
+
+  main::Error init() override;
+
+  void tick(double deltatime) override;
+
+  void destroy() override;
+
+  [[nodiscard]] CaptureStats getStats() const { return stats; }
+};
+
+}  // namespace tge::graphics
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <filesystem>
 #include <functional>
+#include <future>
 #define GLM_ENABLE_EXPERIMENTAL 1
 #include <glm/geometric.hpp>
 #include <glm/glm.hpp>
@@ -14,21 +18,19 @@
 #include "../../public/DataHolder.hpp"
 #include "../../public/Error.hpp"
 #include "../../public/Module.hpp"
+#include "../../public/WorkerPool.hpp"
 #include "APILayer.hpp"
+#include "Animation.hpp"
+#include "AssetResolver.hpp"
+#include "BlockCompression.hpp"
 #include "GameShaderModule.hpp"
 #include "Material.hpp"
+#include "TextureAtlas.hpp"
+#include "TextureStreaming.hpp"
 #include "WindowModule.hpp"
 
 namespace tge::graphics {
 
-DEFINE_HOLDER(Node);
-
-struct NodeTransform {
-  glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.0f);
-  glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f);
-  glm::quat rotation = glm::quat(0.0f, 0.0f, 0.0f, 0.0f);
-};
-
 struct NodeDebugInfo {
   std::string name;
   void* data;
@@ -36,6 +38,9 @@ struct NodeDebugInfo {
 
 struct NodeInfo {
   shader::TBindingHolder bindingID{};
+  // Without a bindingID, nodes added together with the same pipe share one
+  // descriptor set and read their values through a dynamic offset
+  shader::ShaderPipe bindingPipe = nullptr;
   NodeTransform transforms = {};
   size_t parent = INVALID_SIZE_T;
   TNodeHolder parentHolder;
@@ -46,6 +51,18 @@ struct FeatureSet {
   uint32_t wideLines = false;
   uint32_t anisotropicfiltering = INT_MAX;
   uint32_t mipMapLevels = 4;
+  // Block compresses textures loaded with STBI, falls back to uncompressed if
+  // the format is not supported
+  BlockFormat textureCompression = BlockFormat::NONE;
+  // Generates the mips of STBI textures while importing, they are uploaded
+  // with the texture instead of being blitted on the GPU
+  uint32_t cpuMipMaps = false;
+  MipFilter mipFilter = MipFilter::BOX;
+  // Decoded STBI textures are stored here and mapped on later loads of the
+  // same content and settings, disabled if empty
+  std::filesystem::path textureCacheDirectory{};
+  // Frames the CPU records ahead of the GPU, with one it waits for every frame
+  uint32_t framesInFlight = 2;
 };
 
 struct TextureLoadInternal {
@@ -55,14 +72,26 @@ struct TextureLoadInternal {
 
 enum class LoadType { STBI, DDSPP };
 
+struct AtlasTexture {
+  TTextureHolder texture;
+  // Maps the uvs of the texture into its page, uv * xy + zw. Nodes sampling
+  // it get the transform with setUVTransform
+  glm::vec4 uvTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+};
+
 struct ValueSystem {
   glm::mat4 model = glm::mat4(1.0f);
   glm::mat4 normalModel = glm::mat4(1.0f);
   glm::vec4 color = glm::vec4(0);
   size_t offset = 0;
-  char padding[104];
+  uint32_t jointOffset = 0;
+  uint32_t jointPadding = 0;
+  // Applied to the uvs by the default shader, see AtlasTexture
+  glm::vec4 uvTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+  char padding[80];
 };
 static_assert(sizeof(ValueSystem) == 256);
+static_assert(offsetof(ValueSystem, uvTransform) == 160);
 
 class GameGraphicsModule : public main::Module {
   APILayer* apiLayer;
@@ -73,8 +102,40 @@ class GameGraphicsModule : public main::Module {
   size_t nextNode = 0;
   TDataHolder projection;
   std::vector<BufferChange> bufferChange;
-  std::vector<std::function<std::vector<char>(const std::string&)>>
-      assetResolver;
+
+  struct Skin {
+    size_t firstJoint;
+    std::vector<TNodeHolder> joints;
+    std::vector<glm::mat4> inverseBindMatrices;
+  };
+
+  // All skins of a model share one joint buffer
+  struct SkinSet {
+    TDataHolder jointData;
+    std::vector<Skin> skins;
+    std::vector<glm::mat4> jointMatrices;
+    bool alive = true;
+    bool changed = false;
+  };
+
+  std::mutex protectAnimation;
+  std::vector<SkinSet> skinSets;
+  std::vector<char> updatedNodes;
+  std::unordered_map<TNodeHolder, std::vector<std::shared_ptr<const AnimationClip>>>
+      modelAnimations;
+
+  void updateSkins();
+
+  struct StreamUpload {
+    TStreamHolder stream;
+    uint32_t firstLevel;
+    std::future<TTextureHolder> texture;
+  };
+
+  std::vector<StreamUpload> streamUploads;
+  size_t memoryPressureCallback = INVALID_SIZE_T;
+
+  void updateStreaming();
 
  public:
   DataHolder<TDataHolder, NodeTransform, size_t, shader::TBindingHolder, char,
@@ -85,11 +146,21 @@ class GameGraphicsModule : public main::Module {
   std::mutex protectTexture;
   std::unordered_map<std::string, TTextureHolder> textureMap;
   TPipelineHolder defaultMaterial;
+  TPipelineHolder instancedMaterial;
+  // Skinned permutations, indexed by whether the primitive has normals (1)
+  // and texture coordinates (2)
+  std::array<TPipelineHolder, 4> skinnedMaterials;
   std::vector<char> vertexShader;
   std::vector<char> fragmentShader;
   tge::shader::ShaderPipe defaultPipe;
+  tge::shader::ShaderPipe instancedPipe;
+  std::array<tge::shader::ShaderPipe, 4> skinnedPipes;
   tge::shader::ShaderPipe glbWidget;
   FeatureSet features;
+  util::WorkerPool workerPool;
+  AnimationSystem animations;
+  AssetResolver assetResolver{workerPool};
+  TextureStreamer streamer;
 
   GameGraphicsModule(APILayer* apiLayer, WindowModule* winModule,
                      const FeatureSet& set = {});
@@ -99,23 +170,77 @@ class GameGraphicsModule : public main::Module {
     return nodeHolder.get<3>(holders);
   }
 
-  void addAssetResolver(
-      std::function<std::vector<char>(const std::string&)>&& function) {
-    assetResolver.push_back(function);
+  void addAssetResolver(ResolverFunction&& function,
+                        const std::string& name = "") {
+    assetResolver.add(std::move(function), name);
   }
 
   [[nodiscard]] std::vector<TNodeHolder> loadModel(
       const std::vector<char>& data, const bool binary,
       const std::string& baseDir = "", void* shaderPipe = nullptr);
 
+  // Buffers and images are read straight from data, which only has to stay
+  // alive for the duration of the call
+  [[nodiscard]] std::vector<TNodeHolder> loadModel(
+      const std::span<const char> data, const bool binary,
+      const std::string& baseDir = "", void* shaderPipe = nullptr);
+
+  // Maps the file and detects glb by its header
+  [[nodiscard]] std::vector<TNodeHolder> loadModel(
+      const fs::path& path, void* shaderPipe = nullptr);
+
+  // Color textures get gamma correct CPU mips, pass false for normal maps
+  // and other data that is filtered linearly
   std::vector<TTextureHolder> loadTextures(
       const std::vector<TextureLoadInternal>& data,
-      const LoadType type = LoadType::STBI);
+      const LoadType type = LoadType::STBI, const bool color = true);
 
   std::vector<TTextureHolder> loadTextures(
+      const std::vector<std::string>& names,
+      const LoadType type = LoadType::STBI, const bool color = true);
+
+  // Packs small STBI textures of the same format into shared pages, so one
+  // binding serves all of them. Packed textures can't be sampled with
+  // repeat, larger or failed ones get their own or the default texture
+  [[nodiscard]] std::vector<AtlasTexture> loadAtlas(
+      const std::vector<std::string>& names,
+      const AtlasSettings& settings = {});
+
+  // Samples an atlas texture on the node, the shader reads the transform from
+  // ValueSystem::uvTransform
+  void setUVTransform(const TNodeHolder node, const glm::vec4& uvTransform) {
+    nodeHolder.change<5>(node).data.uvTransform = uvTransform;
+    nodeHolder.change<4>(node) = 1;
+  }
+
+  // Loads the whole mip chains but uploads only their small levels, larger
+  // ones follow the screen sizes passed to requestStreamed. Arrays and
+  // cubemaps can't be streamed
+  [[nodiscard]] std::vector<TStreamHolder> loadStreamed(
       const std::vector<std::string>& names,
       const LoadType type = LoadType::STBI);
 
+  // Binds the current texture of the stream and rebinds it on every swap
+  void bindStreamed(const TStreamHolder stream,
+                    const shader::BindingInfo& binding);
+
+  void requestStreamed(const TStreamHolder stream, const float screenSize) {
+    streamer.request(stream, screenSize);
+  }
+
+  void requestStreamed(const TStreamHolder stream, const TNodeHolder node,
+                       const float radius) {
+    streamer.request(stream, projectedSize(node, radius));
+  }
+
+  void removeStreamed(const std::span<const TStreamHolder> streams) {
+    streamer.remove(streams);
+  }
+
+  // Height in pixels of a sphere around the origin of the node, radius is
+  // scaled with the node
+  [[nodiscard]] float projectedSize(const TNodeHolder node, const float radius);
+
   [[nodiscard]] std::vector<TNodeHolder> addNode(
       const NodeInfo* nodeInfos, const size_t count,
       const std::string& debugInfo = "UnknownNode");
@@ -128,6 +253,11 @@ class GameGraphicsModule : public main::Module {
 
   void removeNode(std::span<const TNodeHolder> holder,
                   const bool instand = false) {
+    {
+      // Clips of a model go with its root, the holder may be recycled
+      std::lock_guard guard(protectAnimation);
+      for (const auto node : holder) modelAnimations.erase(node);
+    }
     if (nodeHolder.erase(holder)) {
       if (instand ||
           nodeHolder.size() > 2 * nodeHolder.translationTable.size()) {
@@ -143,6 +273,20 @@ class GameGraphicsModule : public main::Module {
     { nodeHolder.change<4>(nodeID) = 1; }
   }
 
+  // Clips of a model loaded by loadModel, keyed by its root node
+  [[nodiscard]] std::vector<std::shared_ptr<const AnimationClip>> getAnimations(
+      const TNodeHolder root) {
+    std::lock_guard guard(protectAnimation);
+    const auto found = modelAnimations.find(root);
+    if (found == std::end(modelAnimations)) return {};
+    return found->second;
+  }
+
+  // Plays a clip of a model returned by loadModel on its nodes
+  [[nodiscard]] TAnimationHolder playAnimation(
+      const std::span<const TNodeHolder> model, const size_t clip,
+      const float weight = 1.0f, const bool loop = true);
+
   void updateViewMatrix(const glm::mat4 matrix) {
     this->projectionMatrix = matrix;
   }
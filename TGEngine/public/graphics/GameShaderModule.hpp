@@ -120,6 +120,16 @@ class ShaderAPI {
                                    const size_t bindingID,
                                    const size_t buffer) = 0;
 
+  // Bindings sharing the descriptor set of bindingSet, data bound to one of
+  // them is seen by all. Each keeps its own dynamic uniform buffer offsets
+  [[nodiscard]] virtual std::vector<TBindingHolder> shareBindings(
+      const TBindingHolder bindingSet, const size_t count) = 0;
+
+  // Uniform buffers are bound dynamically, the offset is added to the bound
+  // range of binding whenever the set is added to a render
+  virtual void setDynamicOffset(const TBindingHolder bindingSet,
+                                const size_t binding, const uint32_t offset) = 0;
+
   virtual void bindData(const BindingInfo* info, const size_t count) = 0;
 
   virtual void bindData(const std::span<const BindingInfo> infos) {
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TGE_MIP_SSE 1
+#endif
+
+namespace tge::graphics {
+
+enum class MipFilter : uint8_t { BOX, KAISER };
+
+struct MipSettings {
+  uint32_t levels = UINT32_MAX;
+  MipFilter filter = MipFilter::BOX;
+  // Color channels are sRGB encoded and filtered in linear space
+  bool gammaCorrect = true;
+};
+
+constexpr uint32_t fullMipChain(const uint32_t width, const uint32_t height) {
+  uint32_t levels = 1;
+  for (auto size = std::max(width, height); size > 1; size >>= 1) levels++;
+  return levels;
+}
+
+// All levels back to back, level i is max(width >> i, 1) wide
+struct MipChain {
+  std::vector<uint8_t> data;
+  std::vector<size_t> offsets;
+};
+
+namespace mip {
+
+struct alignas(16) Texel {
+  float value[4];
+};
+
+// The filters keep their sums in registers and only store finished texels
+#ifdef TGE_MIP_SSE
+using Lanes = __m128;
+
+inline Lanes load(const Texel& texel) { return _mm_load_ps(texel.value); }
+inline void store(Texel& texel, const Lanes lanes) {
+  _mm_store_ps(texel.value, lanes);
+}
+inline Lanes add(const Lanes a, const Lanes b) { return _mm_add_ps(a, b); }
+inline Lanes scale(const Lanes a, const float weight) {
+  return _mm_mul_ps(a, _mm_set1_ps(weight));
+}
+#else
+using Lanes = Texel;
+
+inline Lanes load(const Texel& texel) { return texel; }
+inline void store(Texel& texel, const Lanes lanes) { texel = lanes; }
+inline Lanes add(Lanes a, const Lanes b) {
+  for (size_t c = 0; c < 4; c++) a.value[c] += b.value[c];
+  return a;
+}
+inline Lanes scale(Lanes a, const float weight) {
+  for (size_t c = 0; c < 4; c++) a.value[c] *= weight;
+  return a;
+}
+#endif
+
+inline Lanes accumulate(const Lanes sum, const Texel& texel,
+                        const float weight) {
+  return add(sum, scale(load(texel), weight));
+}
+
+inline const std::array<float, 256>& srgbToLinear() {
+  static const auto table = [] {
+    std::array<float, 256> out;
+    for (size_t i = 0; i < out.size(); i++) {
+      const auto value = i / 255.0f;
+      out[i] = value <= 0.04045f ? value / 12.92f
+                                 : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+    return out;
+  }();
+  return table;
+}
+
+// Linear values at the midpoints between two sRGB codes, so encoding rounds
+// to the nearest code in sRGB space
+inline const std::array<float, 255>& linearThresholds() {
+  static const auto table = [] {
+    std::array<float, 255> out;
+    for (size_t i = 0; i < out.size(); i++) {
+      const auto value = (i + 0.5f) / 255.0f;
+      out[i] = value <= 0.04045f ? value / 12.92f
+                                 : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+    return out;
+  }();
+  return table;
+}
+
+inline uint8_t linearToSRGB(const float value) {
+  const auto& thresholds = linearThresholds();
+  return (uint8_t)(std::upper_bound(thresholds.begin(), thresholds.end(),
+                                    value) -
+                   thresholds.begin());
+}
+
+inline bool isColor(const uint32_t channel, const uint32_t c) {
+  // Gray alpha and rgba keep their alpha in the last channel
+  return !((channel == 2 || channel == 4) && c == channel - 1);
+}
+
+// Decoding is a table lookup per channel, so it stays scalar, a gather
+// would not be faster than four loads
+inline std::vector<Texel> decode(const uint8_t* texels, const size_t pixels,
+                                 const uint32_t channel, const bool gamma) {
+  const auto& table = srgbToLinear();
+  std::array<float, 256> linear;
+  for (size_t i = 0; i < linear.size(); i++) linear[i] = i / 255.0f;
+  std::array<const float*, 4> tables;
+  for (uint32_t c = 0; c < 4; c++)
+    tables[c] = gamma && isColor(channel, c) ? table.data() : linear.data();
+  std::vector<Texel> out(pixels);
+  for (size_t i = 0; i < pixels; i++) {
+    const auto texel = texels + i * channel;
+    for (uint32_t c = 0; c < channel; c++)
+      out[i].value[c] = tables[c][texel[c]];
+  }
+  return out;
+}
+
+// Clamping and rounding run on all four channels at once, sRGB channels are
+// then looked up in the thresholds from the clamped value
+inline void encode(const std::vector<Texel>& texels, const uint32_t channel,
+                   const bool gamma, uint8_t* out) {
+  std::array<bool, 4> srgb;
+  for (uint32_t c = 0; c < 4; c++) srgb[c] = gamma && isColor(channel, c);
+  for (size_t i = 0; i < texels.size(); i++) {
+    alignas(16) float clamped[4];
+    alignas(16) int32_t rounded[4];
+#ifdef TGE_MIP_SSE
+    const auto value = _mm_min_ps(
+        _mm_max_ps(load(texels[i]), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    _mm_store_ps(clamped, value);
+    _mm_store_si128((__m128i*)rounded,
+                    _mm_cvttps_epi32(_mm_add_ps(
+                        _mm_mul_ps(value, _mm_set1_ps(255.0f)),
+                        _mm_set1_ps(0.5f))));
+#else
+    for (uint32_t c = 0; c < 4; c++) {
+      clamped[c] = std::clamp(texels[i].value[c], 0.0f, 1.0f);
+      rounded[c] = (int32_t)(clamped[c] * 255.0f + 0.5f);
+    }
+#endif
+    for (uint32_t c = 0; c < channel; c++)
+      out[i * channel + c] =
+          srgb[c] ? linearToSRGB(clamped[c]) : (uint8_t)rounded[c];
+  }
+}
+
+inline double besselI0(const double x) {
+  double sum = 1.0, term = 1.0;
+  for (int k = 1; k < 32; k++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+// Kaiser windowed sinc for a 2x reduction, the taps sit at source offsets
+// -2.5 to 2.5 from the center of the destination texel
+inline const std::array<float, 6>& kaiserWeights() {
+  static const auto weights = [] {
+    constexpr double alpha = 4.0, width = 3.0, pi = 3.14159265358979323846;
+    std::array<float, 6> out;
+    double sum = 0.0;
+    for (size_t i = 0; i < out.size(); i++) {
+      const auto x = i - 2.5;
+      const auto t = x / 2.0;
+      const auto sinc = std::sin(pi * t) / (pi * t);
+      const auto ratio = x / width;
+      const auto window =
+          besselI0(alpha * std::sqrt(1.0 - ratio * ratio)) / besselI0(alpha);
+      out[i] = (float)(sinc * window);
+      sum += out[i];
+    }
+    for (auto& weight : out) weight = (float)(weight / sum);
+    return out;
+  }();
+  return weights;
+}
+
+inline std::vector<Texel> downsampleBox(const std::vector<Texel>& in,
+                                        const uint32_t width,
+                                        const uint32_t height) {
+  const auto nextWidth = std::max(width / 2, 1u);
+  const auto nextHeight = std::max(height / 2, 1u);
+  std::vector<Texel> out((size_t)nextWidth * nextHeight);
+  for (uint32_t y = 0; y < nextHeight; y++) {
+    const auto y0 = std::min(y * 2, height - 1);
+    const auto y1 = std::min(y * 2 + 1, height - 1);
+    for (uint32_t x = 0; x < nextWidth; x++) {
+      const auto x0 = std::min(x * 2, width - 1);
+      const auto x1 = std::min(x * 2 + 1, width - 1);
+      const auto top = add(load(in[(size_t)y0 * width + x0]),
+                           load(in[(size_t)y0 * width + x1]));
+      const auto bottom = add(load(in[(size_t)y1 * width + x0]),
+                              load(in[(size_t)y1 * width + x1]));
+      store(out[(size_t)y * nextWidth + x], scale(add(top, bottom), 0.25f));
+    }
+  }
+  return out;
+}
+
+// Separable, first along x then along y, edges are clamped
+inline std::vector<Texel> downsampleKaiser(const std::vector<Texel>& in,
+                                           const uint32_t width,
+                                           const uint32_t height) {
+  const auto& weights = kaiserWeights();
+  const auto nextWidth = std::max(width / 2, 1u);
+  const auto nextHeight = std::max(height / 2, 1u);
+  const auto tap = [](const uint32_t center, const size_t k,
+                      const uint32_t size) {
+    return (uint32_t)std::clamp((int64_t)center * 2 - 2 + (int64_t)k,
+                                (int64_t)0, (int64_t)size - 1);
+  };
+  std::vector<Texel> horizontal((size_t)nextWidth * height);
+  for (uint32_t y = 0; y < height; y++) {
+    const auto row = in.data() + (size_t)y * width;
+    for (uint32_t x = 0; x < nextWidth; x++) {
+      auto sum = scale(load(row[tap(x, 0, width)]), weights[0]);
+      for (size_t k = 1; k < weights.size(); k++)
+        sum = accumulate(sum, row[tap(x, k, width)], weights[k]);
+      store(horizontal[(size_t)y * nextWidth + x], sum);
+    }
+  }
+  std::vector<Texel> out((size_t)nextWidth * nextHeight);
+  std::array<const Texel*, 6> rows;
+  for (uint32_t y = 0; y < nextHeight; y++) {
+    for (size_t k = 0; k < rows.size(); k++)
+      rows[k] = horizontal.data() + (size_t)tap(y, k, height) * nextWidth;
+    for (uint32_t x = 0; x < nextWidth; x++) {
+      auto sum = scale(load(rows[0][x]), weights[0]);
+      for (size_t k = 1; k < rows.size(); k++)
+        sum = accumulate(sum, rows[k][x], weights[k]);
+      store(out[(size_t)y * nextWidth + x], sum);
+    }
+  }
+  return out;
+}
+
+}  // namespace mip
+
+// Builds the mip chain of an 8 bit image with 1 to 4 channels, the levels
+// are filtered from each other in float so rounding does not accumulate
+inline MipChain generateMipChain(const uint8_t* texels, const uint32_t width,
+                                 const uint32_t height, const uint32_t channel,
+                                 const MipSettings& settings = {}) {
+  MipChain chain;
+  if (texels == nullptr || width == 0 || height == 0 || channel == 0 ||
+      channel > 4)
+    return chain;
+  const auto levels =
+      std::clamp(settings.levels, 1u, fullMipChain(width, height));
+  size_t size = 0;
+  chain.offsets.reserve(levels);
+  for (uint32_t level = 0; level < levels; level++) {
+    chain.offsets.push_back(size);
+    size += (size_t)std::max(width >> level, 1u) *
+            std::max(height >> level, 1u) * channel;
+  }
+  chain.data.resize(size);
+  std::copy(texels, texels + (size_t)width * height * channel,
+            chain.data.begin());
+
+  auto current = mip::decode(texels, (size_t)width * height, channel,
+                             settings.gammaCorrect);
+  auto levelWidth = width, levelHeight = height;
+  for (uint32_t level = 1; level < levels; level++) {
+    current = settings.filter == MipFilter::KAISER
+                  ? mip::downsampleKaiser(current, levelWidth, levelHeight)
+                  : mip::downsampleBox(current, levelWidth, levelHeight);
+    levelWidth = std::max(levelWidth / 2, 1u);
+    levelHeight = std::max(levelHeight / 2, 1u);
+    mip::encode(current, channel, settings.gammaCorrect,
+                chain.data.data() + chain.offsets[level]);
+  }
+  return chain;
+}
+
+}  // namespace tge::graphics
@@ -88,6 +88,13 @@ namespace tge::graphics {
 			return rtc;
 		}
 
+		[[nodiscard]] virtual std::vector<TDataHolder> pushPackedData(
+			const size_t dataCount, const BufferInfo* bufferInfo,
+			const std::string& debugTag = "Unknown") override {
+			TimingAdder adder(dataCounter);
+			return api->pushPackedData(dataCount, bufferInfo, debugTag);
+		}
+
 		virtual void changeData(const size_t dataCount,
 			const BufferChange* change) override {
 			return api->changeData(dataCount, change);
@@ -159,6 +166,11 @@ namespace tge::graphics {
 			return api->getAligned(type);
 		}
 
+		[[nodiscard]] virtual bool isTextureFormatSupported(const size_t format,
+			const bool blit = true) const override {
+			return api->isTextureFormatSupported(format, blit);
+		}
+
 		[[nodiscard]] virtual glm::vec2 getRenderExtent() const override {
 			return api->getRenderExtent();
 		}
@@ -169,6 +181,46 @@ namespace tge::graphics {
 			return api->getImageData(imageId, cache);
 		}
 
+		[[nodiscard]] virtual TReadbackHolder readImageAsync(
+			const TTextureHolder imageId) override {
+			return api->readImageAsync(imageId);
+		}
+
+		[[nodiscard]] virtual TReadbackHolder readOutputAsync() override {
+			return api->readOutputAsync();
+		}
+
+		[[nodiscard]] virtual TextureInfo getReadbackInfo(
+			const TReadbackHolder readback) override {
+			return api->getReadbackInfo(readback);
+		}
+
+		[[nodiscard]] virtual bool isReadbackReady(
+			const TReadbackHolder readback) override {
+			return api->isReadbackReady(readback);
+		}
+
+		[[nodiscard]] virtual std::span<const char> getReadbackData(
+			const TReadbackHolder readback) override {
+			return api->getReadbackData(readback);
+		}
+
+		virtual void releaseReadback(const TReadbackHolder readback) override {
+			api->releaseReadback(readback);
+		}
+
+		[[nodiscard]] virtual MemoryBudget getMemoryBudget() override {
+			return api->getMemoryBudget();
+		}
+
+		[[nodiscard]] virtual size_t getFramesInFlight() const override {
+			return api->getFramesInFlight();
+		}
+
+		[[nodiscard]] virtual std::unique_lock<std::mutex> lockFrames() override {
+			return api->lockFrames();
+		}
+
 		virtual APILayer* backend() override { return api->backend(); }
 
 		virtual void initDebugGUI() override { return api->initDebugGUI(); }
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+
+#include "../Error.hpp"
+
+namespace tge::graphics {
+
+// Hands out ranges of a fixed size ring in FIFO order. Ranges can be
+// released in any order, but their space only becomes free again once all
+// older ranges were released as well
+class RingAllocator {
+  struct Range {
+    size_t offset;
+    size_t end;
+    bool released;
+  };
+
+  size_t capacity = 0;
+  std::deque<Range> ranges;
+
+ public:
+  RingAllocator() = default;
+
+  explicit RingAllocator(const size_t capacity) : capacity(capacity) {}
+
+  [[nodiscard]] size_t size() const { return capacity; }
+
+  [[nodiscard]] bool empty() const { return ranges.empty(); }
+
+  // Offset of the new range or INVALID_SIZE_T if the ring is full,
+  // alignment has to be a power of two
+  [[nodiscard]] size_t allocate(const size_t size, const size_t alignment = 1) {
+    const auto align = [&](const size_t offset) {
+      return (offset + alignment - 1) & ~(alignment - 1);
+    };
+    size_t offset = INVALID_SIZE_T;
+    if (size == 0) return offset;
+    if (ranges.empty()) {
+      if (size <= capacity) offset = 0;
+    } else {
+      const auto tail = ranges.front().offset;
+      const auto head = align(ranges.back().end);
+      const bool wrapped = ranges.back().end <= tail;
+      if (!wrapped && head + size <= capacity) {
+        offset = head;
+      } else if (!wrapped && size <= tail) {
+        offset = 0;
+      } else if (wrapped && head + size <= tail) {
+        offset = head;
+      }
+    }
+    if (offset != INVALID_SIZE_T) ranges.push_back({offset, offset + size, false});
+    return offset;
+  }
+
+  void release(const size_t offset) {
+    for (auto& range : ranges) {
+      if (range.offset != offset || range.released) continue;
+      range.released = true;
+      break;
+    }
+    while (!ranges.empty() && ranges.front().released) ranges.pop_front();
+  }
+};
+
+}  // namespace tge::graphics
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <utility>
+#include <vector>
+
+#include "../Error.hpp"
+
+namespace tge::graphics {
+
+struct TLSFAllocation {
+  size_t offset = INVALID_SIZE_T;
+  uint32_t node = INVALID_UINT32;
+
+  [[nodiscard]] inline bool operator!() const { return node == INVALID_UINT32; }
+};
+
+// Two level segregated fit allocator handing out ranges of a fixed size, both
+// allocate and free run in constant time. Free ranges are kept in lists per
+// power of two split into SL_COUNT linear classes, neighbouring free ranges
+// are always merged
+class TLSFAllocator {
+  static constexpr uint32_t SL_BITS = 4;
+  static constexpr uint32_t SL_COUNT = 1u << SL_BITS;
+  static constexpr uint32_t FL_COUNT = 64 - SL_BITS + 1;
+  static constexpr uint32_t NONE = INVALID_UINT32;
+
+  struct Node {
+    size_t offset = 0;
+    size_t size = 0;
+    // Physical neighbours
+    uint32_t previous = NONE;
+    uint32_t next = NONE;
+    // Neighbours in the free list of the size class
+    uint32_t previousFree = NONE;
+    uint32_t nextFree = NONE;
+    bool free = false;
+  };
+
+  std::vector<Node> nodes;
+  std::vector<uint32_t> unusedNodes;
+  uint64_t firstLevelBits = 0;
+  std::array<uint32_t, FL_COUNT> secondLevelBits{};
+  std::array<std::array<uint32_t, SL_COUNT>, FL_COUNT> heads;
+  size_t capacity = 0;
+  size_t used = 0;
+  size_t allocations = 0;
+
+  static std::pair<uint32_t, uint32_t> mapping(const size_t size) {
+    if (size < SL_COUNT) return {0, (uint32_t)size};
+    const auto msb = (uint32_t)std::bit_width(size) - 1;
+    return {msb - SL_BITS + 1,
+            (uint32_t)(size >> (msb - SL_BITS)) & (SL_COUNT - 1)};
+  }
+
+  // Class whose ranges are all at least size large
+  static std::pair<uint32_t, uint32_t> searchMapping(size_t size) {
+    if (size >= SL_COUNT) {
+      const auto msb = (uint32_t)std::bit_width(size) - 1;
+      size += ((size_t)1 << (msb - SL_BITS)) - 1;
+    }
+    return mapping(size);
+  }
+
+  uint32_t newNode() {
+    if (!unusedNodes.empty()) {
+      const auto index = unusedNodes.back();
+      unusedNodes.pop_back();
+      nodes[index] = Node();
+      return index;
+    }
+    nodes.emplace_back();
+    return (uint32_t)nodes.size() - 1;
+  }
+
+  void insertFree(const uint32_t index) {
+    auto& node = nodes[index];
+    const auto [fl, sl] = mapping(node.size);
+    node.free = true;
+    node.previousFree = NONE;
+    node.nextFree = heads[fl][sl];
+    if (node.nextFree != NONE) nodes[node.nextFree].previousFree = index;
+    heads[fl][sl] = index;
+    firstLevelBits |= (uint64_t)1 << fl;
+    secondLevelBits[fl] |= 1u << sl;
+  }
+
+  void removeFree(const uint32_t index) {
+    auto& node = nodes[index];
+    const auto [fl, sl] = mapping(node.size);
+    if (node.previousFree != NONE)
+      nodes[node.previousFree].nextFree = node.nextFree;
+    if (node.nextFree != NONE)
+      nodes[node.nextFree].previousFree = node.previousFree;
+    if (heads[fl][sl] == index) {
+      heads[fl][sl] = node.nextFree;
+      if (node.nextFree == NONE) {
+        secondLevelBits[fl] &= ~(1u << sl);
+        if (secondLevelBits[fl] == 0) firstLevelBits &= ~((uint64_t)1 << fl);
+      }
+    }
+    node.free = false;
+    node.previousFree = NONE;
+    node.nextFree = NONE;
+  }
+
+  [[nodiscard]] uint32_t findFree(uint32_t fl, uint32_t sl) const {
+    auto secondBits = sl < SL_COUNT ? secondLevelBits[fl] & (~0u << sl) : 0;
+    if (secondBits == 0) {
+      const auto firstBits =
+          fl + 1 < 64 ? firstLevelBits & (~(uint64_t)0 << (fl + 1)) : 0;
+      if (firstBits == 0) return NONE;
+      fl = (uint32_t)std::countr_zero(firstBits);
+      secondBits = secondLevelBits[fl];
+    }
+    sl = (uint32_t)std::countr_zero(secondBits);
+    return heads[fl][sl];
+  }
+
+  // Splits the range of the node at size, the rest becomes a free node
+  void split(const uint32_t index, const size_t size) {
+    const auto rest = newNode();
+    auto& node = nodes[index];
+    auto& restNode = nodes[rest];
+    restNode.offset = node.offset + size;
+    restNode.size = node.size - size;
+    restNode.previous = index;
+    restNode.next = node.next;
+    if (node.next != NONE) nodes[node.next].previous = rest;
+    node.next = rest;
+    node.size = size;
+    insertFree(rest);
+  }
+
+  // Merges the next node into the node at index and recycles it
+  void absorbNext(const uint32_t index) {
+    const auto next = nodes[index].next;
+    nodes[index].size += nodes[next].size;
+    nodes[index].next = nodes[next].next;
+    if (nodes[next].next != NONE) nodes[nodes[next].next].previous = index;
+    unusedNodes.push_back(next);
+  }
+
+ public:
+  TLSFAllocator() = default;
+
+  explicit TLSFAllocator(const size_t capacity) : capacity(capacity) {
+    for (auto& level : heads) level.fill(NONE);
+    if (capacity == 0) return;
+    const auto index = newNode();
+    nodes[index].size = capacity;
+    insertFree(index);
+  }
+
+  [[nodiscard]] size_t size() const { return capacity; }
+
+  [[nodiscard]] size_t usedSize() const { return used; }
+
+  [[nodiscard]] size_t allocationCount() const { return allocations; }
+
+  [[nodiscard]] bool empty() const { return allocations == 0; }
+
+  // Empty allocation if no free range fits, alignment has to be a power of two
+  [[nodiscard]] TLSFAllocation allocate(const size_t size,
+                                        const size_t alignment = 1) {
+    if (size == 0 || alignment == 0 || (alignment & (alignment - 1)) != 0 ||
+        size > capacity || alignment - 1 > capacity - size)
+      return {};
+    const auto [fl, sl] = searchMapping(size + alignment - 1);
+    if (fl >= FL_COUNT) return {};
+    auto index = findFree(fl, sl);
+    if (index == NONE) return {};
+    removeFree(index);
+
+    const auto offset = nodes[index].offset;
+    const auto padding = ((offset + alignment - 1) & ~(alignment - 1)) - offset;
+    if (padding > 0) {
+      // The front stays free, its previous node is never free
+      split(index, padding);
+      const auto aligned = nodes[index].next;
+      removeFree(aligned);
+      insertFree(index);
+      index = aligned;
+    }
+    // The next node of a free node is never free either
+    if (nodes[index].size > size) split(index, size);
+    used += size;
+    allocations++;
+    return {nodes[index].offset, index};
+  }
+
+  void free(const TLSFAllocation allocation) {
+    auto index = allocation.node;
+    if (index >= nodes.size() || nodes[index].free ||
+        nodes[index].offset != allocation.offset)
+      return;
+    used -= nodes[index].size;
+    allocations--;
+    const auto next = nodes[index].next;
+    if (next != NONE && nodes[next].free) {
+      removeFree(next);
+      absorbNext(index);
+    }
+    const auto previous = nodes[index].previous;
+    if (previous != NONE && nodes[previous].free) {
+      removeFree(previous);
+      absorbNext(previous);
+      index = previous;
+    }
+    insertFree(index);
+  }
+
+  // Largest range a single allocation without alignment can get
+  [[nodiscard]] size_t largestFree() const {
+    if (firstLevelBits == 0) return 0;
+    const auto fl = (uint32_t)(63 - std::countl_zero(firstLevelBits));
+    const auto sl = (uint32_t)(31 - std::countl_zero(secondLevelBits[fl]));
+    size_t largest = 0;
+    for (auto index = heads[fl][sl]; index != NONE;
+         index = nodes[index].nextFree)
+      largest = std::max(largest, nodes[index].size);
+    return largest;
+  }
+};
+
+}  // namespace tge::graphics
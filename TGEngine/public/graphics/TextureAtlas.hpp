@@ -0,0 +1,195 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "../Error.hpp"
+
+namespace tge::graphics {
+
+struct AtlasSettings {
+  // Width and height of a page, every page is cut to the height it uses
+  uint32_t pageSize = 2048;
+  // Power of two border filled with the edge texels, rects start on this
+  // grid so the first log2(padding) + 1 mips don't bleed into each other
+  uint32_t padding = 4;
+  // Textures larger than this in either direction get their own image
+  uint32_t maxSize = 256;
+};
+
+// Position of the texels of a packed texture, the padding surrounds them
+struct AtlasRect {
+  uint32_t page = INVALID_UINT32;
+  uint32_t x = 0;
+  uint32_t y = 0;
+};
+
+struct AtlasLayout {
+  std::vector<AtlasRect> rects;
+  std::vector<std::array<uint32_t, 2>> pages;
+};
+
+constexpr uint32_t atlasMipLevels(const uint32_t padding) {
+  uint32_t levels = 1;
+  for (auto size = padding; size > 1; size >>= 1) levels++;
+  return levels;
+}
+
+// Bottom left skyline packer, every segment is a run of columns with the
+// same height
+class SkylinePacker {
+  struct Segment {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+  };
+
+  uint32_t width;
+  uint32_t height;
+  std::vector<Segment> skyline;
+
+  // Lowest y a rect of this width can sit at when starting at segment index
+  [[nodiscard]] uint32_t fit(const size_t index, const uint32_t rectWidth,
+                             const uint32_t rectHeight) const {
+    if (skyline[index].x + rectWidth > width) return INVALID_UINT32;
+    uint32_t y = 0;
+    uint32_t left = rectWidth;
+    for (auto i = index; left > 0; i++) {
+      y = std::max(y, skyline[i].y);
+      if (y + rectHeight > height) return INVALID_UINT32;
+      left -= std::min(left, skyline[i].width);
+    }
+    return y;
+  }
+
+ public:
+  uint32_t usedHeight = 0;
+
+  SkylinePacker(const uint32_t width, const uint32_t height)
+      : width(width), height(height), skyline{{0, 0, width}} {}
+
+  [[nodiscard]] bool insert(const uint32_t rectWidth,
+                            const uint32_t rectHeight, uint32_t& x,
+                            uint32_t& y) {
+    // Lowest top edge wins, ties go to the narrowest segment
+    size_t best = INVALID_SIZE_T;
+    uint32_t bestY = INVALID_UINT32;
+    uint32_t bestWidth = INVALID_UINT32;
+    for (size_t i = 0; i < skyline.size(); i++) {
+      const auto fitY = fit(i, rectWidth, rectHeight);
+      if (fitY == INVALID_UINT32) continue;
+      if (fitY < bestY || (fitY == bestY && skyline[i].width < bestWidth)) {
+        best = i;
+        bestY = fitY;
+        bestWidth = skyline[i].width;
+      }
+    }
+    if (best == INVALID_SIZE_T) return false;
+    x = skyline[best].x;
+    y = bestY;
+    usedHeight = std::max(usedHeight, y + rectHeight);
+
+    // The new segment covers everything below its right edge
+    const Segment segment{x, y + rectHeight, rectWidth};
+    auto i = best;
+    auto covered = rectWidth;
+    while (i < skyline.size() && covered > 0) {
+      auto& current = skyline[i];
+      const auto overlap = std::min(covered, current.width);
+      if (overlap == current.width) {
+        covered -= overlap;
+        skyline.erase(skyline.begin() + i);
+        continue;
+      }
+      current.x += overlap;
+      current.width -= overlap;
+      covered = 0;
+    }
+    skyline.insert(skyline.begin() + best, segment);
+    // Merge neighbours of the same height
+    for (size_t j = 0; j + 1 < skyline.size();) {
+      if (skyline[j].y == skyline[j + 1].y) {
+        skyline[j].width += skyline[j + 1].width;
+        skyline.erase(skyline.begin() + j + 1);
+      } else {
+        j++;
+      }
+    }
+    return true;
+  }
+};
+
+// Packs the sizes tallest first into as few pages as possible, sizes above
+// settings.maxSize keep an invalid page
+inline AtlasLayout packAtlas(
+    const std::span<const std::array<uint32_t, 2>> sizes,
+    const AtlasSettings& settings = {}) {
+  AtlasLayout layout;
+  layout.rects.resize(sizes.size());
+  const auto padding = std::max(settings.padding, 1u);
+  const auto padded = [&](const uint32_t size) {
+    return (size + 2 * padding + padding - 1) / padding * padding;
+  };
+  std::vector<size_t> order(sizes.size());
+  std::iota(order.begin(), order.end(), (size_t)0);
+  std::ranges::stable_sort(order, [&](const size_t a, const size_t b) {
+    return sizes[a][1] > sizes[b][1];
+  });
+
+  std::vector<SkylinePacker> packers;
+  for (const auto index : order) {
+    const auto [width, height] = sizes[index];
+    if (width == 0 || height == 0 || width > settings.maxSize ||
+        height > settings.maxSize || padded(width) > settings.pageSize ||
+        padded(height) > settings.pageSize)
+      continue;
+    uint32_t x = 0, y = 0;
+    size_t page = 0;
+    for (; page < packers.size(); page++) {
+      if (packers[page].insert(padded(width), padded(height), x, y)) break;
+    }
+    if (page == packers.size()) {
+      packers.emplace_back(settings.pageSize, settings.pageSize);
+      (void)packers.back().insert(padded(width), padded(height), x, y);
+    }
+    layout.rects[index] = {(uint32_t)page, x + padding, y + padding};
+  }
+  layout.pages.reserve(packers.size());
+  for (const auto& packer : packers) {
+    layout.pages.push_back({settings.pageSize, packer.usedHeight});
+  }
+  return layout;
+}
+
+// Copies the texels into the page and extends their edges into the padding
+inline void copyToPage(const uint8_t* texels, const uint32_t width,
+                       const uint32_t height, const size_t texelSize,
+                       const AtlasRect& rect, const uint32_t padding,
+                       uint8_t* page, const uint32_t pageWidth,
+                       const uint32_t pageHeight) {
+  const auto firstX = rect.x - std::min(rect.x, padding);
+  const auto lastX = std::min(rect.x + width + padding, pageWidth);
+  const auto firstY = rect.y - std::min(rect.y, padding);
+  const auto lastY = std::min(rect.y + height + padding, pageHeight);
+  for (auto y = firstY; y < lastY; y++) {
+    const auto sourceY =
+        std::clamp<int64_t>((int64_t)y - rect.y, 0, (int64_t)height - 1);
+    const auto sourceRow = texels + sourceY * width * texelSize;
+    auto target = page + ((size_t)y * pageWidth + firstX) * texelSize;
+    for (auto x = firstX; x < rect.x; x++, target += texelSize)
+      std::memcpy(target, sourceRow, texelSize);
+    std::memcpy(target, sourceRow, width * texelSize);
+    target += width * texelSize;
+    const auto lastTexel = sourceRow + (width - 1) * texelSize;
+    for (auto x = rect.x + width; x < lastX; x++, target += texelSize)
+      std::memcpy(target, lastTexel, texelSize);
+  }
+}
+
+}  // namespace tge::graphics
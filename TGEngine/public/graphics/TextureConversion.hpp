@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// The SSSE3 path is compiled into every x86 build and picked at runtime, the
+// build does not have to enable SSSE3 for the whole engine
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+#include <tmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TGE_TARGET_SSSE3
+#else
+#define TGE_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#define TGE_TEXTURE_SSSE3 1
+#endif
+
+namespace tge::graphics {
+
+// Checked once, false on cpus without SSSE3 and outside of x86
+inline bool hasSSSE3() {
+#if !defined(TGE_TEXTURE_SSSE3)
+  return false;
+#elif defined(__SSSE3__)
+  return true;
+#elif defined(_MSC_VER)
+  static const bool supported = [] {
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+  }();
+  return supported;
+#else
+  static const bool supported = __builtin_cpu_supports("ssse3");
+  return supported;
+#endif
+}
+
+#ifdef TGE_TEXTURE_SSSE3
+// Four texels per iteration, each load reads 16 bytes of which 12 are used,
+// the tail that would read past the end is left to the caller. Returns the
+// amount of texels converted
+TGE_TARGET_SSSE3 inline size_t expandRGB8SSSE3(const uint8_t* in,
+                                               const size_t pixels,
+                                               uint8_t* out) {
+  const auto shuffle =
+      _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const auto alpha = _mm_set1_epi32((int)0xFF000000);
+  size_t i = 0;
+  for (; i + 6 <= pixels; i += 4) {
+    const auto rgb = _mm_loadu_si128((const __m128i*)(in + i * 3));
+    const auto rgba = _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha);
+    _mm_storeu_si128((__m128i*)(out + i * 4), rgba);
+  }
+  return i;
+}
+#endif
+
+// Expands gray, gray alpha and rgb texels to rgba with an opaque alpha, gray
+// is replicated into rgb the same way stbi does it. Texels before first are
+// skipped
+template <class T>
+inline void expandToRGBAScalar(const T* in, const size_t pixels,
+                               const uint32_t channel, T* out,
+                               const size_t first = 0) {
+  constexpr T opaque = std::numeric_limits<T>::max();
+  for (size_t i = first; i < pixels; i++) {
+    const T* texel = in + i * channel;
+    T* target = out + i * 4;
+    switch (channel) {
+      case 1:
+        target[0] = target[1] = target[2] = texel[0];
+        target[3] = opaque;
+        break;
+      case 2:
+        target[0] = target[1] = target[2] = texel[0];
+        target[3] = texel[1];
+        break;
+      case 3:
+        target[0] = texel[0];
+        target[1] = texel[1];
+        target[2] = texel[2];
+        target[3] = opaque;
+        break;
+      default:
+        for (uint32_t c = 0; c < 4; c++) target[c] = texel[c];
+        break;
+    }
+  }
+}
+
+// 8 bit rgb is expanded with SSSE3 if the cpu supports it
+template <class T>
+inline void expandToRGBA(const T* in, const size_t pixels,
+                         const uint32_t channel, T* out) {
+  size_t first = 0;
+#ifdef TGE_TEXTURE_SSSE3
+  if constexpr (sizeof(T) == 1) {
+    if (channel == 3 && hasSSSE3()) first = expandRGB8SSSE3(in, pixels, out);
+  }
+#endif
+  expandToRGBAScalar(in, pixels, channel, out, first);
+}
+
+}  // namespace tge::graphics
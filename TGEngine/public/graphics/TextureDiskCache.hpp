@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <span>
+#include <string>
+#include <thread>
+
+namespace tge::graphics {
+
+// "TGTC", the version changes whenever decoding produces different texels
+constexpr uint32_t TEXTURE_CACHE_MAGIC = 0x43544754;
+constexpr uint32_t TEXTURE_CACHE_VERSION = 1;
+
+// Precedes the texels of a decoded texture in the cache, the texels start
+// 64 bytes into the file and are uploaded as they are
+struct CachedTextureHeader {
+  uint32_t magic = TEXTURE_CACHE_MAGIC;
+  uint32_t version = TEXTURE_CACHE_VERSION;
+  uint64_t sourceHash = 0;
+  uint64_t settingsHash = 0;
+  uint64_t format = 0;
+  uint64_t size = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t channel = 0;
+  uint32_t mipLevels = 0;
+  uint32_t blitMode = 0;
+  uint32_t grayscale = 0;
+};
+static_assert(sizeof(CachedTextureHeader) == 64);
+
+// One file per source content and import settings
+inline std::filesystem::path cachedTexturePath(
+    const std::filesystem::path& directory, const uint64_t sourceHash,
+    const uint64_t settingsHash) {
+  char name[48];
+  std::snprintf(name, sizeof(name), "%016llx%016llx.tgtex",
+                (unsigned long long)sourceHash,
+                (unsigned long long)settingsHash);
+  return directory / name;
+}
+
+// The texels of a valid cache file for the hashes, empty otherwise
+[[nodiscard]] inline std::span<const char> readCachedTexture(
+    const std::span<const char> file, const uint64_t sourceHash,
+    const uint64_t settingsHash, CachedTextureHeader& header) {
+  if (file.size() < sizeof(CachedTextureHeader)) return {};
+  std::memcpy(&header, file.data(), sizeof(CachedTextureHeader));
+  if (header.magic != TEXTURE_CACHE_MAGIC ||
+      header.version != TEXTURE_CACHE_VERSION ||
+      header.sourceHash != sourceHash || header.settingsHash != settingsHash ||
+      header.size == 0 ||
+      header.size != file.size() - sizeof(CachedTextureHeader))
+    return {};
+  return file.subspan(sizeof(CachedTextureHeader));
+}
+
+// Writes into a temporary file first so concurrent writers and readers never
+// see a partial file
+inline bool writeCachedTexture(const std::filesystem::path& path,
+                               const CachedTextureHeader& header,
+                               const std::span<const char> texels) {
+  auto temporary = path;
+  temporary += "." +
+               std::to_string(std::hash<std::thread::id>{}(
+                   std::this_thread::get_id())) +
+               ".tmp";
+  {
+    std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+    output.write((const char*)&header, sizeof(header));
+    output.write(texels.data(), texels.size());
+    if (!output.good()) {
+      output.close();
+      std::error_code code;
+      std::filesystem::remove(temporary, code);
+      return false;
+    }
+  }
+  std::error_code code;
+  std::filesystem::rename(temporary, path, code);
+  if (!code) return true;
+  std::filesystem::remove(temporary, code);
+  return false;
+}
+
+}  // namespace tge::graphics
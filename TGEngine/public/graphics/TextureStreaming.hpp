@@ -0,0 +1,352 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ElementHolder.hpp"
+#include "GameShaderModule.hpp"
+
+namespace tge::graphics {
+
+DEFINE_HOLDER(Stream);
+
+// Start of every level of a tightly packed mip chain padded to whole blocks,
+// followed by the size of the whole chain
+inline std::vector<size_t> levelOffsets(const uint32_t width,
+                                        const uint32_t height,
+                                        const uint32_t levels,
+                                        const uint32_t blockWidth,
+                                        const uint32_t blockHeight,
+                                        const size_t blockBytes) {
+  std::vector<size_t> offsets;
+  offsets.reserve((size_t)levels + 1);
+  size_t offset = 0;
+  for (uint32_t level = 0; level < levels; level++) {
+    offsets.push_back(offset);
+    const auto levelWidth = std::max(width >> level, 1u);
+    const auto levelHeight = std::max(height >> level, 1u);
+    offset += (size_t)((levelWidth + blockWidth - 1) / blockWidth) *
+              ((levelHeight + blockHeight - 1) / blockHeight) * blockBytes;
+  }
+  offsets.push_back(offset);
+  return offsets;
+}
+
+// Whole mip chain of a streamed texture kept in host memory, only the levels
+// from the resident one down live on the GPU
+struct StreamSource {
+  std::vector<uint8_t> data;
+  std::vector<size_t> offsets;  // see levelOffsets
+  uint32_t width = 0;
+  uint32_t height = 0;
+  size_t format = 37;
+  uint32_t channel = 4;
+  bool grayscale = false;
+  bool opaque = false;
+  // Sources without a mip chain get their mips blitted on every upload
+  bool blitMips = false;
+  std::string debugInfo{};
+
+  [[nodiscard]] uint32_t levels() const {
+    return offsets.empty() ? 0 : (uint32_t)offsets.size() - 1;
+  }
+
+  // Bytes of all levels from first down to the smallest one
+  [[nodiscard]] size_t residentSize(const uint32_t first) const {
+    return first >= levels() ? 0 : offsets.back() - offsets[first];
+  }
+};
+
+// Copies the levels of a decoded texture into a source, the block size is
+// the texel size for uncompressed data. Returns nullptr if the data is
+// shorter than the levels need
+inline std::shared_ptr<StreamSource> makeStreamSource(
+    const std::span<const uint8_t> data, const uint32_t width,
+    const uint32_t height, const uint32_t levels, const uint32_t blockWidth,
+    const uint32_t blockHeight, const size_t blockBytes) {
+  auto source = std::make_shared<StreamSource>();
+  source->offsets =
+      levelOffsets(width, height, levels, blockWidth, blockHeight, blockBytes);
+  if (data.size() < source->offsets.back()) return nullptr;
+  source->data.assign(data.begin(), data.begin() + source->offsets.back());
+  source->width = width;
+  source->height = height;
+  return source;
+}
+
+struct StreamSettings {
+  // Device memory all streamed textures may use together
+  size_t budget = (size_t)256 << 20;
+  // Bytes uploaded per tick, further requests wait for the next ticks
+  size_t uploadPerTick = (size_t)16 << 20;
+  // Levels up to this size are uploaded right away and never evicted
+  uint32_t tailSize = 64;
+  // Ticks a texture keeps its levels after it was last requested
+  uint64_t keepTicks = 120;
+  // Ticks a replaced texture may still be sampled, the GameGraphicsModule
+  // sets it to the frames in flight of the backend
+  uint64_t retireTicks = 2;
+};
+
+// Largest level still needed when the texture covers screenSize pixels
+inline uint32_t desiredLevel(const uint32_t width, const uint32_t height,
+                             const uint32_t levels, const float screenSize) {
+  if (levels == 0) return 0;
+  if (!(screenSize > 0.0f)) return levels - 1;
+  const auto ratio = (float)std::max(width, height) / screenSize;
+  const auto level = std::floor(std::log2(std::max(ratio, 1.0f)));
+  return std::min((uint32_t)level, levels - 1);
+}
+
+struct StreamChange {
+  TStreamHolder stream;
+  uint32_t firstLevel;
+  std::shared_ptr<const StreamSource> source;
+};
+
+// Decides which levels of the streamed textures are resident from the screen
+// sizes requested every tick. The textures are uploaded and swapped by the
+// GameGraphicsModule, the streamer only tracks them and their bindings
+class TextureStreamer {
+  struct Stream {
+    std::shared_ptr<const StreamSource> source;
+    uint32_t tail = 0;
+    uint32_t resident = 0;
+    uint32_t pending = INVALID_UINT32;
+    uint32_t wanted = 0;
+    float screenSize = 0.0f;
+    float priority = 0.0f;
+    uint64_t lastRequest = 0;
+    TTextureHolder texture;
+    std::vector<shader::BindingInfo> bindings;
+  };
+
+  std::mutex mutex;
+  std::unordered_map<size_t, Stream> streams;
+  std::vector<std::pair<uint64_t, TTextureHolder>> retired;
+  size_t nextStream = 0;
+  uint64_t ticks = 0;
+  // Lower than the budget while the device is short on memory, see evict
+  size_t pressureCap = SIZE_MAX;
+
+ public:
+  StreamSettings settings;
+
+  [[nodiscard]] uint32_t tailLevel(const StreamSource& source) const {
+    uint32_t level = 0;
+    while (level + 1 < source.levels() &&
+           std::max(source.width >> level, source.height >> level) >
+               settings.tailSize)
+      level++;
+    return level;
+  }
+
+  // The texture has to hold the tail of the source, see tailLevel
+  [[nodiscard]] TStreamHolder add(std::shared_ptr<const StreamSource> source,
+                                  const TTextureHolder texture) {
+    if (!source || source->levels() == 0 || !texture) return TStreamHolder();
+    const auto tail = tailLevel(*source);
+    std::lock_guard guard(mutex);
+    const auto id = nextStream++;
+    Stream stream;
+    stream.source = std::move(source);
+    stream.tail = tail;
+    stream.resident = tail;
+    stream.wanted = tail;
+    stream.texture = texture;
+    streams.emplace(id, std::move(stream));
+    return TStreamHolder(id);
+  }
+
+  // Every stream still alive is retired together with its texture
+  void remove(const std::span<const TStreamHolder> holders) {
+    std::lock_guard guard(mutex);
+    for (const auto holder : holders) {
+      const auto found = streams.find(holder.internalHandle);
+      if (found == std::end(streams)) continue;
+      retired.emplace_back(ticks, found->second.texture);
+      streams.erase(found);
+    }
+  }
+
+  // Feedback for the next plan, the largest size of a tick wins
+  void request(const TStreamHolder holder, const float screenSize) {
+    std::lock_guard guard(mutex);
+    const auto found = streams.find(holder.internalHandle);
+    if (found == std::end(streams)) return;
+    found->second.screenSize = std::max(found->second.screenSize, screenSize);
+  }
+
+  // Remembers the binding for later swaps and returns the current texture,
+  // empty if the stream does not exist
+  [[nodiscard]] TTextureHolder bind(const TStreamHolder holder,
+                                    const shader::BindingInfo& binding) {
+    std::lock_guard guard(mutex);
+    const auto found = streams.find(holder.internalHandle);
+    if (found == std::end(streams)) return TTextureHolder();
+    auto& bindings = found->second.bindings;
+    std::erase_if(bindings, [&](const shader::BindingInfo& bound) {
+      return bound.bindingSet == binding.bindingSet &&
+             bound.binding == binding.binding &&
+             bound.arrayID == binding.arrayID;
+    });
+    bindings.push_back(binding);
+    return found->second.texture;
+  }
+
+  [[nodiscard]] TTextureHolder getTexture(const TStreamHolder holder) {
+    std::lock_guard guard(mutex);
+    const auto found = streams.find(holder.internalHandle);
+    return found == std::end(streams) ? TTextureHolder()
+                                      : found->second.texture;
+  }
+
+  [[nodiscard]] uint32_t getResidentLevel(const TStreamHolder holder) {
+    std::lock_guard guard(mutex);
+    const auto found = streams.find(holder.internalHandle);
+    return found == std::end(streams) ? INVALID_UINT32
+                                      : found->second.resident;
+  }
+
+  [[nodiscard]] size_t residentBytes() {
+    std::lock_guard guard(mutex);
+    size_t bytes = 0;
+    for (const auto& [id, stream] : streams)
+      bytes += stream.source->residentSize(stream.resident);
+    return bytes;
+  }
+
+  // Caps the budget so the next plan frees at least bytes of the resident
+  // levels, tails are never evicted. The configured budget stays as it is
+  void evict(const size_t bytes) {
+    std::lock_guard guard(mutex);
+    size_t resident = 0;
+    for (const auto& [id, stream] : streams)
+      resident += stream.source->residentSize(stream.resident);
+    pressureCap = std::min(pressureCap, resident > bytes ? resident - bytes : 0);
+  }
+
+  // Raises the cap of evict by the bytes of headroom, it is lifted once it
+  // reaches the configured budget
+  void relieve(const size_t bytes) {
+    std::lock_guard guard(mutex);
+    if (pressureCap == SIZE_MAX) return;
+    pressureCap += std::min(bytes, SIZE_MAX - pressureCap);
+    if (pressureCap >= settings.budget) pressureCap = SIZE_MAX;
+  }
+
+  // The configured budget or the lower cap of evict
+  [[nodiscard]] size_t currentBudget() {
+    std::lock_guard guard(mutex);
+    return std::min(settings.budget, pressureCap);
+  }
+
+  // Textures of the most visible streams get their levels first, the rest
+  // is evicted down to what still fits into the budget. Evictions come
+  // first, uploads are capped by settings.uploadPerTick and every stream
+  // has at most one change in flight
+  [[nodiscard]] std::vector<StreamChange> plan() {
+    std::lock_guard guard(mutex);
+    ticks++;
+    std::vector<std::pair<size_t, Stream*>> ordered;
+    ordered.reserve(streams.size());
+    size_t tailBytes = 0;
+    for (auto& [id, stream] : streams) {
+      const auto& source = *stream.source;
+      tailBytes += source.residentSize(stream.tail);
+      if (stream.screenSize > 0.0f) {
+        stream.wanted = std::min(desiredLevel(source.width, source.height,
+                                              source.levels(),
+                                              stream.screenSize),
+                                 stream.tail);
+        stream.priority = stream.screenSize;
+        stream.lastRequest = ticks;
+        stream.screenSize = 0.0f;
+      } else if (ticks - stream.lastRequest > settings.keepTicks) {
+        stream.wanted = stream.tail;
+        stream.priority = 0.0f;
+      }
+      ordered.emplace_back(id, &stream);
+    }
+    std::ranges::stable_sort(ordered, [](const auto& a, const auto& b) {
+      return a.second->priority > b.second->priority;
+    });
+
+    const auto budget = std::min(settings.budget, pressureCap);
+    auto budgetLeft = budget > tailBytes ? budget - tailBytes : 0;
+    size_t uploads = 0;
+    std::vector<StreamChange> changes;
+    for (const auto& [id, streamPointer] : ordered) {
+      auto& stream = *streamPointer;
+      const auto& source = *stream.source;
+      const auto current =
+          stream.pending != INVALID_UINT32 ? stream.pending : stream.resident;
+      // Levels still in use are kept until the budget needs them
+      auto target = stream.wanted;
+      if (ticks - stream.lastRequest <= settings.keepTicks)
+        target = std::min(target, current);
+      const auto tailSize = source.residentSize(stream.tail);
+      while (target < stream.tail &&
+             source.residentSize(target) - tailSize > budgetLeft)
+        target++;
+      budgetLeft -= source.residentSize(target) - tailSize;
+      if (target == current || stream.pending != INVALID_UINT32) continue;
+      if (target < current) {
+        const auto bytes = source.residentSize(target);
+        if (uploads != 0 && uploads + bytes > settings.uploadPerTick) continue;
+        uploads += bytes;
+      }
+      stream.pending = target;
+      changes.push_back({TStreamHolder(id), target, stream.source});
+    }
+    std::ranges::stable_partition(changes, [&](const StreamChange& change) {
+      return change.firstLevel >
+             streams[change.stream.internalHandle].resident;
+    });
+    return changes;
+  }
+
+  // Swaps in the texture of a finished change and returns the bindings that
+  // have to be updated. An empty texture means the upload failed
+  [[nodiscard]] std::vector<shader::BindingInfo> complete(
+      const TStreamHolder holder, const uint32_t firstLevel,
+      const TTextureHolder texture) {
+    std::lock_guard guard(mutex);
+    const auto found = streams.find(holder.internalHandle);
+    if (found == std::end(streams)) {
+      if (!(!texture)) retired.emplace_back(ticks, texture);
+      return {};
+    }
+    auto& stream = found->second;
+    stream.pending = INVALID_UINT32;
+    if (!texture) return {};
+    retired.emplace_back(ticks, stream.texture);
+    stream.texture = texture;
+    stream.resident = firstLevel;
+    auto bindings = stream.bindings;
+    for (auto& binding : bindings) binding.data.texture.texture = texture;
+    return bindings;
+  }
+
+  // Replaced textures that no frame in flight samples anymore
+  [[nodiscard]] std::vector<TTextureHolder> takeRetired() {
+    std::lock_guard guard(mutex);
+    std::vector<TTextureHolder> textures;
+    std::erase_if(retired, [&](const auto& entry) {
+      if (ticks - entry.first < settings.retireTicks) return false;
+      textures.push_back(entry.second);
+      return true;
+    });
+    return textures;
+  }
+};
+
+}  // namespace tge::graphics
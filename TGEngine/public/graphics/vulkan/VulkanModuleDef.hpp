@@ -12,14 +12,18 @@
 #define VULKAN_HPP_ENABLE_DYNAMIC_LOADER_TOOL 1
 #define VK_USE_PLATFORM_XLIB_KHR 1
 #endif
+#include <array>
 #include <chrono>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
 #include "../../../public/Module.hpp"
 #include "../../DataHolder.hpp"
 #include "../GameGraphicsModule.hpp"
+#include "../RingAllocator.hpp"
+#include "../TLSFAllocator.hpp"
 #include "VulkanShaderModule.hpp"
 #include "VulkanShaderPipe.hpp"
 #undef None
@@ -146,6 +150,143 @@ namespace tge::graphics {
         SampleCountFlagBits sampleCount = SampleCountFlagBits::e1;
         size_t mipmapCount = 1;
         std::string debugInfo;
+        ComponentMapping components{};
+        uint32_t layers = 1;
+        bool cubemap = false;
+    };
+
+    // Range of a memory block, allocations too large for a block get their own
+    // memory and an invalid block
+    struct MemoryAllocation {
+        DeviceMemory memory;
+        size_t offset = 0;
+        size_t size = 0;
+        uint32_t block = INVALID_UINT32;
+        uint32_t type = INVALID_UINT32;
+        TLSFAllocation range;
+        // Only set for host visible memory
+        char* mapped = nullptr;
+        MemoryCategory category = MemoryCategory::GEOMETRY;
+    };
+
+    // Buffers and images never share a block, so the buffer image granularity
+    // never has to be respected between neighbours. The category is the first
+    // one of the group sharing the block, see blockGroup
+    struct MemoryBlock {
+        DeviceMemory memory;
+        uint32_t type = INVALID_UINT32;
+        MemoryCategory category = MemoryCategory::GEOMETRY;
+        TLSFAllocator allocator;
+        char* mapped = nullptr;
+        // Being emptied by the defragmentation, no new allocations go into it
+        bool retiring = false;
+    };
+
+    struct MemoryStats {
+        size_t dedicated = 0;
+        size_t allocations = 0;
+        size_t usedBytes = 0;
+    };
+
+    using MemoryCategoryStats = std::array<MemoryStats, (size_t)MemoryCategory::COUNT>;
+
+    // Large device memory blocks all buffers and images are sub-allocated from,
+    // freed blocks keep their slot
+    struct MemoryPools {
+        std::vector<MemoryBlock> blocks;
+        MemoryCategoryStats stats;
+        // Device memory allocated from each heap, blocks count as a whole
+        std::vector<size_t> heapBytes;
+        size_t deviceBlockSize = (size_t)64 << 20;
+        size_t hostBlockSize = (size_t)16 << 20;
+        std::mutex mutex;
+    };
+
+    struct Readback {
+        CommandBuffer commandBuffer;
+        Fence fence;
+        size_t offset = INVALID_SIZE_T;
+        size_t size = 0;
+        Extent2D extent;
+        Format format = Format::eUndefined;
+        // Counts the releases of the slot, part of the handle
+        uint32_t generation = 0;
+    };
+
+    // Persistently mapped host memory all asynchronous readbacks copy into,
+    // the slots of released readbacks keep their command buffer and fence
+    struct ReadbackRing {
+        Buffer buffer;
+        MemoryAllocation memory;
+        bool coherent = true;
+        RingAllocator allocator;
+        CommandPool pool;
+        std::vector<Readback> readbacks;
+        std::vector<size_t> freeReadbacks;
+        // Copies of the presented image recorded into the next frame
+        std::vector<size_t> outputReadbacks;
+        // May be taken while a queue handle is held, never the other way round
+        std::mutex mutex;
+    };
+
+    // Persistently mapped host memory all uploads copy from, a region is
+    // released once the submission reading it finished
+    struct StagingRing {
+        Buffer buffer;
+        MemoryAllocation memory;
+        RingAllocator allocator;
+        std::mutex mutex;
+    };
+
+    // Part of the staging ring, or a dedicated buffer for uploads that do not
+    // fit into it
+    struct StagingRegion {
+        Buffer buffer;
+        size_t offset = 0;
+        char* mapped = nullptr;
+        // Start of the ring range, can be before offset for odd alignments
+        size_t ringOffset = INVALID_SIZE_T;
+        MemoryAllocation dedicated;
+    };
+
+    // Buffer changes of one frame, submitted to the render queue right before
+    // the frame, which waits on the semaphore instead of the CPU
+    struct TransferFrame {
+        CommandBuffer commandBuffer;
+        Semaphore semaphore;
+        Fence fence;
+        bool recording = false;
+        bool pending = false;
+        // Released once the fence signaled
+        std::vector<StagingRegion> staging;
+        std::vector<std::pair<Buffer, MemoryAllocation>> retiredBuffers;
+    };
+
+    struct TransferFrames {
+        CommandPool pool;
+        std::vector<TransferFrame> frames;
+        size_t current = 0;
+        std::mutex mutex;
+    };
+
+    // Transfer only queue family uploads are copied on, their resources are
+    // handed to the render family through queue family ownership transfers
+    struct UploadQueue {
+        QueueSync* sync = nullptr;
+        uint32_t family = INVALID_UINT32;
+        CommandPool pool;
+        CommandBuffer commandBuffer;
+        // Signaled by the copies, waited on by the acquiring submission
+        Semaphore semaphore;
+    };
+
+    // Everything one of the frames in flight records and signals into, reused
+    // once its fence signaled
+    struct FrameResources {
+        CommandBuffer commandBuffer;
+        Semaphore acquired;
+        Fence fence;
+        bool submitted = false;
     };
 
     struct GuiData {
@@ -171,7 +312,6 @@ namespace tge::graphics {
         CommandPool secondaryPool;
         CommandPool secondaryBufferPool;
         CommandPool guiPool;
-        std::vector<CommandBuffer> cmdbuffer;
         std::vector<CommandBuffer> noneRenderCmdbuffer;
         std::vector<char> needsRefresh;
 
@@ -180,25 +320,56 @@ namespace tge::graphics {
         uint32_t queueFamilyIndex;
         uint32_t queueIndex;
         uint32_t secondaryqueueIndex;
-        Semaphore waitSemaphore;
-        Semaphore signalSemaphore;
+        // The CPU records at most framesInFlight frames ahead of the GPU, set
+        // from the FeatureSet on init
+        std::vector<FrameResources> frames;
+        size_t framesInFlight = 2;
+        size_t currentFrame = 0;
+        // One per swapchain image, signaled by the frame rendering into it
+        std::vector<Semaphore> presentSemaphores;
+        std::vector<Fence> imagesInFlight;
         QueueSync* primarySync = nullptr;
         QueueSync* secondarySync = nullptr;
+        UploadQueue uploadQueue;
+        bool transferQueueEnabled = true;
         std::vector<ShaderModule> shaderModules;
         uint32_t memoryTypeHostVisibleCoherent;
         uint32_t memoryTypeDeviceLocal;
+        PhysicalDeviceMemoryProperties memoryProperties;
+        // All device local memory is host visible and coherent as well
+        bool unifiedMemory = false;
+        MemoryPools memoryPools;
+        bool memoryBudgetSupported = false;
+        // Memory pressure callbacks run once the usage crosses this part of
+        // the budget, at most every memoryPressureInterval ticks
+        float memoryPressureThreshold = 0.9f;
+        size_t memoryPressureInterval = 60;
+        size_t ticksSincePressure = INVALID_SIZE_T;
         vk::PhysicalDeviceLimits deviceLimits;
-        DataHolder<vk::Buffer, vk::DeviceMemory, size_t, size_t, size_t>
+        // Buffer, memory, size, offset of the range in the buffer, alignment and
+        // usage. Packed data shares its buffer and memory with the other ranges
+        DataHolder<vk::Buffer, MemoryAllocation, size_t, size_t, size_t, BufferUsageFlags>
             bufferDataHolder;
-
-        std::unordered_map<vk::DeviceMemory, size_t> memoryCounter;
+        // Held while buffers are uploaded to or moved
+        std::mutex bufferMoveMutex;
+        // Ranges still alive per packed buffer, the last one frees it
+        std::unordered_map<VkBuffer, size_t> packedBuffers;
+        std::mutex packedBuffersMutex;
+        // Device local buffer blocks used less than this are emptied into the
+        // other blocks, copying at most defragmentBytesPerFrame every
+        // defragmentInterval ticks
+        float defragmentThreshold = 0.25f;
+        size_t defragmentBytesPerFrame = (size_t)4 << 20;
+        size_t defragmentInterval = 30;
+        size_t ticksSinceDefragment = 0;
+        uint32_t defragmentBlock = INVALID_UINT32;
 
         DataHolder<vk::CommandBuffer, std::vector<RenderInfo>,
             std::shared_ptr<std::mutex>, std::vector<TDataHolder>,
             std::vector<TPipelineHolder>, RenderTarget>
             secondaryCommandBuffer;
 
-        DataHolder<vk::Image, vk::ImageView, vk::DeviceMemory, size_t,
+        DataHolder<vk::Image, vk::ImageView, MemoryAllocation, size_t,
             InternalImageInfo>
             textureImageHolder;
 
@@ -224,10 +395,19 @@ namespace tge::graphics {
 
         GuiData gui;
 
+        ReadbackRing readbackRing;
+        size_t readbackRingSize = (size_t)32 << 20;
+        bool outputReadable = false;
+
+        StagingRing stagingRing;
+        size_t stagingRingSize = (size_t)32 << 20;
+
+        TransferFrames transferFrames;
+        size_t transferFrameCount = 2;
+
 #ifdef DEBUG
         DebugUtilsMessengerEXT debugMessenger;
         bool debugEnabled = false;
-        std::unordered_map<vk::DeviceMemory, std::string> memoryDebugTags;
 #endif
         detail::DispatchLoaderDynamic dynamicLoader;
 
@@ -272,6 +452,10 @@ namespace tge::graphics {
             const BufferInfo* bufferInfo,
             const std::string& debugTag = "Unknown") override;
 
+        std::vector<TDataHolder> pushPackedData(const size_t dataCount,
+            const BufferInfo* bufferInfo,
+            const std::string& debugTag = "Unknown") override;
+
         void changeData(const size_t sizes, const BufferChange* changeInfos) override;
 
         TRenderHolder pushRender(const size_t renderInfoCount,
@@ -292,12 +476,36 @@ namespace tge::graphics {
 
         size_t getAligned(const DataType type) const override;
 
+        bool isTextureFormatSupported(const size_t format,
+            const bool blit = true) const override;
+
         glm::vec2 getRenderExtent() const override;
 
         virtual std::pair<std::vector<char>, TDataHolder> getImageData(
             const TTextureHolder imageId,
             const TDataHolder cache = TDataHolder()) override;
 
+        TReadbackHolder readImageAsync(const TTextureHolder imageId) override;
+
+        TReadbackHolder readOutputAsync() override;
+
+        TextureInfo getReadbackInfo(const TReadbackHolder readback) override;
+
+        bool isReadbackReady(const TReadbackHolder readback) override;
+
+        std::span<const char> getReadbackData(
+            const TReadbackHolder readback) override;
+
+        void releaseReadback(const TReadbackHolder readback) override;
+
+        [[nodiscard]] MemoryCategoryStats getMemoryStats();
+
+        MemoryBudget getMemoryBudget() override;
+
+        size_t getFramesInFlight() const override { return framesInFlight; }
+
+        std::unique_lock<std::mutex> lockFrames() override;
+
         void initDebugGUI() override;
     };
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <mutex>
 #include <thread>
 #include <vulkan/vulkan.hpp>
@@ -26,9 +27,18 @@ class VulkanShaderModule : public tge::shader::ShaderAPI {
   std::vector<vk::DescriptorSet> descSets;
   std::vector<tge::shader::VulkanShaderPipe*> shaderPipes;
 
+  // Sets shared through shareBindings appear once per binding holder, the
+  // last columns are the layout and the dynamic offsets bound with the set
   tge::DataHolder<vk::DescriptorSet, vk::DescriptorSetLayout,
-                  vk::PipelineLayout, size_t, size_t>
+                  vk::PipelineLayout, size_t, size_t, size_t,
+                  std::vector<uint32_t>>
       bindingHolder;
+  // Per layout the binding of every dynamic offset in the order they are bound
+  std::vector<std::vector<uint32_t>> dynamicBindings;
+  // Last buffer bound to each set and binding, written again once the
+  // buffer moved
+  std::map<std::pair<VkDescriptorSet, size_t>, BindingInfo> bufferBindings;
+  std::mutex bufferBindingsMutex;
 
   DescriptorSetLayout defaultDescLayout;
   PipelineLayout defaultLayout;
@@ -49,8 +59,22 @@ class VulkanShaderModule : public tge::shader::ShaderAPI {
   void changeInputBindings(const ShaderPipe pipe, const size_t bindingID,
                            const size_t buffer) override;
 
+  std::vector<TBindingHolder> shareBindings(const TBindingHolder bindingSet,
+                                            const size_t count) override;
+
+  void setDynamicOffset(const TBindingHolder bindingSet, const size_t binding,
+                        const uint32_t offset) override;
+
   void bindData(const BindingInfo* info, const size_t count) override;
 
+  // Writes the bindings of the buffers again after they were replaced, no
+  // frame may use the sets meanwhile
+  void rebindBuffers(const std::span<const graphics::TDataHolder> buffers);
+
+  // Drops the bindings remembered for removed buffers, their holders may be
+  // handed out again
+  void forgetBuffers(const std::span<const graphics::TDataHolder> buffers);
+
   void addToRender(const std::span<const TBindingHolder> bindings,
                    void* customData) override;
 
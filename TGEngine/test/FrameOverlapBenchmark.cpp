@@ -0,0 +1,89 @@
+// Renders copies of a model that all move every frame and prints the frame
+// times, so their buffer changes go through the transfer frames. With one
+// frame in flight the CPU waits for every frame before recording the next,
+// comparing it with more frames shows how much CPU and GPU work overlaps,
+// usage: TGEngineFrameBenchmark [frames in flight] [frames] [model] [copies]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../public/TGEngine.hpp"
+#include "../public/Util.hpp"
+
+namespace fs = std::filesystem;
+using namespace tge;
+
+// Ticks after the graphics modules, so it measures whole frames
+class FrameTimer : public main::Module {
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point last;
+  size_t frame = 0;
+  double total = 0.0;
+  double slowest = 0.0;
+
+ public:
+  std::vector<graphics::TNodeHolder> roots;
+  size_t framesInFlight = 2;
+  size_t warmup = 100;
+  size_t frames = 1000;
+
+  void tick(double deltatime) override {
+    const auto ggm = main::getGameGraphicsModule();
+    for (size_t i = 0; i < roots.size(); i++) {
+      graphics::NodeTransform transform;
+      transform.translation.x = std::sin(frame * 0.01f + i);
+      transform.translation.y = (float)(i % 16) - 8.0f;
+      ggm->updateTransform(roots[i], transform);
+    }
+    const auto now = Clock::now();
+    if (frame > warmup) {
+      const std::chrono::duration<double> time = now - last;
+      total += time.count();
+      slowest = std::max(slowest, time.count());
+    }
+    last = now;
+    if (++frame > warmup + frames) util::exitRequest = true;
+  }
+
+  // The engine deletes its modules once it stops, so the results are
+  // printed before
+  void destroy() override {
+    if (frame <= warmup + 1) return;
+    const auto measured = frame - warmup - 1;
+    std::cout << framesInFlight << " frames in flight, " << roots.size()
+              << " moving models: " << total / measured * 1000.0
+              << "ms average, " << slowest * 1000.0 << "ms slowest over "
+              << measured << " frames" << std::endl;
+  }
+};
+
+int main(int argc, char** argv) {
+  graphics::FeatureSet features;
+  features.framesInFlight = argc > 1 ? (uint32_t)std::stoul(argv[1]) : 2;
+  const auto timer = new FrameTimer();
+  timer->framesInFlight = features.framesInFlight;
+  timer->frames = argc > 2 ? std::stoul(argv[2]) : 1000;
+  const fs::path model = argc > 3 ? argv[3] : "assets/Triangle.gltf";
+  const size_t copies = argc > 4 ? std::stoul(argv[4]) : 256;
+
+  main::lateModules.push_back(timer);
+  if (main::init(features) != main::Error::NONE) {
+    std::cerr << "Couldn't initialize the engine!" << std::endl;
+    return -1;
+  }
+  const auto ggm = main::getGameGraphicsModule();
+  for (size_t i = 0; i < copies; i++) {
+    const auto nodes = ggm->loadModel(model);
+    if (nodes.empty()) {
+      std::cerr << "Couldn't load " << model << "!" << std::endl;
+      return -1;
+    }
+    timer->roots.push_back(nodes[0]);
+  }
+  return main::start() == main::Error::NONE ? 0 : -1;
+}
@@ -3,7 +3,24 @@
 #include <plog/Formatters/TxtFormatter.h>
 #include <plog/Init.h>
 
+#include <random>
+
 #include "../public/DataHolder.hpp"
+#include "../public/WorkerPool.hpp"
+#include "../public/graphics/Animation.hpp"
+#include "../public/graphics/AssetResolver.hpp"
+#include "../public/graphics/BlockCompression.hpp"
+#include "../public/graphics/ContentCache.hpp"
+#include "../public/graphics/FrameCapture.hpp"
+#include "../public/graphics/MipGeneration.hpp"
+#include "../public/graphics/RingAllocator.hpp"
+#include "../public/graphics/TLSFAllocator.hpp"
+#include "../public/graphics/TextureAtlas.hpp"
+#include "../public/graphics/TextureConversion.hpp"
+#include "../public/graphics/TextureDiskCache.hpp"
+#include "../public/graphics/TextureStreaming.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "../public/headerlibs/stb_image.h"
 
 using namespace tge;
 
@@ -236,4 +253,694 @@ TEST(DataHolderTest, BasicDataHolderTests) {
   holder.change<1>(testholder2) = 2000;
 
   EXPECT_EQ(holder.get<1>(testholder2), 2000);
-}
\ No newline at end of file
+}
+
+TEST(ContentCacheTest, ReferenceCounting) {
+  graphics::ContentCache<graphics::TDataHolder> cache;
+  EXPECT_TRUE(!cache.acquire(1));
+
+  cache.insert(1, graphics::TDataHolder(10));
+  cache.insert(2, graphics::TDataHolder(20));
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.references(graphics::TDataHolder(10)), 1);
+
+  EXPECT_EQ(cache.acquire(1), graphics::TDataHolder(10));
+  EXPECT_EQ(cache.references(graphics::TDataHolder(10)), 2);
+
+  const std::vector<graphics::TDataHolder> toRelease = {
+      graphics::TDataHolder(10), graphics::TDataHolder(20),
+      graphics::TDataHolder(30)};
+  const auto freed = cache.release(toRelease);
+  EXPECT_EQ(freed.size(), 2);
+  EXPECT_EQ(freed[0], graphics::TDataHolder(20));
+  EXPECT_EQ(freed[1], graphics::TDataHolder(30));
+  EXPECT_EQ(cache.references(graphics::TDataHolder(10)), 1);
+  EXPECT_TRUE(!cache.acquire(2));
+
+  const std::vector<graphics::TDataHolder> lastRelease = {
+      graphics::TDataHolder(10)};
+  const auto freedLast = cache.release(lastRelease);
+  EXPECT_EQ(freedLast.size(), 1);
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(WorkerPoolTest, ParallelFor) {
+  util::WorkerPool pool(3);
+  std::vector<int> values(1000, 0);
+  pool.parallelFor(values.size(), 16, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) values[i] += (int)i;
+  });
+  for (size_t i = 0; i < values.size(); i++) EXPECT_EQ(values[i], (int)i);
+
+  auto future = pool.submit([] { return 42; });
+  EXPECT_EQ(future.get(), 42);
+
+  EXPECT_THROW(pool.parallelFor(100, 1,
+                                [](size_t begin, size_t) {
+                                  if (begin == 50)
+                                    throw std::runtime_error("test");
+                                }),
+               std::runtime_error);
+}
+
+TEST(AnimationTest, SampleKeyframes) {
+  graphics::AnimationClip clip;
+  clip.channels.push_back(
+      {0, graphics::AnimationPath::TRANSLATION, false, 0, 3});
+  clip.addKey(0.0f, glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
+  clip.addKey(1.0f, glm::vec4(2.0f, 0.0f, 0.0f, 0.0f));
+  clip.addKey(2.0f, glm::vec4(2.0f, 4.0f, 0.0f, 0.0f));
+  clip.channels.push_back({0, graphics::AnimationPath::SCALE, true, 3, 2});
+  clip.addKey(0.0f, glm::vec4(1.0f, 1.0f, 1.0f, 0.0f));
+  clip.addKey(1.0f, glm::vec4(3.0f, 3.0f, 3.0f, 0.0f));
+  // Opposite hemispheres, the second key is flipped before interpolating
+  clip.channels.push_back({0, graphics::AnimationPath::ROTATION, false, 5, 2});
+  clip.addKey(0.0f, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+  clip.addKey(1.0f, glm::vec4(0.0f, 0.0f, 0.0f, -1.0f));
+  clip.duration = 2.0f;
+  ASSERT_EQ(clip.times.size(), 7);
+  ASSERT_EQ(clip.values.size(), 7);
+
+  const auto& translation = clip.channels[0];
+  EXPECT_FLOAT_EQ(graphics::sampleChannel(clip, translation, -1.0f).x, 0.0f);
+  EXPECT_FLOAT_EQ(graphics::sampleChannel(clip, translation, 0.5f).x, 1.0f);
+  const auto between = graphics::sampleChannel(clip, translation, 1.5f);
+  EXPECT_FLOAT_EQ(between.x, 2.0f);
+  EXPECT_FLOAT_EQ(between.y, 2.0f);
+  EXPECT_FLOAT_EQ(graphics::sampleChannel(clip, translation, 5.0f).y, 4.0f);
+
+  const auto& scale = clip.channels[1];
+  EXPECT_FLOAT_EQ(graphics::sampleChannel(clip, scale, 0.9f).x, 1.0f);
+  EXPECT_FLOAT_EQ(graphics::sampleChannel(clip, scale, 1.0f).x, 3.0f);
+
+  const auto rotation =
+      graphics::sampleChannel(clip, clip.channels[2], 0.5f);
+  EXPECT_FLOAT_EQ(rotation.w, 1.0f);
+}
+
+TEST(AnimationTest, LoopAndBlendClips) {
+  DataHolder<graphics::NodeTransform, char> nodes;
+  graphics::TNodeHolder node;
+  {
+    auto allocation = nodes.allocate(1);
+    auto [transforms, statuses] = allocation.iterator;
+    transforms->translation = glm::vec3(0.0f, 0.0f, 0.0f);
+    *statuses = 0;
+    node = allocation.generateOutputArray<graphics::TNodeHolder>(1)[0];
+  }
+  const graphics::AnimationNodes view{nodes.mutex, nodes.translationTable,
+                                      std::get<0>(nodes.internalValues),
+                                      std::get<1>(nodes.internalValues)};
+  const auto translation = [&] { return nodes.get<0>(node).translation; };
+
+  auto walk = std::make_shared<graphics::AnimationClip>();
+  walk->channels.push_back(
+      {0, graphics::AnimationPath::TRANSLATION, false, 0, 2});
+  walk->addKey(0.0f, glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
+  walk->addKey(2.0f, glm::vec4(4.0f, 0.0f, 0.0f, 0.0f));
+  walk->duration = 2.0f;
+  auto lift = std::make_shared<graphics::AnimationClip>();
+  lift->channels.push_back(
+      {0, graphics::AnimationPath::TRANSLATION, false, 0, 1});
+  lift->addKey(0.0f, glm::vec4(0.0f, 0.0f, 8.0f, 0.0f));
+
+  util::WorkerPool pool(2);
+  graphics::AnimationSystem system;
+  graphics::AnimationInfo info;
+  info.clip = walk;
+  info.targets = {node};
+  const auto walking = system.play(std::span(&info, 1))[0];
+
+  // Loops back into the clip
+  system.update(2.5, view, pool);
+  EXPECT_NEAR(system.getTime(walking), 0.5f, 1e-5f);
+  EXPECT_NEAR(translation().x, 1.0f, 1e-5f);
+  EXPECT_EQ(nodes.get<1>(node), 1);
+
+  // Full weights are averaged
+  info.clip = lift;
+  const auto lifting = system.play(std::span(&info, 1))[0];
+  system.update(0.5, view, pool);
+  EXPECT_NEAR(translation().x, 1.0f, 1e-5f);
+  EXPECT_NEAR(translation().z, 4.0f, 1e-5f);
+
+  // Partial weights blend with the rest pose, walk samples 3 at 1.5
+  system.setWeight(lifting, 0.0f);
+  system.setWeight(walking, 0.5f);
+  system.update(0.5, view, pool);
+  EXPECT_NEAR(translation().x, 1.5f, 1e-5f);
+  EXPECT_NEAR(translation().z, 0.0f, 1e-5f);
+
+  // Clips that don't loop stop at their end
+  system.stop(std::span(&lifting, 1));
+  graphics::AnimationInfo once;
+  once.clip = walk;
+  once.targets = {node};
+  once.loop = false;
+  system.stop(std::span(&walking, 1));
+  const auto onceHolder = system.play(std::span(&once, 1))[0];
+  system.update(5.0, view, pool);
+  EXPECT_FLOAT_EQ(system.getTime(onceHolder), 2.0f);
+  EXPECT_NEAR(translation().x, 4.0f, 1e-5f);
+}
+
+TEST(AssetResolverTest, ChainCacheAndStatistics) {
+  util::WorkerPool pool(2);
+  graphics::AssetResolver resolver(pool, 16);
+  std::atomic_size_t calls = 0;
+  resolver.add(
+      [&](const std::string& name) {
+        calls++;
+        if (name.starts_with("first")) return std::vector<char>(4, 'a');
+        return std::vector<char>();
+      },
+      "first");
+  resolver.add(
+      [](const std::string& name) {
+        if (name == "missing") return std::vector<char>();
+        return std::vector<char>(name.begin(), name.end());
+      },
+      "second");
+
+  const std::vector<std::string> names = {"first1", "other", "missing",
+                                          "first1"};
+  const auto blobs = resolver.resolve(names);
+  ASSERT_EQ(blobs.size(), 4);
+  EXPECT_EQ(blobs[0]->size(), 4);
+  EXPECT_EQ(std::string(blobs[1]->begin(), blobs[1]->end()), "other");
+  EXPECT_FALSE(blobs[2]);
+  EXPECT_EQ(blobs[3], blobs[0]);
+  EXPECT_EQ(calls, 3);
+
+  const auto statistics = resolver.statistics();
+  ASSERT_EQ(statistics.size(), 2);
+  EXPECT_EQ(statistics[0].name, "first");
+  EXPECT_EQ(statistics[0].hits, 1);
+  EXPECT_EQ(statistics[1].requests, 2);
+  EXPECT_EQ(statistics[1].hits, 1);
+
+  resolver.prefetch(std::span(names).subspan(1, 1));
+  EXPECT_EQ(resolver.resolveAsync("other").get(), blobs[1]);
+  EXPECT_EQ(resolver.cacheStats().bytes, 9);
+
+  resolver.setCacheCapacity(4);
+  EXPECT_LE(resolver.cacheStats().bytes, 4);
+
+  resolver.clearCache();
+  EXPECT_EQ(resolver.cacheStats().entries, 0);
+  EXPECT_NE(resolver.resolve("first1"), blobs[0]);
+}
+
+TEST(TextureConversionTest, ExpandToRGBA) {
+  constexpr size_t pixels = 11;
+  std::vector<uint8_t> rgb(pixels * 3);
+  for (size_t i = 0; i < rgb.size(); i++) rgb[i] = (uint8_t)i;
+  std::vector<uint8_t> rgba(pixels * 4);
+  graphics::expandToRGBA(rgb.data(), pixels, 3, rgba.data());
+  for (size_t i = 0; i < pixels; i++) {
+    EXPECT_EQ(rgba[i * 4], rgb[i * 3]);
+    EXPECT_EQ(rgba[i * 4 + 1], rgb[i * 3 + 1]);
+    EXPECT_EQ(rgba[i * 4 + 2], rgb[i * 3 + 2]);
+    EXPECT_EQ(rgba[i * 4 + 3], 255);
+  }
+
+  const std::vector<uint8_t> grayAlpha = {10, 20, 30, 40};
+  graphics::expandToRGBA(grayAlpha.data(), 2, 2, rgba.data());
+  EXPECT_EQ(std::vector<uint8_t>(rgba.begin(), rgba.begin() + 8),
+            std::vector<uint8_t>({10, 10, 10, 20, 30, 30, 30, 40}));
+
+  const std::vector<uint16_t> gray = {1000, 65535};
+  std::vector<uint16_t> wide(8);
+  graphics::expandToRGBA(gray.data(), 2, 1, wide.data());
+  EXPECT_EQ(wide, std::vector<uint16_t>({1000, 1000, 1000, 65535, 65535,
+                                         65535, 65535, 65535}));
+}
+
+TEST(TextureConversionTest, DispatchMatchesScalar) {
+  std::mt19937 random(7);
+  std::vector<uint8_t> rgb(67 * 3);
+  for (auto& value : rgb) value = (uint8_t)random();
+  for (size_t pixels = 0; pixels <= 67; pixels++) {
+    std::vector<uint8_t> expected(pixels * 4);
+    std::vector<uint8_t> dispatched(pixels * 4);
+    graphics::expandToRGBAScalar(rgb.data(), pixels, 3, expected.data());
+    graphics::expandToRGBA(rgb.data(), pixels, 3, dispatched.data());
+    EXPECT_EQ(dispatched, expected) << pixels << " pixels";
+#ifdef TGE_TEXTURE_SSSE3
+    if (!graphics::hasSSSE3()) continue;
+    std::vector<uint8_t> simd(pixels * 4);
+    const auto converted =
+        graphics::expandRGB8SSSE3(rgb.data(), pixels, simd.data());
+    EXPECT_EQ(converted, pixels >= 6 ? (pixels - 2) / 4 * 4 : 0);
+    EXPECT_TRUE(std::equal(simd.begin(), simd.begin() + converted * 4,
+                           expected.begin()))
+        << pixels << " pixels";
+#endif
+  }
+}
+
+TEST(BlockCompressionTest, RoundTrip) {
+  constexpr uint32_t width = 16, height = 12;
+  std::vector<uint8_t> rgba(width * height * 4);
+  for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t x = 0; x < width; x++) {
+      const auto texel = rgba.data() + (y * width + x) * 4;
+      const auto t = x + y;
+      texel[0] = (uint8_t)(t * 9);
+      texel[1] = (uint8_t)(40 + t * 5);
+      texel[2] = (uint8_t)(255 - t * 7);
+      texel[3] = (uint8_t)(128 + t * 4);
+    }
+  }
+
+  for (const auto format : {graphics::BlockFormat::BC1,
+                            graphics::BlockFormat::BC3,
+                            graphics::BlockFormat::BC5,
+                            graphics::BlockFormat::BC7}) {
+    const auto texture =
+        graphics::compressTexture(rgba.data(), width, height, format);
+    ASSERT_EQ(texture.mipLevels, 5);
+    // 4x3 + 2x2 + 1 + 1 + 1 blocks
+    ASSERT_EQ(texture.data.size(), 19 * graphics::blockSize(format));
+
+    const size_t channels = format == graphics::BlockFormat::BC5 ? 2
+                            : format == graphics::BlockFormat::BC1 ? 3
+                                                                   : 4;
+    double squaredError = 0.0;
+    std::array<uint8_t, 64> decoded;
+    for (uint32_t block = 0; block < 12; block++) {
+      ASSERT_TRUE(graphics::decodeBlock(
+          format, texture.data.data() + block * graphics::blockSize(format),
+          decoded.data()));
+      const auto blockX = (block % 4) * 4, blockY = (block / 4) * 4;
+      for (uint32_t i = 0; i < 16; i++) {
+        const auto texel =
+            rgba.data() + ((blockY + i / 4) * width + blockX + i % 4) * 4;
+        for (size_t c = 0; c < channels; c++) {
+          const double difference = decoded[i * 4 + c] - texel[c];
+          squaredError += difference * difference;
+        }
+      }
+    }
+    const auto meanError = squaredError / (width * height * channels);
+    const auto psnr = 10.0 * std::log10(255.0 * 255.0 / meanError);
+    EXPECT_GT(psnr, 32.0) << (int)format;
+  }
+
+  const std::array<uint8_t, 4> solid = {200, 100, 50, 255};
+  std::vector<uint8_t> solidImage(16 * 4);
+  for (size_t i = 0; i < 16; i++)
+    std::copy(solid.begin(), solid.end(), solidImage.begin() + i * 4);
+  const auto texture = graphics::compressTexture(
+      solidImage.data(), 4, 4, graphics::BlockFormat::BC7, {1});
+  std::array<uint8_t, 64> decoded;
+  ASSERT_TRUE(graphics::decodeBlock(graphics::BlockFormat::BC7,
+                                    texture.data.data(), decoded.data()));
+  for (size_t c = 0; c < 4; c++) EXPECT_NEAR(decoded[c], solid[c], 1);
+
+  const auto file = graphics::toDDS(graphics::compressTexture(
+      rgba.data(), width, height, graphics::BlockFormat::BC7));
+  ddspp::Descriptor descriptor;
+  ASSERT_EQ(ddspp::decode_header((unsigned char*)file.data(), descriptor),
+            ddspp::Success);
+  EXPECT_EQ(descriptor.format, ddspp::BC7_UNORM);
+  EXPECT_EQ(descriptor.numMips, 5);
+  EXPECT_EQ(file.size() - descriptor.headerSize, 19 * 16);
+}
+
+TEST(MipGenerationTest, GammaCorrectChain) {
+  // A black and white checker averages to middle gray in linear space
+  std::vector<uint8_t> checker(8 * 6 * 4);
+  for (size_t i = 0; i < 8 * 6; i++) {
+    const auto value = ((i % 8) + (i / 8)) % 2 == 0 ? 255 : 0;
+    std::fill_n(checker.begin() + i * 4, 3, (uint8_t)value);
+    checker[i * 4 + 3] = (uint8_t)value;
+  }
+  const auto chain = graphics::generateMipChain(checker.data(), 8, 6, 4);
+  ASSERT_EQ(chain.offsets.size(), 4);
+  EXPECT_EQ(chain.offsets[1], 8 * 6 * 4);
+  EXPECT_EQ(chain.offsets[2], chain.offsets[1] + 4 * 3 * 4);
+  EXPECT_EQ(chain.offsets[3], chain.offsets[2] + 2 * 1 * 4);
+  EXPECT_EQ(chain.data.size(), chain.offsets[3] + 4);
+  const auto level1 = chain.data.data() + chain.offsets[1];
+  EXPECT_NEAR(level1[0], 188, 1);
+  EXPECT_NEAR(level1[3], 128, 1);
+
+  const auto linear = graphics::generateMipChain(
+      checker.data(), 8, 6, 4, {2, graphics::MipFilter::BOX, false});
+  ASSERT_EQ(linear.offsets.size(), 2);
+  EXPECT_NEAR(linear.data[linear.offsets[1]], 128, 1);
+
+  const auto kaiser = graphics::generateMipChain(
+      checker.data(), 8, 6, 4, {UINT32_MAX, graphics::MipFilter::KAISER});
+  ASSERT_EQ(kaiser.data.size(), chain.data.size());
+  EXPECT_NEAR(kaiser.data[kaiser.offsets[1]], 188, 2);
+
+  const std::vector<uint8_t> gray = {10, 200, 30, 90};
+  const auto grayChain = graphics::generateMipChain(gray.data(), 2, 2, 1);
+  ASSERT_EQ(grayChain.data.size(), 5);
+  EXPECT_GT(grayChain.data[4], (10 + 200 + 30 + 90) / 4);
+}
+
+TEST(TextureStreamingTest, ResidencyUnderBudget) {
+  using namespace tge::graphics;
+  EXPECT_EQ(levelOffsets(8, 4, 4, 1, 1, 4),
+            (std::vector<size_t>{0, 128, 160, 168, 172}));
+  EXPECT_EQ(levelOffsets(8, 8, 2, 4, 4, 16),
+            (std::vector<size_t>{0, 64, 80}));
+  EXPECT_EQ(desiredLevel(1024, 512, 11, 256.0f), 2);
+  EXPECT_EQ(desiredLevel(1024, 512, 11, 2000.0f), 0);
+  EXPECT_EQ(desiredLevel(1024, 512, 11, 0.0f), 10);
+
+  const auto makeSource = [] {
+    auto source = std::make_shared<StreamSource>();
+    source->width = source->height = 64;
+    source->offsets = levelOffsets(64, 64, 7, 1, 1, 4);
+    source->data.resize(source->offsets.back());
+    return source;
+  };
+  const auto full = makeSource()->residentSize(0);
+
+  TextureStreamer streamer;
+  streamer.settings.tailSize = 16;
+  streamer.settings.keepTicks = 1;
+  const auto tail = makeSource()->residentSize(2);
+  streamer.settings.budget = full + tail;
+  const auto first = streamer.add(makeSource(), TTextureHolder(1));
+  const auto second = streamer.add(makeSource(), TTextureHolder(2));
+  ASSERT_FALSE(!first);
+  EXPECT_EQ(streamer.getResidentLevel(first), 2);
+  EXPECT_EQ(streamer.residentBytes(), 2 * tail);
+
+  shader::BindingInfo binding;
+  binding.bindingSet = shader::TBindingHolder(7);
+  binding.binding = 1;
+  binding.type = shader::BindingType::Texture;
+  EXPECT_EQ(streamer.bind(first, binding), TTextureHolder(1));
+
+  // Only the closer texture fits into the budget
+  streamer.request(first, 64.0f);
+  streamer.request(second, 32.0f);
+  auto changes = streamer.plan();
+  ASSERT_EQ(changes.size(), 1);
+  EXPECT_EQ(changes[0].stream, first);
+  EXPECT_EQ(changes[0].firstLevel, 0);
+  EXPECT_TRUE(streamer.plan().empty());  // already in flight
+
+  const auto bindings = streamer.complete(first, 0, TTextureHolder(3));
+  ASSERT_EQ(bindings.size(), 1);
+  EXPECT_EQ(bindings[0].data.texture.texture, TTextureHolder(3));
+  EXPECT_EQ(streamer.getTexture(first), TTextureHolder(3));
+  EXPECT_EQ(streamer.residentBytes(), full + tail);
+  EXPECT_TRUE(streamer.takeRetired().empty());
+
+  // Once the first one is no longer requested it is evicted for the second
+  streamer.request(second, 32.0f);
+  changes = streamer.plan();
+  ASSERT_EQ(changes.size(), 2);
+  EXPECT_EQ(changes[0].stream, first);
+  EXPECT_EQ(changes[0].firstLevel, 2);
+  EXPECT_EQ(changes[1].stream, second);
+  EXPECT_EQ(changes[1].firstLevel, 1);
+  EXPECT_TRUE(streamer.takeRetired().empty());  // may still be sampled
+
+  // Retired textures wait for as many ticks as frames are in flight
+  streamer.settings.retireTicks = 3;
+  streamer.remove(std::vector{first});
+  EXPECT_TRUE(streamer.complete(first, 2, TTextureHolder(4)).empty());
+  (void)streamer.plan();
+  (void)streamer.plan();
+  EXPECT_EQ(streamer.takeRetired(), std::vector{TTextureHolder(1)});
+  (void)streamer.plan();
+  EXPECT_EQ(streamer.takeRetired().size(), 2);
+}
+
+TEST(TextureStreamingTest, EvictUnderMemoryPressure) {
+  using namespace tge::graphics;
+  auto source = std::make_shared<StreamSource>();
+  source->width = source->height = 64;
+  source->offsets = levelOffsets(64, 64, 7, 1, 1, 4);
+  source->data.resize(source->offsets.back());
+
+  TextureStreamer streamer;
+  streamer.settings.tailSize = 16;
+  const auto stream = streamer.add(source, TTextureHolder(1));
+  streamer.request(stream, 64.0f);
+  auto changes = streamer.plan();
+  ASSERT_EQ(changes.size(), 1);
+  (void)streamer.complete(stream, 0, TTextureHolder(2));
+  EXPECT_EQ(streamer.residentBytes(), source->residentSize(0));
+
+  // Freeing a byte drops the largest level even though it is still requested
+  const auto budget = streamer.settings.budget;
+  streamer.evict(1);
+  EXPECT_EQ(streamer.settings.budget, budget);
+  EXPECT_EQ(streamer.currentBudget(), source->residentSize(0) - 1);
+  streamer.request(stream, 64.0f);
+  changes = streamer.plan();
+  ASSERT_EQ(changes.size(), 1);
+  EXPECT_EQ(changes[0].firstLevel, 1);
+  (void)streamer.complete(stream, 1, TTextureHolder(3));
+
+  // The tail always stays
+  streamer.evict(source->residentSize(0) * 2);
+  EXPECT_EQ(streamer.currentBudget(), 0);
+
+  // Headroom raises the cap step by step until the budget is reached again
+  streamer.relieve(source->residentSize(0));
+  EXPECT_EQ(streamer.currentBudget(), source->residentSize(0));
+  streamer.request(stream, 64.0f);
+  changes = streamer.plan();
+  ASSERT_EQ(changes.size(), 1);
+  EXPECT_EQ(changes[0].firstLevel, 0);
+  streamer.relieve(budget);
+  EXPECT_EQ(streamer.currentBudget(), budget);
+  EXPECT_EQ(streamer.settings.budget, budget);
+}
+
+TEST(TextureStreamingTest, StreamWidePng) {
+  using namespace tge::graphics;
+  // 4x2 rgb png with 16 bits per channel
+  constexpr std::array<stbi_uc, 116> png = {
+      0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D,
+      0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x02,
+      0x10, 0x02, 0x00, 0x00, 0x00, 0xA0, 0x5A, 0x36, 0x77, 0x00, 0x00, 0x00,
+      0x3B, 0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0x63, 0x60, 0x60, 0x60, 0x7E,
+      0xC9, 0x7E, 0x89, 0x7F, 0xA1, 0x70, 0x97, 0x78, 0xB1, 0xBC, 0x93, 0xB2,
+      0xB6, 0xBA, 0x88, 0xDE, 0x63, 0xA3, 0x33, 0x66, 0x5B, 0x19, 0xEC, 0x1A,
+      0x9C, 0x32, 0xDD, 0x82, 0xFC, 0x14, 0x83, 0xB8, 0x42, 0x3F, 0xC7, 0x1E,
+      0x4A, 0x5C, 0x9D, 0x3A, 0x25, 0x37, 0xB9, 0xD0, 0xA7, 0xD4, 0x14, 0x00,
+      0x7D, 0x9D, 0x10, 0xF0, 0x27, 0x14, 0x6D, 0x3A, 0x00, 0x00, 0x00, 0x00,
+      0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82};
+  ASSERT_TRUE(stbi_is_16_bit_from_memory(png.data(), (int)png.size()));
+  int width = 0, height = 0, channel = 0;
+  const auto texels = stbi_load_16_from_memory(png.data(), (int)png.size(),
+                                               &width, &height, &channel, 0);
+  ASSERT_NE(texels, nullptr);
+  ASSERT_EQ(channel, 3);
+  const auto size = (size_t)width * height * channel * sizeof(uint16_t);
+  const std::span bytes((const uint8_t*)texels, size);
+
+  // Every texel takes two bytes per channel, the whole image is streamed
+  const auto source =
+      makeStreamSource(bytes, width, height, 1, 1, 1, channel * 2);
+  ASSERT_FALSE(!source);
+  EXPECT_EQ(source->residentSize(0), size);
+  EXPECT_TRUE(std::ranges::equal(source->data, bytes));
+  EXPECT_EQ(makeStreamSource(bytes.first(size - 1), width, height, 1, 1, 1,
+                             channel * 2),
+            nullptr);
+  stbi_image_free(texels);
+}
+
+TEST(TextureAtlasTest, PackWithoutOverlap) {
+  using namespace tge::graphics;
+  std::vector<std::array<uint32_t, 2>> sizes;
+  for (uint32_t i = 0; i < 200; i++)
+    sizes.push_back({8 + (i * 37) % 57, 8 + (i * 13) % 41});
+  sizes.push_back({300, 16});  // too large, gets its own image
+  AtlasSettings settings;
+  settings.pageSize = 256;
+  const auto layout = packAtlas(sizes, settings);
+  ASSERT_EQ(layout.rects.size(), sizes.size());
+  EXPECT_EQ(layout.rects.back().page, INVALID_UINT32);
+  // Padded sizes are rounded up to the padding grid
+  const auto padded = [](const uint32_t size) { return (size + 11) / 4 * 4; };
+  size_t area = 0;
+  for (size_t i = 0; i + 1 < sizes.size(); i++)
+    area += (size_t)padded(sizes[i][0]) * padded(sizes[i][1]);
+  size_t pageArea = 0;
+  for (const auto& [width, height] : layout.pages)
+    pageArea += (size_t)width * height;
+  EXPECT_LT(pageArea, area * 5 / 4);
+
+  const auto padding = settings.padding;
+  for (size_t a = 0; a + 1 < sizes.size(); a++) {
+    const auto& rect = layout.rects[a];
+    ASSERT_LT(rect.page, layout.pages.size());
+    EXPECT_EQ(rect.x % padding, 0);
+    EXPECT_EQ(rect.y % padding, 0);
+    EXPECT_LE(rect.x + sizes[a][0] + padding, layout.pages[rect.page][0]);
+    EXPECT_LE(rect.y + sizes[a][1] + padding, layout.pages[rect.page][1]);
+    for (size_t b = a + 1; b + 1 < sizes.size(); b++) {
+      const auto& other = layout.rects[b];
+      if (other.page != rect.page) continue;
+      const bool apart = rect.x + sizes[a][0] + padding <= other.x - padding ||
+                         other.x + sizes[b][0] + padding <= rect.x - padding ||
+                         rect.y + sizes[a][1] + padding <= other.y - padding ||
+                         other.y + sizes[b][1] + padding <= rect.y - padding;
+      EXPECT_TRUE(apart) << a << " overlaps " << b;
+    }
+  }
+
+  // Edges are repeated into the padding
+  const std::vector<uint8_t> texels = {1, 2, 3, 4};
+  std::vector<uint8_t> page(8 * 8);
+  copyToPage(texels.data(), 2, 2, 1, {0, 3, 3}, 2, page.data(), 8, 8);
+  EXPECT_EQ(page[1 * 8 + 1], 1);
+  EXPECT_EQ(page[3 * 8 + 3], 1);
+  EXPECT_EQ(page[4 * 8 + 4], 4);
+  EXPECT_EQ(page[6 * 8 + 6], 4);
+  EXPECT_EQ(page[3 * 8 + 6], 2);
+  EXPECT_EQ(page[0], 0);
+  EXPECT_EQ(atlasMipLevels(4), 3);
+}
+
+TEST(FrameCaptureTest, ConvertsAndCountsFrames) {
+  using namespace tge::graphics;
+  const std::array<uint8_t, 8> bgra = {10, 20, 30, 0, 40, 50, 60, 7};
+  std::array<uint8_t, 8> rgba{};
+  ASSERT_TRUE(toRGBA8(bgra.data(), 2, 44, rgba.data()));
+  EXPECT_EQ(rgba, (std::array<uint8_t, 8>{30, 20, 10, 255, 60, 50, 40, 255}));
+  ASSERT_TRUE(toRGBA8(bgra.data(), 2, 37, rgba.data()));
+  EXPECT_EQ(rgba, (std::array<uint8_t, 8>{10, 20, 30, 255, 40, 50, 60, 255}));
+  EXPECT_FALSE(toRGBA8(bgra.data(), 2, 109, rgba.data()));
+
+  RateCounter counter;
+  EXPECT_EQ(counter.rate(), 0.0);
+  counter.add(0.0);
+  EXPECT_EQ(counter.rate(), 0.0);
+  for (int i = 1; i <= 30; i++) counter.add(i * 0.1);
+  // Only the last second counts, ten frames per second
+  EXPECT_NEAR(counter.rate(), 10.0, 1e-6);
+  counter.add(5.0);
+  EXPECT_NEAR(counter.rate(), 0.5, 1e-6);
+}
+
+TEST(RingAllocatorTest, WrapsAndReleasesInOrder) {
+  using namespace tge::graphics;
+  RingAllocator ring(100);
+  EXPECT_EQ(ring.allocate(0), INVALID_SIZE_T);
+  EXPECT_EQ(ring.allocate(101), INVALID_SIZE_T);
+  const auto first = ring.allocate(30);
+  const auto second = ring.allocate(30, 16);
+  const auto third = ring.allocate(30, 16);
+  EXPECT_EQ(first, 0);
+  EXPECT_EQ(second, 32);
+  EXPECT_EQ(third, 64);
+  EXPECT_EQ(ring.allocate(10), INVALID_SIZE_T);
+
+  // The second range is only freed together with the first one
+  ring.release(second);
+  EXPECT_EQ(ring.allocate(10), INVALID_SIZE_T);
+  ring.release(first);
+  EXPECT_EQ(ring.allocate(40), 0);
+  EXPECT_EQ(ring.allocate(24), 40);
+  EXPECT_EQ(ring.allocate(1), INVALID_SIZE_T);
+  ring.release(third);
+  EXPECT_EQ(ring.allocate(1), 64);
+  ring.release(0);
+  ring.release(40);
+  ring.release(64);
+  EXPECT_TRUE(ring.empty());
+  EXPECT_EQ(ring.allocate(100), 0);
+}
+
+TEST(TextureDiskCacheTest, RoundTripAndRejectStale) {
+  using namespace tge::graphics;
+  namespace fs = std::filesystem;
+  const auto directory = fs::temp_directory_path() / "TGETextureCacheTest";
+  fs::remove_all(directory);
+  fs::create_directories(directory);
+  const auto path = cachedTexturePath(directory, 0x1234, 0xABCD);
+  EXPECT_EQ(path.filename().string(),
+            "0000000000001234000000000000abcd.tgtex");
+
+  const std::vector<char> texels = {1, 2, 3, 4, 5, 6, 7, 8};
+  CachedTextureHeader header;
+  header.sourceHash = 0x1234;
+  header.settingsHash = 0xABCD;
+  header.format = 37;
+  header.size = texels.size();
+  header.width = 2;
+  header.height = 1;
+  header.channel = 4;
+  header.mipLevels = 1;
+  ASSERT_TRUE(writeCachedTexture(path, header, texels));
+  EXPECT_EQ(std::distance(fs::directory_iterator(directory),
+                          fs::directory_iterator()),
+            1);
+
+  std::ifstream input(path, std::ios::binary);
+  const std::vector<char> file((std::istreambuf_iterator<char>(input)),
+                               std::istreambuf_iterator<char>());
+  CachedTextureHeader read;
+  const auto data = readCachedTexture(file, 0x1234, 0xABCD, read);
+  ASSERT_EQ(data.size(), texels.size());
+  EXPECT_TRUE(std::equal(data.begin(), data.end(), texels.begin()));
+  EXPECT_EQ(read.width, 2u);
+  EXPECT_EQ(read.format, 37u);
+
+  // Other settings, other content and truncated files are misses
+  EXPECT_TRUE(readCachedTexture(file, 0x1234, 0xABCE, read).empty());
+  EXPECT_TRUE(readCachedTexture(file, 0x1235, 0xABCD, read).empty());
+  EXPECT_TRUE(
+      readCachedTexture(std::span(file).first(file.size() - 1), 0x1234, 0xABCD,
+                        read)
+          .empty());
+  fs::remove_all(directory);
+}
+
+TEST(TLSFAllocatorTest, AlignsSplitsAndMerges) {
+  using namespace tge::graphics;
+  constexpr size_t CAPACITY = 1 << 20;
+  TLSFAllocator allocator(CAPACITY);
+  EXPECT_TRUE(!allocator.allocate(0));
+  EXPECT_TRUE(!allocator.allocate(CAPACITY + 1));
+  EXPECT_TRUE(!allocator.allocate(16, 3));
+
+  std::mt19937 random(7);
+  std::vector<std::pair<TLSFAllocation, size_t>> live;
+  for (size_t step = 0; step < 4000; step++) {
+    if (live.empty() || random() % 3 != 0) {
+      const size_t size = 1 + random() % 8000;
+      const size_t alignment = (size_t)1 << (random() % 9);
+      const auto allocation = allocator.allocate(size, alignment);
+      if (!allocation) continue;
+      EXPECT_EQ(allocation.offset % alignment, 0u);
+      EXPECT_LE(allocation.offset + size, CAPACITY);
+      for (const auto& [other, otherSize] : live) {
+        EXPECT_TRUE(allocation.offset + size <= other.offset ||
+                    other.offset + otherSize <= allocation.offset);
+      }
+      live.emplace_back(allocation, size);
+    } else {
+      const auto index = random() % live.size();
+      allocator.free(live[index].first);
+      live.erase(live.begin() + index);
+    }
+  }
+  size_t used = 0;
+  for (const auto& entry : live) used += entry.second;
+  EXPECT_EQ(allocator.usedSize(), used);
+  EXPECT_EQ(allocator.allocationCount(), live.size());
+
+  for (const auto& entry : live) allocator.free(entry.first);
+  EXPECT_TRUE(allocator.empty());
+  // Everything was merged back into one range
+  EXPECT_EQ(allocator.largestFree(), CAPACITY);
+  const auto whole = allocator.allocate(CAPACITY);
+  ASSERT_FALSE(!whole);
+  EXPECT_EQ(whole.offset, 0u);
+  EXPECT_TRUE(!allocator.allocate(1));
+}
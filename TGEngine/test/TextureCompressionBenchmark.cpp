@@ -0,0 +1,122 @@
+// Block compresses every png of a directory in every format and prints the
+// speed and the quality of the first mip level,
+// usage: TGEngineCompressionBenchmark [directory] [repeats]
+#define STB_IMAGE_IMPLEMENTATION
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../public/WorkerPool.hpp"
+#include "../public/graphics/BlockCompression.hpp"
+#include "../public/headerlibs/stb_image.h"
+
+namespace fs = std::filesystem;
+using namespace tge::graphics;
+
+struct Image {
+  std::vector<uint8_t> rgba;
+  uint32_t width;
+  uint32_t height;
+};
+
+// Sum of the squared errors of every channel of the first mip level
+double squaredError(const Image& image, const CompressedTexture& texture,
+                    const size_t channels) {
+  const auto blocksX = (image.width + 3) / 4;
+  const auto blocksY = (image.height + 3) / 4;
+  const auto bytes = blockSize(texture.format);
+  std::array<uint8_t, 64> decoded;
+  double sum = 0.0;
+  for (uint32_t block = 0; block < blocksX * blocksY; block++) {
+    decodeBlock(texture.format, texture.data.data() + block * bytes,
+                decoded.data());
+    const auto blockX = (block % blocksX) * 4, blockY = (block / blocksX) * 4;
+    for (uint32_t i = 0; i < 16; i++) {
+      const auto x = blockX + i % 4, y = blockY + i / 4;
+      if (x >= image.width || y >= image.height) continue;
+      const auto texel = image.rgba.data() + ((size_t)y * image.width + x) * 4;
+      for (size_t c = 0; c < channels; c++) {
+        const double difference = decoded[i * 4 + c] - texel[c];
+        sum += difference * difference;
+      }
+    }
+  }
+  return sum;
+}
+
+// Peak signal to noise ratio over all images, lossless results are capped
+double psnr(const double squaredError, const double samples) {
+  const auto meanError = squaredError / samples;
+  if (meanError <= 0.0) return 99.0;
+  return std::min(10.0 * std::log10(255.0 * 255.0 / meanError), 99.0);
+}
+
+int main(int argc, char** argv) {
+  const fs::path directory = argc > 1 ? argv[1] : "assets/Test";
+  const size_t repeats = argc > 2 ? std::stoul(argv[2]) : 5;
+
+  std::vector<Image> images;
+  size_t pixels = 0;
+  for (const auto& entry : fs::directory_iterator(directory)) {
+    if (entry.path().extension() != ".png") continue;
+    int width, height, channel;
+    const auto data = stbi_load(entry.path().string().c_str(), &width, &height,
+                                &channel, 4);
+    if (data == nullptr) continue;
+    images.push_back({std::vector<uint8_t>(data, data + width * height * 4),
+                      (uint32_t)width, (uint32_t)height});
+    pixels += (size_t)width * height;
+    stbi_image_free(data);
+  }
+  if (images.empty()) {
+    std::cerr << "No png files found in " << directory << "!" << std::endl;
+    return -1;
+  }
+
+  tge::util::WorkerPool pool;
+  std::cout << images.size() << " images, " << pool.size() + 1 << " threads"
+            << std::endl;
+  const std::array formats = {
+      std::pair{BlockFormat::BC1, "BC1"}, std::pair{BlockFormat::BC3, "BC3"},
+      std::pair{BlockFormat::BC5, "BC5"}, std::pair{BlockFormat::BC7, "BC7"}};
+  for (const auto& [format, name] : formats) {
+    const size_t channels = format == BlockFormat::BC5   ? 2
+                            : format == BlockFormat::BC1 ? 3
+                                                         : 4;
+    for (uint32_t refinements = 0; refinements <= 2; refinements++) {
+      std::vector<CompressedTexture> textures;
+      const auto start = std::chrono::steady_clock::now();
+      for (size_t repeat = 0; repeat < repeats; repeat++) {
+        textures.clear();
+        for (const auto& image : images) {
+          textures.push_back(compressTexture(image.rgba.data(), image.width,
+                                             image.height, format, {},
+                                             refinements, &pool));
+        }
+      }
+      const std::chrono::duration<double> time =
+          std::chrono::steady_clock::now() - start;
+
+      // Errors are summed over all images before converting to decibels, so
+      // a lossless image doesn't turn the average into infinity
+      double error = 0.0;
+      size_t compressed = 0;
+      for (size_t i = 0; i < images.size(); i++) {
+        error += squaredError(images[i], textures[i], channels);
+        compressed += textures[i].data.size();
+      }
+      const auto quality = psnr(error, (double)pixels * channels);
+      // Uncompressed size of the same mip chains as RGBA8
+      const auto uncompressed = (double)pixels * 4.0 * 4.0 / 3.0;
+      std::cout << name << " refinements " << refinements << ": "
+                << pixels * repeats / time.count() / 1e6 << " MPixel/s, "
+                << quality << " dB PSNR, " << uncompressed / compressed
+                << "x smaller" << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,102 @@
+// Loads every png of a directory repeatedly through the engine's STBI path
+// with an increasing amount of threads, once per import setting, so format
+// conversion, mip generation, compression and the disk cache are measured
+// together with the decode, usage: TGEngineDecodeBenchmark [directory] [repeats]
+#define STB_IMAGE_IMPLEMENTATION
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Before the engine header, which only includes it if it is missing
+#include "../public/headerlibs/stb_image.h"
+#include "../private/graphics/TextureDecode.hpp"
+
+namespace fs = std::filesystem;
+using namespace tge::graphics;
+
+// All formats supported, as on a desktop GPU
+TextureFormats benchmarkFormats() {
+  constexpr auto undefined = vk::Format::eUndefined;
+  TextureFormats formats;
+  formats.unorm8 = {undefined, vk::Format::eR8Unorm, vk::Format::eR8G8Unorm,
+                    undefined, vk::Format::eR8G8B8A8Unorm};
+  formats.unorm16 = {undefined, vk::Format::eR16Unorm,
+                     vk::Format::eR16G16Unorm, undefined,
+                     vk::Format::eR16G16B16A16Unorm};
+  return formats;
+}
+
+int main(int argc, char** argv) {
+  const fs::path directory = argc > 1 ? argv[1] : "assets/Test";
+  const size_t repeats = argc > 2 ? std::stoul(argv[2]) : 20;
+
+  std::vector<TextureLoadInternal> files;
+  for (const auto& entry : fs::directory_iterator(directory)) {
+    if (entry.path().extension() != ".png") continue;
+    files.push_back({tge::util::wholeFile(entry.path()),
+                     entry.path().filename().string()});
+  }
+  if (files.empty()) {
+    std::cerr << "No png files found in " << directory << "!" << std::endl;
+    return -1;
+  }
+  std::vector<TextureLoadInternal> data;
+  std::vector<uint64_t> hashes;
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < files.size() * repeats; i++) {
+    const auto& file = files[i % files.size()];
+    data.push_back(file);
+    hashes.push_back(tge::util::hash64(file.textureInfo.data(),
+                                       file.textureInfo.size()));
+    indices.push_back(i);
+  }
+
+  const auto cacheDirectory =
+      fs::temp_directory_path() / "TGEngineDecodeBenchmark";
+  fs::create_directories(cacheDirectory);
+  const auto plain = benchmarkFormats();
+  auto mips = plain;
+  mips.cpuMips = true;
+  auto compressed = plain;
+  compressed.compression = BlockFormat::BC7;
+  // Filled before timing, so only cache hits are measured
+  auto cached = mips;
+  cached.cacheDirectory = cacheDirectory;
+  cached.settingsHash = textureSettingsHash(cached);
+  {
+    tge::util::WorkerPool pool;
+    loadSTBI(pool, data, hashes, indices, cached);
+  }
+
+  const std::array settings = {std::pair{&plain, "decode"},
+                               std::pair{&mips, "decode + mips"},
+                               std::pair{&compressed, "decode + BC7"},
+                               std::pair{&cached, "disk cache"}};
+  const size_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  std::cout << "loading " << indices.size() << " images" << std::endl;
+  for (const auto& [formats, name] : settings) {
+    double singleThreaded = 0.0;
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+      tge::util::WorkerPool pool(threads - 1);
+      const auto start = std::chrono::steady_clock::now();
+      size_t failed = 0;
+      {
+        const auto decoded = loadSTBI(pool, data, hashes, indices, *formats);
+        for (const auto& info : decoded.infos) failed += info.data == nullptr;
+      }
+      const std::chrono::duration<double> time =
+          std::chrono::steady_clock::now() - start;
+      if (threads == 1) singleThreaded = time.count();
+      std::cout << name << ", " << threads << " threads: " << time.count()
+                << "s, speedup " << singleThreaded / time.count();
+      if (failed != 0) std::cout << ", " << failed << " failed";
+      std::cout << std::endl;
+    }
+  }
+  fs::remove_all(cacheDirectory);
+  return 0;
+}